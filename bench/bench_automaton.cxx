@@ -0,0 +1,119 @@
+// The automaton headers define non-inline functions, so they may only be
+// included by this translation unit.
+
+#include <string>
+#include <memory>
+#include <random>
+#include <utility/pnfa/automaton.hxx>
+#include "benchmark.hxx"
+
+namespace
+{
+	using namespace utility::pnfa;
+	
+	enum class node
+		: ::std::size_t
+	{
+		start,
+		body,
+		end,
+		walk_0,
+		walk_1,
+		walk_2,
+		walk_3,
+		walk_4
+	};
+	
+	// Recognizes words of the form a b* c
+	auto make_matcher()
+		-> automaton<char>
+	{
+		automaton<char> t_automaton{ };
+		
+		t_automaton.add_start_node(node::start);
+		t_automaton.add_node(node::body);
+		t_automaton.add_accepting_node(node::end);
+		
+		t_automaton.add_edge(node::start, node::body, match('a'));
+		t_automaton.add_edge(node::body, node::body, match('b'));
+		t_automaton.add_edge(node::body, node::end, match('c'));
+		
+		return t_automaton;
+	}
+	
+	// Random walk on a line of nodes, which is accepted when reaching the last
+	// one. Every step requires sampling the probabilistic edges.
+	auto make_walk()
+		-> automaton<no_input>
+	{
+		automaton<no_input> t_automaton{ };
+		
+		t_automaton.add_start_node(node::walk_0);
+		t_automaton.add_nodes(node::walk_1, node::walk_2, node::walk_3);
+		t_automaton.add_accepting_node(node::walk_4);
+		
+		t_automaton.add_edge(node::walk_0, node::walk_1, probability(1.0));
+		
+		const node t_inner[] = { node::walk_1, node::walk_2, node::walk_3 };
+		
+		for(const auto t_node: t_inner)
+		{
+			const auto t_ix = static_cast<::std::size_t>(t_node);
+			
+			t_automaton.add_edge(t_node, static_cast<node>(t_ix + 1U), probability(0.6));
+			t_automaton.add_edge(t_node, static_cast<node>(t_ix - 1U), probability(0.4));
+		}
+		
+		return t_automaton;
+	}
+	
+	// Step the matcher through a stream of valid and invalid words
+	auto bench_step_input(bench::state& p_state)
+		-> void
+	{
+		auto t_automaton = make_matcher();
+		
+		::std::mt19937 t_gen{ 42U };
+		::std::uniform_int_distribution<int> t_symbol{ 0, 9 };
+		::std::string t_input{ };
+		
+		for(::std::size_t t_ix = 0; t_ix < 4096U; ++t_ix)
+		{
+			const auto t_value = t_symbol(t_gen);
+			t_input.push_back((t_value == 0) ? 'a' : ((t_value == 9) ? 'c' : ((t_value == 8) ? 'x' : 'b')));
+		}
+		
+		::std::size_t t_pos{ 0U };
+		
+		while(p_state.keep_running())
+		{
+			const auto t_result = t_automaton.step(t_input[t_pos]);
+			
+			if(t_result == automaton_result::accepted || t_result == automaton_result::rejected)
+				t_automaton.reset();
+			
+			t_pos = (t_pos + 1U) % t_input.size();
+		}
+		
+		p_state.set_items_processed(p_state.iterations());
+	}
+	
+	auto bench_step_probabilistic(bench::state& p_state)
+		-> void
+	{
+		auto t_automaton = make_walk();
+		
+		while(p_state.keep_running())
+		{
+			const auto t_result = t_automaton.step();
+			
+			if(t_result == automaton_result::accepted || t_result == automaton_result::rejected)
+				t_automaton.reset();
+		}
+		
+		p_state.set_items_processed(p_state.iterations());
+	}
+}
+
+ASCII_BENCHMARK("automaton/step_input", bench_step_input);
+ASCII_BENCHMARK("automaton/step_probabilistic", bench_step_probabilistic);
@@ -0,0 +1,133 @@
+#include <vector>
+#include <screen.hxx>
+#include "benchmark.hxx"
+
+namespace
+{
+	constexpr const ::std::size_t cell_count = 4096U;
+	
+	// Apply given setter to a row of cells, so the benchmark measures the
+	// setter and not a single store forwarded across iterations
+	template< typename F >
+	auto bench_setter(bench::state& p_state, F&& p_setter)
+		-> void
+	{
+		::std::vector<cell> t_cells(cell_count);
+		
+		while(p_state.keep_running())
+		{
+			for(::std::size_t t_ix = 0; t_ix < t_cells.size(); ++t_ix)
+				p_setter(t_cells[t_ix], t_ix);
+			
+			bench::clobber_memory();
+		}
+		
+		p_state.set_items_processed(p_state.iterations() * cell_count);
+	}
+	
+	auto bench_set_fg(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_fg(cell::integral_color_type{ p_ix & 0xFFU, 128U, 255U });
+		});
+	}
+	
+	auto bench_set_fg_float(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_fg(cell::float_color_type{ (p_ix & 0xFFU) / 255.f, 0.5f, 1.f });
+		});
+	}
+	
+	auto bench_set_bg(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_bg(cell::integral_color_type{ 255U, p_ix & 0xFFU, 0U });
+		});
+	}
+	
+	auto bench_set_glyph(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_glyph(static_cast<cell::glyph_type>(p_ix));
+		});
+	}
+	
+	auto bench_set_depth(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_depth(static_cast<cell::depth_type>(p_ix));
+		});
+	}
+	
+	auto bench_set_light_mode(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_light_mode((p_ix & 1U) ? light_mode::dim : light_mode::none);
+		});
+	}
+	
+	auto bench_set_gui_mode(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_gui_mode(p_ix & 1U);
+		});
+	}
+	
+	auto bench_set_glyph_set(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_glyph_set((p_ix & 1U) ? glyph_set::graphics : glyph_set::text);
+		});
+	}
+	
+	auto bench_set_shadows(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_shadows(static_cast<cell::shadow_type>((p_ix & 0xFFU) << 8U));
+		});
+	}
+	
+	// All setters a typical draw call uses, applied to the same cell
+	auto bench_set_all(bench::state& p_state)
+		-> void
+	{
+		bench_setter(p_state, [](cell& p_cell, ::std::size_t p_ix)
+		{
+			p_cell.set_fg(cell::integral_color_type{ p_ix & 0xFFU, 128U, 255U });
+			p_cell.set_bg(cell::integral_color_type{ 0U, 0U, p_ix & 0xFFU });
+			p_cell.set_glyph(static_cast<cell::glyph_type>(p_ix));
+			p_cell.set_glyph_set(glyph_set::text);
+			p_cell.set_depth(0U);
+		});
+	}
+}
+
+ASCII_BENCHMARK("cell/set_fg", bench_set_fg);
+ASCII_BENCHMARK("cell/set_fg_float", bench_set_fg_float);
+ASCII_BENCHMARK("cell/set_bg", bench_set_bg);
+ASCII_BENCHMARK("cell/set_glyph", bench_set_glyph);
+ASCII_BENCHMARK("cell/set_depth", bench_set_depth);
+ASCII_BENCHMARK("cell/set_light_mode", bench_set_light_mode);
+ASCII_BENCHMARK("cell/set_gui_mode", bench_set_gui_mode);
+ASCII_BENCHMARK("cell/set_glyph_set", bench_set_glyph_set);
+ASCII_BENCHMARK("cell/set_shadows", bench_set_shadows);
+ASCII_BENCHMARK("cell/set_all", bench_set_all);
@@ -0,0 +1,73 @@
+#include <string>
+#include <configuration.hxx>
+#include "benchmark.hxx"
+
+namespace
+{
+	// Populate configuration with given number of sibling entries in every
+	// section. Property tree lookups are linear in the number of siblings.
+	auto populate(configuration& p_config, ::std::size_t p_siblings)
+		-> void
+	{
+		auto& t_tree = p_config.tree();
+		
+		for(::std::size_t t_ix = 0; t_ix < p_siblings; ++t_ix)
+		{
+			t_tree.put("graphics.filler_" + ::std::to_string(t_ix), t_ix);
+			t_tree.put("section_" + ::std::to_string(t_ix) + ".value", t_ix);
+		}
+		
+		t_tree.put("graphics.width", 80U);
+		t_tree.put("graphics.height", 25U);
+		t_tree.put("graphics.tileset", ::std::string{ "default" });
+	}
+	
+	auto bench_get(bench::state& p_state)
+		-> void
+	{
+		configuration t_config{ };
+		populate(t_config, p_state.arg());
+		
+		while(p_state.keep_running())
+			bench::do_not_optimize(t_config.get<unsigned int>("graphics.width"));
+	}
+	
+	auto bench_get_string(bench::state& p_state)
+		-> void
+	{
+		configuration t_config{ };
+		populate(t_config, p_state.arg());
+		
+		while(p_state.keep_running())
+			bench::do_not_optimize(t_config.get<::std::string>("graphics.tileset"));
+	}
+	
+	// Lookup of an entry that does not exist in either tree
+	auto bench_get_missing(bench::state& p_state)
+		-> void
+	{
+		configuration t_config{ };
+		populate(t_config, p_state.arg());
+		
+		while(p_state.keep_running())
+			bench::do_not_optimize(t_config.get<unsigned int>("graphics.missing"));
+	}
+	
+	// Cached lookup through a configuration handle
+	auto bench_handle(bench::state& p_state)
+		-> void
+	{
+		configuration t_config{ };
+		populate(t_config, p_state.arg());
+		
+		const auto t_handle = t_config.handle<unsigned int>("graphics.width");
+		
+		while(p_state.keep_running())
+			bench::do_not_optimize(t_handle.get());
+	}
+}
+
+ASCII_BENCHMARK_ARGS("config/get", bench_get, 0, 16, 128);
+ASCII_BENCHMARK_ARGS("config/get_string", bench_get_string, 0, 16, 128);
+ASCII_BENCHMARK_ARGS("config/get_missing", bench_get_missing, 0, 16, 128);
+ASCII_BENCHMARK_ARGS("config/handle", bench_handle, 0, 16, 128);
@@ -0,0 +1,63 @@
+#include <process.hxx>
+#include <process_info.hxx>
+#include <process_manager.hxx>
+#include "benchmark.hxx"
+
+namespace
+{
+	// Process doing a trivial amount of work per time slice, so the benchmark
+	// measures the scheduling overhead
+	class counter_process
+		: public process
+	{
+		public:
+			counter_process(process_id p_id, process_id p_parent, process_type p_type, process_priority p_prio, const process_info& p_info, bool p_sleeps)
+				: process(p_id, p_parent, p_type, p_prio, p_info), m_Sleeps{p_sleeps}
+			{
+			}
+		
+		public:
+			auto initialize()
+				-> void override
+			{
+				if(m_Sleeps)
+					periodic_sleep(3U);
+			}
+			
+			auto update()
+				-> void override
+			{
+				++m_Count;
+				bench::do_not_optimize(m_Count);
+			}
+		
+		private:
+			bool m_Sleeps;
+			::std::size_t m_Count{0U};
+	};
+	
+	// Run one frame with the given number of processes. Priorities are spread
+	// out, and every fourth process sleeps periodically.
+	auto bench_frame(bench::state& p_state)
+		-> void
+	{
+		const auto t_count = static_cast<::std::size_t>(p_state.arg());
+		
+		process_manager t_manager{ };
+		const process_info t_info{ "bench", "benchmark process" };
+		
+		for(::std::size_t t_ix = 0; t_ix < t_count; ++t_ix)
+		{
+			const auto t_prio = static_cast<process_priority>((t_ix * 7919U) % 1000U);
+			
+			t_manager.create_process<counter_process>(no_process, process_type::per_frame, t_prio, t_info, (t_ix % 4U) == 0U);
+		}
+		
+		while(p_state.keep_running())
+			t_manager.frame();
+		
+		p_state.set_items_processed(p_state.iterations() * t_count);
+	}
+}
+
+ASCII_BENCHMARK_ARGS("process_manager/frame", bench_frame, 1, 16, 256, 4096);
@@ -0,0 +1,50 @@
+#include <random>
+#include <vector>
+#include <utility>
+#include <weighted_distribution.hxx>
+#include "benchmark.hxx"
+
+namespace
+{
+	// Sample from a distribution with the given number of entries of equal
+	// weight. The cost of a sample grows linearly with the entry count.
+	auto bench_weighted_distribution(bench::state& p_state)
+		-> void
+	{
+		const auto t_count = static_cast<::std::size_t>(p_state.arg());
+		
+		weighted_distribution<::std::size_t> t_distr{ };
+		
+		for(::std::size_t t_ix = 0; t_ix < t_count; ++t_ix)
+			t_distr.container().push_back({ t_ix, 1.f / t_count });
+		
+		::std::mt19937 t_gen{ 42U };
+		
+		while(p_state.keep_running())
+			bench::do_not_optimize(t_distr(t_gen));
+		
+		p_state.set_items_processed(p_state.iterations());
+	}
+	
+	// Typical use for background colors, with a few entries of uneven weight
+	auto bench_weighted_colors(bench::state& p_state)
+		-> void
+	{
+		weighted_distribution<unsigned> t_distr{
+			{ 0x202020U, 0.6f },
+			{ 0x303030U, 0.25f },
+			{ 0x404040U, 0.1f },
+			{ 0x505050U, 0.05f }
+		};
+		
+		::std::mt19937 t_gen{ 42U };
+		
+		while(p_state.keep_running())
+			bench::do_not_optimize(t_distr(t_gen));
+		
+		p_state.set_items_processed(p_state.iterations());
+	}
+}
+
+ASCII_BENCHMARK_ARGS("weighted_distribution/sample", bench_weighted_distribution, 2, 8, 64, 512);
+ASCII_BENCHMARK("weighted_distribution/colors", bench_weighted_colors);
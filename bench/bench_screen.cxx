@@ -0,0 +1,197 @@
+#include <random>
+#include <vector>
+#include <screen.hxx>
+#include <shapes.hxx>
+#include <actions.hxx>
+#include <capi/screen.h>
+#include "benchmark.hxx"
+
+namespace
+{
+	using position_type = screen_manager::position_type;
+	
+	const screen_manager::dimension_type screen_dims{ 160U, 60U };
+	const position_type screen_center{ 80U, 30U };
+	
+	// Screen with a few walls, so flood fill and field of view have to work
+	// around obstacles
+	auto make_screen(screen_manager& p_screen)
+		-> void
+	{
+		p_screen.initialize(screen_dims);
+		
+		p_screen.modify(line({ 20U, 5U }, { 20U, 50U }), draw(cell::glyph_type{ '#' }, { 255U, 255U, 255U }));
+		p_screen.modify(line({ 100U, 10U }, { 140U, 10U }), draw(cell::glyph_type{ '#' }, { 255U, 255U, 255U }));
+		p_screen.modify(rectangle({ 60U, 20U }, { 70U, 26U }), draw(cell::glyph_type{ '#' }, { 255U, 255U, 255U }));
+	}
+	
+	auto is_wall(const cell& p_cell)
+		-> bool
+	{
+		return p_cell.glyph() == '#';
+	}
+	
+	auto is_floor(const cell& p_cell)
+		-> bool
+	{
+		return !is_wall(p_cell);
+	}
+	
+	// Create a shape using given factory on every iteration, and apply a draw
+	// action to it. Shapes that analyze the screen on creation are therefore
+	// measured including that analysis.
+	template< typename F >
+	auto bench_shape(bench::state& p_state, F&& p_factory)
+		-> void
+	{
+		screen_manager t_screen{ };
+		make_screen(t_screen);
+		
+		const auto t_action = sequence(draw(cell::glyph_type{ '.' }, { 200U, 200U, 200U }, { 10U, 10U, 10U }), set_depth(2U));
+		
+		while(p_state.keep_running())
+		{
+			t_screen.modify(p_factory(t_screen), t_action);
+			bench::do_not_optimize(t_screen.read_cell(screen_center));
+		}
+	}
+	
+	auto bench_point(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return point(screen_center); });
+	}
+	
+	auto bench_area(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return area({ 10U, 10U }, { 149U, 49U }); });
+	}
+	
+	auto bench_rectangle(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return rectangle({ 10U, 10U }, { 149U, 49U }); });
+	}
+	
+	auto bench_line(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return line({ 0U, 0U }, { 159U, 59U }); });
+	}
+	
+	auto bench_filled_circle(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return filled_circle(screen_center, 25U); });
+	}
+	
+	auto bench_circle(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return circle(screen_center, 25U); });
+	}
+	
+	auto bench_filled_ellipse(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return filled_ellipse(screen_center, { 60U, 25U }); });
+	}
+	
+	auto bench_ellipse(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager&) { return ellipse(screen_center, { 60U, 25U }); });
+	}
+	
+	auto bench_convex_polygon(bench::state& p_state)
+		-> void
+	{
+		const ::std::vector<position_type> t_vertices{ { 80U, 2U }, { 150U, 30U }, { 80U, 57U }, { 10U, 30U } };
+		
+		bench_shape(p_state, [&t_vertices](const screen_manager&) { return convex_polygon(t_vertices); });
+	}
+	
+	auto bench_flood_fill(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager& p_screen) { return flood_fill(p_screen, { 40U, 30U }, is_floor); });
+	}
+	
+	auto bench_field_of_view(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager& p_screen) { return field_of_view(p_screen, { 40U, 30U }, 30U, is_wall); });
+	}
+	
+	auto bench_view_cone(bench::state& p_state)
+		-> void
+	{
+		bench_shape(p_state, [](const screen_manager& p_screen)
+		{
+			return view_cone(p_screen, { 40U, 30U }, 30U, { 1.f, 0.f }, 1.5f, is_wall);
+		});
+	}
+	
+	// Random command buffer as a scripting client would submit it. The argument
+	// is the number of commands per call.
+	auto bench_apply_commands(bench::state& p_state)
+		-> void
+	{
+		const auto t_count = static_cast<int>(p_state.arg());
+		
+		::std::mt19937 t_gen{ 42U };
+		::std::uniform_int_distribution<::std::uint32_t> t_x{ 0U, screen_dims.x - 1U };
+		::std::uniform_int_distribution<::std::uint32_t> t_y{ 0U, screen_dims.y - 1U };
+		::std::uniform_int_distribution<::std::uint32_t> t_byte{ 0U, 255U };
+		
+		const command_type_t t_types[] = { CMD_SET_GLYPH, CMD_SET_FG, CMD_SET_BG, CMD_SET_DEPTH };
+		
+		::std::vector<command_t> t_commands(t_count);
+		
+		for(int t_ix = 0; t_ix < t_count; ++t_ix)
+		{
+			auto& t_cmd = t_commands[t_ix];
+			
+			t_cmd.type = t_types[t_ix % 4];
+			t_cmd.position = uvec2_t{ t_x(t_gen), t_y(t_gen) };
+			
+			if(t_cmd.type == CMD_SET_FG || t_cmd.type == CMD_SET_BG)
+				t_cmd.color = uvec3_t{ t_byte(t_gen), t_byte(t_gen), t_byte(t_gen) };
+			else
+				t_cmd.value = t_byte(t_gen);
+		}
+		
+		// Use a layer of its own, which only requires the render manager object
+		// and no GL context
+		uvec2_t t_dims{ screen_dims.x, screen_dims.y };
+		ivec2_t t_offset{ 0, 0 };
+		
+		const auto t_layer = screen_create_layer(&t_dims, &t_offset, 0);
+		screen_select_layer(t_layer);
+		
+		while(p_state.keep_running())
+			screen_apply_commands(t_commands.data(), t_count);
+		
+		// Destroying the active layer selects the base layer again. Selecting it
+		// explicitly would fail, since the base layer only exists once the render
+		// manager is initialized.
+		screen_destroy_layer(t_layer);
+		
+		p_state.set_items_processed(p_state.iterations() * t_commands.size());
+	}
+}
+
+ASCII_BENCHMARK("screen/modify/point", bench_point);
+ASCII_BENCHMARK("screen/modify/area", bench_area);
+ASCII_BENCHMARK("screen/modify/rectangle", bench_rectangle);
+ASCII_BENCHMARK("screen/modify/line", bench_line);
+ASCII_BENCHMARK("screen/modify/filled_circle", bench_filled_circle);
+ASCII_BENCHMARK("screen/modify/circle", bench_circle);
+ASCII_BENCHMARK("screen/modify/filled_ellipse", bench_filled_ellipse);
+ASCII_BENCHMARK("screen/modify/ellipse", bench_ellipse);
+ASCII_BENCHMARK("screen/modify/convex_polygon", bench_convex_polygon);
+ASCII_BENCHMARK("screen/modify/flood_fill", bench_flood_fill);
+ASCII_BENCHMARK("screen/modify/field_of_view", bench_field_of_view);
+ASCII_BENCHMARK("screen/modify/view_cone", bench_view_cone);
+ASCII_BENCHMARK_ARGS("screen/apply_commands", bench_apply_commands, 64, 1024, 16384);
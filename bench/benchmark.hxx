@@ -0,0 +1,182 @@
+// Minimal microbenchmark harness used by the ascii_bench target.
+//
+// Benchmarks are registered at static initialization time using the
+// ASCII_BENCHMARK macros and run by the driver in main.cxx. A benchmark is a
+// function that loops while `keep_running()` returns true, and only the time
+// spent inside that loop is measured:
+//
+//	auto bench_example(bench::state& p_state)
+//		-> void
+//	{
+//		// Setup is not measured
+//		while(p_state.keep_running())
+//			bench::do_not_optimize(work());
+//	}
+//	ASCII_BENCHMARK("example/work", bench_example);
+//
+// Benchmarks registered with arguments are run once per argument, which is
+// available through `arg()`.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+
+namespace bench
+{
+	class state
+	{
+		using clock_type = ::std::chrono::steady_clock;
+		
+		public:
+			using size_type = ::std::size_t;
+			using arg_type = ::std::int64_t;
+			using duration_type = ::std::chrono::nanoseconds;
+		
+		public:
+			state(size_type p_iterations, arg_type p_arg)
+				:	m_Iterations{p_iterations},
+					m_Remaining{p_iterations},
+					m_Arg{p_arg}
+			{
+			}
+		
+		public:
+			// Returns true until the requested number of iterations was run.
+			// Timing starts with the first call.
+			auto keep_running()
+				-> bool
+			{
+				if(!m_Started)
+				{
+					m_Started = true;
+					m_Begin = clock_type::now();
+				}
+				
+				if(m_Remaining == 0U)
+				{
+					if(!m_Paused)
+						m_Elapsed += clock_type::now() - m_Begin;
+					
+					m_Paused = true;
+					return false;
+				}
+				
+				--m_Remaining;
+				return true;
+			}
+			
+			// Exclude following work from measurement, like per-iteration setup
+			auto pause_timing()
+				-> void
+			{
+				if(m_Paused)
+					return;
+				
+				m_Elapsed += clock_type::now() - m_Begin;
+				m_Paused = true;
+			}
+			
+			auto resume_timing()
+				-> void
+			{
+				if(!m_Paused)
+					return;
+				
+				m_Begin = clock_type::now();
+				m_Paused = false;
+			}
+			
+			// Number of items, like cells or commands, processed in total. Used to
+			// report throughput.
+			auto set_items_processed(size_type p_items)
+				-> void
+			{
+				m_Items = p_items;
+			}
+		
+		public:
+			auto arg() const
+				-> arg_type
+			{
+				return m_Arg;
+			}
+			
+			auto iterations() const
+				-> size_type
+			{
+				return m_Iterations;
+			}
+			
+			auto items_processed() const
+				-> size_type
+			{
+				return m_Items;
+			}
+			
+			auto elapsed() const
+				-> duration_type
+			{
+				return ::std::chrono::duration_cast<duration_type>(m_Elapsed);
+			}
+		
+		private:
+			size_type m_Iterations;
+			size_type m_Remaining;
+			arg_type m_Arg;
+			size_type m_Items{0U};
+			bool m_Started{false};
+			bool m_Paused{false};
+			clock_type::time_point m_Begin{ };
+			clock_type::duration m_Elapsed{ };	//< Measured time so far
+	};
+	
+	using function_type = ::std::function<void(state&)>;
+	
+	struct benchmark_case
+	{
+		::std::string m_Name;
+		function_type m_Function;
+		::std::vector<state::arg_type> m_Args;	//< Arguments to run with. Empty if the benchmark takes none.
+	};
+	
+	// All registered benchmarks, in registration order
+	auto registry()
+		-> ::std::vector<benchmark_case>&;
+	
+	struct registrar
+	{
+		registrar(::std::string p_name, function_type p_function, ::std::initializer_list<state::arg_type> p_args = { });
+	};
+	
+	// Prevent the compiler from optimizing away computation of given value
+	template< typename T >
+	inline auto do_not_optimize(const T& p_value)
+		-> void
+	{
+		asm volatile("" : : "g"(&p_value) : "memory");
+	}
+	
+	// Force all pending writes to memory to be considered observable
+	inline auto clobber_memory()
+		-> void
+	{
+		asm volatile("" : : : "memory");
+	}
+}
+
+#define ASCII_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define ASCII_BENCHMARK_CONCAT(a, b) ASCII_BENCHMARK_CONCAT_IMPL(a, b)
+
+// Register given function as benchmark with given name
+#define ASCII_BENCHMARK(name, fn) \
+	static const ::bench::registrar ASCII_BENCHMARK_CONCAT(g_BenchRegistrar, __LINE__){ name, fn }
+
+// Register given function as benchmark, run once for every given argument
+#define ASCII_BENCHMARK_ARGS(name, fn, ...) \
+	static const ::bench::registrar ASCII_BENCHMARK_CONCAT(g_BenchRegistrar, __LINE__){ name, fn, { __VA_ARGS__ } }
@@ -0,0 +1,206 @@
+// Driver for the ascii_bench microbenchmarks. Runs without a window or GL
+// context.
+//
+// Usage: ascii_bench [--filter <substring>] [--min-time <ms>] [--repetitions <n>] [--csv]
+//
+// Every benchmark is first calibrated to run for at least the minimum time,
+// and then repeated the given number of times. The median and minimum time
+// per iteration over all repetitions are reported.
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include "benchmark.hxx"
+
+namespace bench
+{
+	auto registry()
+		-> ::std::vector<benchmark_case>&
+	{
+		static ::std::vector<benchmark_case> t_registry{ };
+		return t_registry;
+	}
+	
+	registrar::registrar(::std::string p_name, function_type p_function, ::std::initializer_list<state::arg_type> p_args)
+	{
+		registry().push_back(benchmark_case{ ::std::move(p_name), ::std::move(p_function), p_args });
+	}
+}
+
+namespace
+{
+	struct options
+	{
+		::std::string m_Filter{ };
+		double m_MinTime{ 200.0 };		//< Minimum measured time per repetition, in ms
+		::std::size_t m_Repetitions{ 5U };
+		bool m_Csv{ false };
+	};
+	
+	struct result
+	{
+		::std::string m_Name;
+		::std::size_t m_Iterations;
+		double m_Median;		//< Median time per iteration, in ns
+		double m_Min;			//< Minimum time per iteration, in ns
+		double m_ItemRate;		//< Items per second based on the median, or zero
+	};
+	
+	auto parse(int p_argc, char** p_argv)
+		-> options
+	{
+		options t_options{ };
+		
+		for(int t_ix = 1; t_ix < p_argc; ++t_ix)
+		{
+			const ::std::string t_arg{ p_argv[t_ix] };
+			
+			const auto t_value = [&]() -> const char*
+			{
+				if(t_ix + 1 >= p_argc)
+					throw ::std::runtime_error("missing value for \"" + t_arg + "\"");
+				
+				return p_argv[++t_ix];
+			};
+			
+			if(t_arg == "--filter")
+				t_options.m_Filter = t_value();
+			else if(t_arg == "--min-time")
+				t_options.m_MinTime = ::std::strtod(t_value(), nullptr);
+			else if(t_arg == "--repetitions")
+				t_options.m_Repetitions = ::std::max<::std::size_t>(1U, ::std::strtoul(t_value(), nullptr, 10));
+			else if(t_arg == "--csv")
+				t_options.m_Csv = true;
+			else
+				throw ::std::runtime_error("unknown argument \"" + t_arg + "\"");
+		}
+		
+		return t_options;
+	}
+	
+	auto run_once(const bench::benchmark_case& p_case, ::std::size_t p_iterations, bench::state::arg_type p_arg)
+		-> bench::state
+	{
+		bench::state t_state{ p_iterations, p_arg };
+		p_case.m_Function(t_state);
+		
+		return t_state;
+	}
+	
+	// Determine number of iterations needed to reach the minimum time
+	auto calibrate(const bench::benchmark_case& p_case, bench::state::arg_type p_arg, double p_minTime)
+		-> ::std::size_t
+	{
+		::std::size_t t_iterations{ 1U };
+		
+		while(true)
+		{
+			const auto t_state = run_once(p_case, t_iterations, p_arg);
+			const auto t_elapsed = static_cast<double>(t_state.elapsed().count()) / 1e6;
+			
+			if(t_elapsed >= p_minTime || t_iterations >= (::std::size_t{ 1U } << 40U))
+				return t_iterations;
+			
+			// Aim slightly above the minimum time, but grow by at most 10x per step
+			// to not overshoot on noisy first measurements
+			const auto t_factor = (t_elapsed > 0.0) ? ::std::min(10.0, 1.4 * p_minTime / t_elapsed) : 10.0;
+			t_iterations = ::std::max(t_iterations + 1U, static_cast<::std::size_t>(t_iterations * t_factor));
+		}
+	}
+	
+	auto run(const bench::benchmark_case& p_case, ::std::string p_name, bench::state::arg_type p_arg, const options& p_options)
+		-> result
+	{
+		const auto t_iterations = calibrate(p_case, p_arg, p_options.m_MinTime);
+		
+		::std::vector<double> t_times{ };
+		::std::size_t t_items{ 0U };
+		
+		for(::std::size_t t_rep = 0; t_rep < p_options.m_Repetitions; ++t_rep)
+		{
+			const auto t_state = run_once(p_case, t_iterations, p_arg);
+			
+			t_times.push_back(static_cast<double>(t_state.elapsed().count()) / t_iterations);
+			t_items = t_state.items_processed();
+		}
+		
+		::std::sort(t_times.begin(), t_times.end());
+		
+		const auto t_median = t_times[t_times.size() / 2U];
+		const auto t_perIteration = static_cast<double>(t_items) / t_iterations;
+		
+		return result{
+			::std::move(p_name),
+			t_iterations,
+			t_median,
+			t_times.front(),
+			(t_items > 0U && t_median > 0.0) ? (t_perIteration * 1e9 / t_median) : 0.0
+		};
+	}
+	
+	auto print(const result& p_result, bool p_csv)
+		-> void
+	{
+		if(p_csv)
+		{
+			::std::printf("%s,%zu,%.2f,%.2f,%.0f\n", p_result.m_Name.c_str(), p_result.m_Iterations,
+				p_result.m_Median, p_result.m_Min, p_result.m_ItemRate);
+		}
+		else
+		{
+			::std::printf("%-48s %12zu %14.2f %14.2f", p_result.m_Name.c_str(), p_result.m_Iterations,
+				p_result.m_Median, p_result.m_Min);
+			
+			if(p_result.m_ItemRate > 0.0)
+				::std::printf(" %14.3e", p_result.m_ItemRate);
+			
+			::std::printf("\n");
+		}
+		
+		::std::fflush(stdout);
+	}
+}
+
+int main(int p_argc, char** p_argv)
+{
+	try
+	{
+		const auto t_options = parse(p_argc, p_argv);
+		
+		if(t_options.m_Csv)
+			::std::printf("name,iterations,median_ns,min_ns,items_per_second\n");
+		else
+			::std::printf("%-48s %12s %14s %14s %14s\n", "benchmark", "iterations", "median ns", "min ns", "items/s");
+		
+		for(const auto& t_case: bench::registry())
+		{
+			// Benchmarks without arguments are run once with argument zero
+			const auto t_args = t_case.m_Args.empty() ? ::std::vector<bench::state::arg_type>{ 0 } : t_case.m_Args;
+			
+			for(const auto t_arg: t_args)
+			{
+				auto t_name = t_case.m_Name;
+				
+				if(!t_case.m_Args.empty())
+					t_name += "/" + ::std::to_string(t_arg);
+				
+				if(!t_options.m_Filter.empty() && t_name.find(t_options.m_Filter) == ::std::string::npos)
+					continue;
+				
+				print(run(t_case, ::std::move(t_name), t_arg, t_options), t_options.m_Csv);
+			}
+		}
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		::std::fprintf(stderr, "ascii_bench: %s\n", p_ex.what());
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}
@@ -1,10 +1,14 @@
-// TODO: put_string_fmt (with color formatting! %C)
 // TODO: draw(...) with libcl-like tags for foreground, background, glyph and glyph_set!
 //		 => that is good because no order has to be memorized and we can easily SUPPORT DEFAULT VALUES
 
 #pragma once
+#include <array>
 #include <cctype>
 #include <limits>
+#include <memory>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
 #include <string_view>
 #include <algorithm>
 #include <string_view>
@@ -14,11 +18,78 @@
 
 #include "screen.hxx"
 #include "shapes.hxx"
+#include "text_layout.hxx"
 
 
 // TODO: fog, shadows
 namespace internal
 {
+	// An action that assigns a fixed set of bits of a cell. Any sequence of
+	// these is fused into a single one when it is created, which is then applied
+	// to every cell as one masked store over the whole cell.
+	struct masked_write
+	{
+		// A cell viewed as its eight 32 bit words: front color, glyph data,
+		// back color and cell data
+		using word_array = ::std::array<::std::uint32_t, 8>;
+		
+		static constexpr ::std::size_t front_word = 0U;
+		static constexpr ::std::size_t glyph_word = 3U;
+		static constexpr ::std::size_t back_word = 4U;
+		static constexpr ::std::size_t data_word = 7U;
+		
+		word_array m_Mask{ };	//< Bits assigned by this action
+		word_array m_Value{ };	//< Values of the assigned bits
+		
+		// Assign given bits of a single word
+		auto assign(::std::size_t p_word, ::std::uint32_t p_mask, ::std::uint32_t p_value)
+			-> masked_write&
+		{
+			m_Mask[p_word] |= p_mask;
+			m_Value[p_word] = (m_Value[p_word] & ~p_mask) | (p_value & p_mask);
+			return *this;
+		}
+		
+		auto assign_color(::std::size_t p_word, const cell::integral_color_type& p_clr)
+			-> masked_write&
+		{
+			for(::std::size_t t_ix = 0; t_ix < 3; ++t_ix)
+				assign(p_word + t_ix, ~0U, p_clr[t_ix]);
+				
+			return *this;
+		}
+		
+		// Combine with an action that is applied afterwards
+		auto then(const masked_write& p_next) const
+			-> masked_write
+		{
+			masked_write t_result{ };
+			
+			for(::std::size_t t_ix = 0; t_ix < t_result.m_Mask.size(); ++t_ix)
+			{
+				t_result.m_Mask[t_ix] = m_Mask[t_ix] | p_next.m_Mask[t_ix];
+				t_result.m_Value[t_ix] = (m_Value[t_ix] & ~p_next.m_Mask[t_ix]) | p_next.m_Value[t_ix];
+			}
+			
+			return t_result;
+		}
+		
+		void operator()(cell& p_cell) const
+		{
+			// Operating on the whole cell at once allows the compiler to
+			// vectorize this into a single blend
+			word_array t_words;
+			::std::memcpy(t_words.data(), &p_cell, sizeof(cell));
+			
+			for(::std::size_t t_ix = 0; t_ix < t_words.size(); ++t_ix)
+				t_words[t_ix] = (t_words[t_ix] & ~m_Mask[t_ix]) | m_Value[t_ix];
+				
+			::std::memcpy(&p_cell, t_words.data(), sizeof(cell));
+		}
+	};
+	
+	static_assert(sizeof(masked_write::word_array) == sizeof(cell), "masked_write: word array does not match cell layout");
+
 	struct draw_parameters
 	{
 		cell::integral_color_type m_Foreground{255U, 255U, 255U};
@@ -67,13 +138,15 @@ using max_length =  internal::tag_base<
 
 static auto draw(const internal::draw_parameters& p_params)
 {
-	return [p_params](cell& p_cell) -> void
-	{
-		p_cell.set_fg(p_params.m_Foreground);
-		p_cell.set_bg(p_params.m_Background);
-		p_cell.set_glyph(p_params.m_Glyph);
-		p_cell.set_glyph_set(p_params.m_GlyphSet);
-	};
+	using namespace internal;
+	
+	masked_write t_write{ };
+	t_write.assign_color(masked_write::front_word, p_params.m_Foreground);
+	t_write.assign_color(masked_write::back_word, p_params.m_Background);
+	t_write.assign(masked_write::glyph_word, glyph_mask | glyph_set_mask,
+		p_params.m_Glyph | (ut::enum_cast(p_params.m_GlyphSet) << glyph_set_shift));
+		
+	return t_write;
 }
 
 template< 	typename... Ts,
@@ -96,22 +169,36 @@ auto draw(Ts... p_tags)
 	return draw(t_params);
 }
 
+// Apply all given actions in order. If all of them are masked writes, they
+// are fused into a single masked write.
 template< typename... Ts >
 auto sequence(Ts&&... p_funcs)
 {
-	return [p_funcs...](cell& p_cell) -> void
+	if constexpr((sizeof...(Ts) > 0) && ::std::conjunction_v<::std::is_same<::std::decay_t<Ts>, internal::masked_write>...>)
 	{
-		const auto t_x = { (p_funcs(p_cell), 0)... };
-		(void)t_x;
-	};
+		internal::masked_write t_result{ };
+		((t_result = t_result.then(p_funcs)), ...);
+		
+		return t_result;
+	}
+	else
+	{
+		return [p_funcs...](cell& p_cell) -> void
+		{
+			const auto t_x = { (p_funcs(p_cell), 0)... };
+			(void)t_x;
+		};
+	}
 }
 
 static auto clear()
 {
-	return [](cell& p_cell) -> void
-	{
-		p_cell = cell{ };
-	};
+	internal::masked_write t_write{ };
+	
+	for(::std::size_t t_ix = 0; t_ix < t_write.m_Mask.size(); ++t_ix)
+		t_write.assign(t_ix, ~0U, 0U);
+		
+	return t_write;
 }
 
 template< typename Tdistr, typename Tgen >
@@ -125,14 +212,15 @@ auto sample_background(Tdistr& p_distribution, Tgen& p_generator)
 
 static auto put_string(::std::string_view p_str, internal::draw_parameters p_params)
 {
+	// Only printable ascii chars are allowed. This is checked once for the whole
+	// string instead of for every cell.
+	if(!::std::all_of(p_str.begin(), p_str.end(), [](char c) { return ::std::isprint(static_cast<unsigned char>(c)); }))
+		throw ::std::runtime_error("put_string: Encountered non-printable character!");
+	
 	return [=](cell& p_cell) mutable
 	{
 		if(p_str.length() > 0)
 		{
-			// Only printable ascii chars are allowed.
-			if(! ::std::isprint(p_str.front()))
-				throw ::std::runtime_error("put_string: Encountered non-printable character!");
-			
 			// Since the character is printable, just converting it to a glyph is valid
 			p_params.m_Glyph = p_str.front();
 			
@@ -167,44 +255,42 @@ static auto put_string(::std::string_view p_str, Ts... p_tags)
 
 static auto draw(cell::glyph_type p_glyph, cell::integral_color_type p_front, cell::integral_color_type p_back = { })
 {
-	return [p_glyph, p_front, p_back](cell& p_cell)
-	{
-		p_cell.set_fg(p_front);
-		p_cell.set_bg(p_back);
-		p_cell.set_glyph(p_glyph);
-	};
+	using namespace internal;
+	
+	masked_write t_write{ };
+	t_write.assign_color(masked_write::front_word, p_front);
+	t_write.assign_color(masked_write::back_word, p_back);
+	t_write.assign(masked_write::glyph_word, glyph_mask, p_glyph);
+	
+	return t_write;
 }
 
 static auto set_light_mode(light_mode p_mode)
 {
-	return [p_mode](cell& p_cell)
-	{
-		p_cell.set_light_mode(p_mode);
-	};
+	using namespace internal;
+	
+	return masked_write{ }.assign(masked_write::data_word, light_mode_mask, ut::enum_cast(p_mode) << light_mode_shift);
 }
 
 static auto set_depth(cell::depth_type p_depth)
 {
-	return [p_depth](cell& p_cell)
-	{
-		p_cell.set_depth(p_depth);
-	};
+	using namespace internal;
+	
+	return masked_write{ }.assign(masked_write::data_word, depth_mask, p_depth);
 }
 
 static auto set_gui_mode(bool p_flag)
 {
-	return [p_flag](cell& p_cell)
-	{
-		p_cell.set_gui_mode(p_flag);
-	};
+	using namespace internal;
+	
+	return masked_write{ }.assign(masked_write::data_word, gui_mode_bit, p_flag ? gui_mode_bit : 0U);
 }
 
 static auto set_glyph_set(glyph_set p_set)
 {
-	return [p_set](cell& p_cell)
-	{
-		p_cell.set_glyph_set(p_set);
-	};
+	using namespace internal;
+	
+	return masked_write{ }.assign(masked_write::glyph_word, glyph_set_mask, ut::enum_cast(p_set) << glyph_set_shift);
 }
 
 template<	typename... Ts,
@@ -222,10 +308,7 @@ auto set_shadows(Ts... p_args)
 		t_lst.begin(), t_lst.end(), ::std::uint32_t{}, [](const auto& p_a, const auto& p_b) { return p_a | p_b; }
 	);
 
-	return [t_value](cell& p_cell)
-	{
-		p_cell.set_shadows(t_value);
-	};
+	return internal::masked_write{ }.assign(internal::masked_write::data_word, internal::drop_shadow_mask, t_value);
 }
 
 template<	typename... Ts,
@@ -243,10 +326,8 @@ auto add_shadows(Ts... p_args)
 		t_lst.begin(), t_lst.end(), ::std::uint32_t{}, [](const auto& p_a, const auto& p_b) { return p_a | p_b; }
 	);
 
-	return [t_value](cell& p_cell)
-	{
-		p_cell.set_shadows(p_cell.shadows() | t_value);
-	};
+	// Setting only the given bits leaves all other shadows untouched
+	return internal::masked_write{ }.assign(internal::masked_write::data_word, t_value, t_value);
 }
 
 static auto highlight()
@@ -336,6 +417,25 @@ auto draw_border(const screen_manager::position_type& p_tl, const screen_manager
 }
 
 
+// Draw already laid out text with the top left corner of its box at given
+// position. Text outside of the screen is clipped.
+static auto draw_text(const screen_manager::position_type& p_pos, ::std::shared_ptr<const text_layout> p_layout)
+{
+	return [=](screen_manager& p_screen)
+	{
+		p_layout->blit(p_screen, p_pos);
+	};
+}
+
+// Lay out formatted text and draw it at given position. See text_layout.hxx
+// for the supported markup. Layouts are taken from the shared layout cache, so
+// text that is drawn every frame is only laid out once.
+static auto draw_text(const screen_manager::position_type& p_pos, ::std::string_view p_str, const text_layout_params& p_params = { })
+{
+	return draw_text(p_pos, text_layout_cache::shared().get(p_str, p_params));
+}
+
+
 template<	typename... Ts,
 			typename = ::std::enable_if_t<
 				::std::conjunction_v<
@@ -353,12 +453,15 @@ auto draw_string(const screen_manager::position_type& p_pos, ::std::string_view
 	if constexpr(sizeof...(Ts) > 0)
 		auto x = { (p_tags.apply(t_params), 0)... };
 	
-	const auto t_len = ::std::min(p_str.length(), t_params.m_MaxLen);
-	
-	const screen_manager::position_type t_endPos{ p_pos.x + t_len, p_pos.y };
+	// Plain strings are laid out without markup and wrapping, clipped to the
+	// maximum length
+	text_layout_params t_layoutParams{ };
+	t_layoutParams.m_Box = { static_cast<unsigned>(::std::min<::std::size_t>(t_params.m_MaxLen, ::std::numeric_limits<unsigned>::max())), 1U };
+	t_layoutParams.m_Wrap = text_wrap::none;
+	t_layoutParams.m_Markup = false;
+	t_layoutParams.m_Foreground = t_params.m_Foreground;
+	t_layoutParams.m_Background = t_params.m_Background;
+	t_layoutParams.m_GlyphSet = t_params.m_GlyphSet;
 	
-	return [=](screen_manager& p_screen)
-	{
-		p_screen.modify(line(p_pos, t_endPos), put_string(p_str, t_params));
-	};		
+	return draw_text(p_pos, text_layout_cache::shared().get(p_str, t_layoutParams));
 }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <boost/filesystem/operations.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <file_stamp.hxx>
+#include "config_scheme.hxx"
+
+namespace application_layer::config
+{
+	// A validated binary snapshot of the fully resolved configuration state,
+	// consisting of the configuration scheme and the bounds-checked data tree.
+	// It is keyed by stamps of the scheme file and the user configuration file,
+	// and thus only valid as long as neither of those files changed.
+	//
+	// Loading a snapshot memory-maps the cache file and decodes it directly,
+	// which avoids parsing the JSON scheme and configuration documents on
+	// every start.
+	class config_snapshot
+	{
+		using tree_type = boost::property_tree::ptree;
+		using path_type = boost::filesystem::path;
+		
+		public:
+			// Magic number and format version of the binary snapshot file.
+			// The version has to be incremented every time the layout changes.
+			static constexpr ::std::uint64_t magic = 0x504E534746435341ULL; // "ASCFGSNP"
+			static constexpr ::std::uint32_t version = 1U;
+	
+		public:
+			// Create snapshot from already resolved configuration state
+			config_snapshot(const config_scheme& p_scheme, const tree_type& p_tree,
+			                const file_stamp& p_schemeStamp, const file_stamp& p_configStamp);
+		
+			// Load snapshot from given cache file. Throws if the file does not exist
+			// or is malformed.
+			explicit config_snapshot(const path_type& p_path);
+			
+		public:
+			config_snapshot(const config_snapshot&) = default;
+			config_snapshot(config_snapshot&&) = default;
+			
+			config_snapshot& operator=(const config_snapshot&) = default;
+			config_snapshot& operator=(config_snapshot&&) = default;
+			
+		public:
+			// Write snapshot to given cache file
+			auto save(const path_type& p_path) const
+				-> void;
+				
+			// Check whether this snapshot was created from the given versions
+			// of the scheme and configuration files
+			auto is_valid_for(const file_stamp& p_schemeStamp, const file_stamp& p_configStamp) const
+				-> bool;
+				
+		public:
+			auto scheme() const
+				-> const config_scheme&;
+				
+			auto tree() const
+				-> const tree_type&;
+			
+		private:
+			config_scheme m_Scheme{ };		//< Configuration scheme
+			tree_type m_Tree{ };			//< Resolved and bounds-checked configuration data
+			file_stamp m_SchemeStamp{ };	//< Stamp of the scheme file this snapshot was created from
+			file_stamp m_ConfigStamp{ };	//< Stamp of the user configuration file this snapshot was created from
+	};
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <boost/filesystem/operations.hpp>
+
+namespace application_layer::config
+{
+	// Watches a single configuration file for modifications on a background
+	// thread and invokes a callback every time the file was written or replaced.
+	// The callback is executed on the watcher thread.
+	//
+	// The containing directory is watched instead of the file itself, since most
+	// editors save files by replacing them, which would invalidate a watch placed
+	// on the file.
+	//
+	// This is currently only implemented using inotify. On other platforms,
+	// the watcher is inert.
+	class config_watcher
+	{
+		using path_type = boost::filesystem::path;
+	
+		public:
+			using callback_type = ::std::function<void()>;
+	
+		public:
+			config_watcher(const path_type& p_path, callback_type p_callback);
+			~config_watcher();
+			
+		public:
+			config_watcher(const config_watcher&) = delete;
+			config_watcher(config_watcher&&) = delete;
+			
+			config_watcher& operator=(const config_watcher&) = delete;
+			config_watcher& operator=(config_watcher&&) = delete;
+			
+		public:
+			// Stop watching and join the watcher thread. This is also done
+			// on destruction.
+			auto stop()
+				-> void;
+			
+		private:
+			// Main loop of the watcher thread
+			auto run()
+				-> void;
+		
+		private:
+			path_type m_Path;						//< Path of the watched file
+			callback_type m_Callback;				//< Invoked on the watcher thread on file modification
+			::std::atomic<bool> m_Running{ false };	//< Cleared to request the watcher thread to exit
+			int m_Handle{ -1 };						//< inotify instance
+			::std::thread m_Thread;					//< Background thread running the watch loop
+	};
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <vector>
+#include <utility>
 #include <boost/property_tree/ptree.hpp>
 
 namespace application_layer::config::internal
@@ -14,4 +17,9 @@ namespace application_layer::config::internal
 	// A copy of the modified instance is returned.
 	auto merge(const boost::property_tree::ptree& p_dest, const boost::property_tree::ptree& p_src)
 		-> boost::property_tree::ptree;
+		
+	// Collects all leaf nodes of given tree together with their absolute paths
+	// and appends them to given vector.
+	auto flatten(const boost::property_tree::ptree& p_tree, ::std::vector<::std::pair<::std::string, ::std::string>>& p_out)
+		-> void;
 }
@@ -1,9 +1,36 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <tuple>
+#include <future>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <sstream>
+#include <limits>
+#include <utility>
+#include <typeindex>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <type_traits>
 #include <ut/always_false.hxx>
+#include <ut/type_traits.hxx>
 
+#include "io_pool.hxx"
 #include "global_system.hxx"
 
+// Asset loaders have to provide a method `load_asset(Ts...) -> T`.
+//
+// Loaders of assets that require access to the render context (e.g. textures)
+// can additionally split loading into two stages:
+//  - `decode(Ts...) -> D`, which performs all file I/O and decoding and is
+//    allowed to run on any thread
+//  - `upload(D&&) -> T`, which creates the GPU resources and is always executed
+//    on the render thread
+// Asynchronous loading will make use of this split if available.
 template< typename T >
 struct asset_loader
 {
@@ -11,11 +38,135 @@ struct asset_loader
 		"No asset loader registered for given asset type T");
 };
 
+// Shared, reference counted handle to a cached asset. Assets are immutable
+// once loaded, since they might be shared between multiple users.
+template< typename T >
+using asset_handle = ::std::shared_ptr<const T>;
+
+// Future that will contain the handle of an asynchronously loaded asset
+template< typename T >
+using asset_future = ::std::shared_future<asset_handle<T>>;
+
+// Statistics about asset cache usage
+struct asset_cache_stats
+{
+	::std::size_t m_Hits{ };		//< Number of requests that were served from the cache
+	::std::size_t m_Misses{ };		//< Number of requests that required loading the asset
+	::std::size_t m_Evictions{ };	//< Number of assets removed to stay within the memory budget
+	::std::size_t m_Entries{ };		//< Number of currently cached assets
+	::std::size_t m_MemoryUsage{ };	//< Estimated memory used by cached assets, in bytes
+};
+
+namespace internal
+{
+	// Asset loaders may provide a static method `memory_usage(const T&)` to
+	// report a better estimate of the memory used by an asset than sizeof(T).
+	template< typename T >
+	using detect_memory_usage = decltype(asset_loader<T>::memory_usage(::std::declval<const T&>()));
+	
+	// Detects two-stage asset loaders
+	template< typename T, typename... Ts >
+	using detect_decode = decltype(::std::declval<asset_loader<T>&>().decode(::std::declval<Ts>()...));
+	
+	template< typename T, typename... Ts >
+	constexpr bool has_decode_v = ut::is_detected<detect_decode, T, Ts...>::value;
+	
+	template< typename T >
+	auto asset_memory_usage(const T& p_asset)
+		-> ::std::size_t
+	{
+		if constexpr(ut::is_detected<detect_memory_usage, T>::value)
+			return asset_loader<T>::memory_usage(p_asset);
+		else
+			return sizeof(T);
+	}
+	
+	// Build cache key from the arguments passed to the asset loader.
+	// All arguments are required to be printable to an output stream.
+	template< typename... Ts >
+	auto make_asset_key(const Ts&... p_args)
+		-> ::std::string
+	{
+		::std::ostringstream t_ss{ };
+		
+		int t_x[] = { 0, ((t_ss << p_args << '\x1f'), 0)... };
+		(void)t_x;
+		
+		return t_ss.str();
+	}
+	
+	// Type-erased cache entry
+	class asset_cache_entry_base
+	{
+		public:
+			virtual ~asset_cache_entry_base() = default;
+			
+		public:
+			// Whether the asset is fully loaded and not referenced by anyone but
+			// the cache itself, or failed to load. This does not inspect the
+			// future, since retrieving it would rethrow errors of failed loads.
+			auto is_evictable() const
+				-> bool
+			{
+				// The only strong reference is the one stored in the shared state of the future
+				return m_Failed || (m_Loaded && m_Asset.use_count() <= 1);
+			}
+				
+		public:
+			::std::size_t m_Size{ };		//< Estimated memory usage, set once loading is finished
+			::std::size_t m_LastUse{ };		//< Value of the cache clock at the last access
+			::std::weak_ptr<const void> m_Asset{ };	//< Loaded asset, used to determine if it is still referenced
+			bool m_Loaded{ false };			//< Whether loading finished successfully
+			bool m_Failed{ false };			//< Whether loading failed
+	};
+	
+	template< typename T >
+	class asset_cache_entry
+		: public asset_cache_entry_base
+	{
+		public:
+			asset_cache_entry(asset_future<T> p_future)
+				: m_Future{::std::move(p_future)}
+			{
+			}
+			
+		public:
+			asset_future<T> m_Future;	//< Shared by all requests for this asset
+	};
+}
+
 
 class asset_manager
 	: public global_system
 {		
+	using key_type = ::std::pair<::std::type_index, ::std::string>;
+	using entry_ptr = ::std::unique_ptr<internal::asset_cache_entry_base>;
+	using upload_type = ::std::function<void()>;
+	
+	template< typename T >
+	using promise_ptr = ::std::shared_ptr<::std::promise<asset_handle<T>>>;
+	
+	struct key_hash
+	{
+		auto operator()(const key_type& p_key) const
+			-> ::std::size_t
+		{
+			return p_key.first.hash_code() ^ (::std::hash<::std::string>{ }(p_key.second) << 1U);
+		}
+	};
+	
+	using cache_type = ::std::unordered_map<key_type, entry_ptr, key_hash>;
+
 	public:
+		auto initialize()
+			-> void;
+			
+		auto shutdown()
+			-> void;
+
+	public:
+		// Load asset directly using its loader, bypassing the cache.
+		// Every call results in a fresh instance.
 		template< typename T, typename... Ts >
 		auto load_asset(Ts&&... p_args)
 			-> T
@@ -24,6 +175,263 @@ class asset_manager
 			asset_loader<T> t_loader{ };
 			
 			// Delegate loading of asset to loader instance
-			return t_loader.load_asset(::std::forward<Ts>(p_args)...);
+			if constexpr(internal::has_decode_v<T, Ts...>)
+				return t_loader.upload(t_loader.decode(::std::forward<Ts>(p_args)...));
+			else
+				return t_loader.load_asset(::std::forward<Ts>(p_args)...);
+		}
+		
+		// Retrieve shared handle to asset identified by its type and the given
+		// loader arguments. The asset is only loaded if it is not already cached.
+		// Concurrent requests for the same asset wait for a single load to finish.
+		//
+		// This has to be called on the render thread, since the asset might
+		// require an upload to the GPU.
+		template< typename T, typename... Ts >
+		auto acquire_asset(Ts&&... p_args)
+			-> asset_handle<T>
+		{
+			const key_type t_key{ typeid(T), internal::make_asset_key(p_args...) };
+			
+			asset_future<T> t_future{ };
+			
+			if(auto t_promise = reserve<T>(t_key, t_future))
+			{
+				try
+				{
+					complete<T>(t_key, *t_promise, load_asset<T>(::std::forward<Ts>(p_args)...));
+				}
+				catch(...)
+				{
+					fail<T>(t_key, *t_promise);
+				}
+			}
+			
+			// Another thread might be loading the asset asynchronously and require
+			// uploads to be processed
+			return await_asset(t_future);
+		}
+		
+		// Begin loading asset in the background. File reading and decoding are done
+		// on the I/O pool, uploads are deferred until the render thread calls
+		// `process_uploads`. Requests are cached and deduplicated like `acquire_asset`.
+		template< typename T, typename... Ts >
+		auto acquire_asset_async(Ts&&... p_args)
+			-> asset_future<T>
+		{
+			const key_type t_key{ typeid(T), internal::make_asset_key(p_args...) };
+			
+			asset_future<T> t_future{ };
+			
+			if(auto t_promise = reserve<T>(t_key, t_future))
+			{
+				// Arguments are copied, since the caller is free to destroy them
+				auto t_args = ::std::make_tuple(::std::decay_t<Ts>(::std::forward<Ts>(p_args))...);
+			
+				auto t_task = [this, t_key, t_promise, t_args = ::std::move(t_args)]() mutable
+				{
+					try
+					{
+						asset_loader<T> t_loader{ };
+						
+						if constexpr(internal::has_decode_v<T, ::std::decay_t<Ts>...>)
+						{
+							auto t_decode = [&t_loader](auto&&... p_xs) { return t_loader.decode(::std::move(p_xs)...); };
+							using data_type = decltype(::std::apply(t_decode, t_args));
+							
+							// Decoded data is shared since std::function requires copyable callables
+							auto t_data = ::std::make_shared<data_type>(::std::apply(t_decode, t_args));
+							
+							post_upload([this, t_key, t_promise, t_data]()
+							{
+								try
+								{
+									asset_loader<T> t_uploader{ };
+									complete<T>(t_key, *t_promise, t_uploader.upload(::std::move(*t_data)));
+								}
+								catch(...)
+								{
+									fail<T>(t_key, *t_promise);
+								}
+							});
+						}
+						else
+						{
+							complete<T>(t_key, *t_promise, ::std::apply(
+								[&t_loader](auto&&... p_xs) { return t_loader.load_asset(::std::move(p_xs)...); },
+								t_args
+							));
+						}
+					}
+					catch(...)
+					{
+						fail<T>(t_key, *t_promise);
+					}
+				};
+				
+				// The entry is already reserved, so it has to be failed if the task
+				// can't be queued. Otherwise later requests wait for it forever.
+				try
+				{
+					m_Pool.post(::std::move(t_task));
+				}
+				catch(...)
+				{
+					fail<T>(t_key, *t_promise);
+					throw;
+				}
+			}
+			
+			return t_future;
 		}
+		
+		// Wait for asynchronously loaded asset to become available. Pending uploads
+		// are processed while waiting if this is called on the render thread.
+		// Otherwise the render thread has to be running to process them. Throws
+		// if uploads are pending, but no thread is able to process them.
+		template< typename T >
+		auto await_asset(const asset_future<T>& p_future)
+			-> asset_handle<T>
+		{
+			while(p_future.wait_for(::std::chrono::milliseconds{1}) != ::std::future_status::ready)
+			{
+				if(process_uploads() == 0U && uploads_stalled())
+					throw ::std::runtime_error("asset_manager: asset requires an upload, but no render thread is processing uploads");
+			}
+				
+			return p_future.get();
+		}
+		
+		// Execute pending GPU uploads, and evict assets if the memory budget was
+		// exceeded since the last call. Calls on any thread other than the render
+		// thread do nothing. Returns the number of uploads that were performed.
+		auto process_uploads(::std::size_t p_max = ::std::numeric_limits<::std::size_t>::max())
+			-> ::std::size_t;
+		
+		// Set thread owning the GL context. Until this is called, no uploads are
+		// executed at all. The render manager sets this during initialization
+		// and when it starts or stops its render thread. A default constructed
+		// id means that no thread is currently able to execute uploads.
+		auto set_render_thread(::std::thread::id p_id)
+			-> void;
+		
+	public:
+		// Set maximum amount of memory cached assets may occupy. Assets that are
+		// still referenced are never evicted, so this is a soft limit. The budget
+		// is enforced on the next call to `process_uploads`.
+		auto set_memory_budget(::std::size_t p_bytes)
+			-> void;
+			
+		auto memory_budget() const
+			-> ::std::size_t;
+			
+		auto statistics() const
+			-> asset_cache_stats;
+			
+		// Evict least recently used assets that are not referenced anymore until
+		// the memory budget is met. Has to be called on the render thread, since
+		// evicted assets might release GPU resources.
+		auto trim()
+			-> void;
+			
+		// Evict all assets that are not referenced anymore. Has to be called on
+		// the render thread.
+		auto purge()
+			-> void;
+			
+	private:
+		// Look up cache entry for given key. If the asset is not yet cached, a new
+		// entry is registered and a promise the caller has to fulfill is returned.
+		// Other threads requesting the same asset will wait for that promise instead
+		// of loading it again.
+		template< typename T >
+		auto reserve(const key_type& p_key, asset_future<T>& p_future)
+			-> promise_ptr<T>
+		{
+			::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+			
+			if(const auto t_it = m_Cache.find(p_key); t_it != m_Cache.end())
+			{
+				auto& t_entry = static_cast<internal::asset_cache_entry<T>&>(*t_it->second);
+				t_entry.m_LastUse = ++m_Clock;
+				p_future = t_entry.m_Future;
+				
+				++m_Stats.m_Hits;
+				return nullptr;
+			}
+			
+			auto t_promise = ::std::make_shared<::std::promise<asset_handle<T>>>();
+			p_future = t_promise->get_future().share();
+			
+			auto t_entry = ::std::make_unique<internal::asset_cache_entry<T>>(p_future);
+			t_entry->m_LastUse = ++m_Clock;
+			m_Cache.emplace(p_key, ::std::move(t_entry));
+			
+			++m_Stats.m_Misses;
+			return t_promise;
+		}
+		
+		template< typename T >
+		auto complete(const key_type& p_key, ::std::promise<asset_handle<T>>& p_promise, T&& p_asset)
+			-> void
+		{
+			const auto t_handle = ::std::make_shared<const T>(::std::move(p_asset));
+			
+			// The future has to hold its reference before the entry is marked as
+			// loaded, otherwise the asset could be evicted right away
+			p_promise.set_value(t_handle);
+			register_asset(p_key, internal::asset_memory_usage(*t_handle), t_handle);
+			
+			// Newly loaded asset might have exceeded the budget. This might run on an
+			// I/O worker, and evicted assets can own GPU resources, so eviction is
+			// left to the render thread.
+			m_TrimPending.store(true);
+		}
+		
+		// Has to be called from within a catch block
+		template< typename T >
+		auto fail(const key_type& p_key, ::std::promise<asset_handle<T>>& p_promise)
+			-> void
+		{
+			// Failed loads are not cached. The entry is marked first, so eviction
+			// running in the meantime can drop it without inspecting the future.
+			mark_failed(p_key);
+			remove_entry(p_key);
+			p_promise.set_exception(::std::current_exception());
+		}
+		
+		auto post_upload(upload_type p_upload)
+			-> void;
+		
+		// Whether uploads are pending, but there is no render thread to execute them
+		auto uploads_stalled()
+			-> bool;
+	
+		auto register_asset(const key_type& p_key, ::std::size_t p_size, ::std::shared_ptr<const void> p_asset)
+			-> void;
+			
+		auto mark_failed(const key_type& p_key)
+			-> void;
+			
+		auto remove_entry(const key_type& p_key)
+			-> void;
+			
+		// Evict unreferenced entries in LRU order until given amount of memory is used.
+		// Requires m_Mutex to be locked.
+		auto evict_until(::std::size_t p_bytes)
+			-> void;
+			
+	private:
+		mutable ::std::mutex m_Mutex;	//< Protects all members below
+		cache_type m_Cache;				//< All cached assets
+		asset_cache_stats m_Stats;		//< Usage statistics
+		::std::size_t m_Clock{ };		//< Logical clock used to determine least recently used assets
+		::std::size_t m_Budget{ ::std::numeric_limits<::std::size_t>::max() };	//< Memory budget, in bytes
+		
+		::std::mutex m_UploadMutex;				//< Protects the upload queue
+		::std::deque<upload_type> m_Uploads;	//< Uploads waiting to be executed on the render thread
+		::std::atomic<::std::thread::id> m_RenderThread{ };	//< Only thread allowed to execute uploads
+		::std::atomic<bool> m_TrimPending{ false };			//< Whether the memory budget might be exceeded
+		
+		io_pool m_Pool;		//< Workers used for asynchronous loading. Declared last to be destroyed first.
 };
@@ -12,6 +12,9 @@ typedef enum
 	VAL_TYPE_BOOL
 } config_value_t;
 
+// Callback invoked for every changed configuration entry after a hot-reload
+typedef void (*config_listener_t)(const char* path, void* userData);
+
 extern "C"
 {
 	config_value_t configuration_get_type(const char* path);
@@ -21,5 +24,13 @@ extern "C"
 	unsigned configuration_get_uint(const char* path);
 	const char* configuration_get_string(const char* path);
 	bool_t configuration_get_boolean(const char* path);
+	
+	void configuration_enable_hot_reload();
+	void configuration_disable_hot_reload();
+	bool_t configuration_apply_changes();
+	
+	// A NULL or empty prefix matches all entries
+	uint64_t configuration_add_listener(const char* prefix, config_listener_t listener, void* userData);
+	void configuration_remove_listener(uint64_t id);
 }
 
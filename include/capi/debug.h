@@ -1,6 +1,28 @@
 #pragma once
 
+#include <stdint.h>
+#include "types.h"
+
+// Parameters of a generated benchmark scene. All ratios are in [0, 1].
+typedef struct
+{
+	uvec2_t size;			// Size of the scene layer in glyphs. Zero draws into the base layer.
+	float fillRatio;		// Fraction of cells that are not empty
+	int lightCount;			// Number of dynamic lights, limited by the remaining light slots
+	float shadowDensity;	// Fraction of non-empty cells with drop shadows
+	float guiCoverage;		// Fraction of the scene covered by a GUI panel layer
+	uint32_t seed;			// Seed of the random number generator
+} scene_params_t;
+
 extern "C"
 {
 	void debug_create_test_scene();
+	
+	// Create a random scene with given parameters, replacing the previously
+	// created one. Equal parameters result in equal scenes. Returns the layer
+	// containing the scene.
+	uint32_t debug_create_scene(scene_params_t* params);
+	
+	// Remove layers and lights of the last created scene
+	void debug_destroy_scene();
 }
@@ -1,7 +1,27 @@
 #pragma once
 
+#include <stddef.h>
 #include "types.h"
 
+// Types of input events
+#define INPUT_EVENT_KEY			0
+#define INPUT_EVENT_TEXT		1
+#define INPUT_EVENT_MOUSE_MOVE	2
+#define INPUT_EVENT_WHEEL		3
+
+typedef struct
+{
+	uint32_t type;			// One of the INPUT_EVENT_* constants
+	uint32_t codepoint;		// Unicode code point, for text events
+	uint64_t timestamp;		// Time the event was received, in microseconds since startup
+	int32_t key;			// GLFW key code, for key events
+	int32_t action;			// GLFW_PRESS, GLFW_REPEAT or GLFW_RELEASE, for key events
+	int32_t mods;			// GLFW modifier bits, for key events
+	ivec2_t cell;			// Screen cell under the mouse cursor, for mouse move events
+	float wheel_x;			// Scroll offsets, for wheel events
+	float wheel_y;
+} input_event_t;
+
 extern "C"
 {
 	void input_begin();
@@ -9,4 +29,11 @@ extern "C"
 	void input_end();
 
 	bool_t input_has_key(int key);
+	
+	// Copy up to given number of pending input events, oldest first, into given
+	// array and remove them from the queue. Returns the number of copied events.
+	size_t input_drain_events(input_event_t* events, size_t capacity);
+	
+	// Number of events discarded since startup because the queue was full
+	uint64_t input_dropped_events();
 }
@@ -9,4 +9,11 @@ extern "C"
 	void logger_lock();
 		
 	void logger_unlock();
+	
+	// Wait until all messages posted so far have been written. Only has an
+	// effect if the logger runs in asynchronous mode.
+	void logger_flush();
+	
+	// Number of messages discarded because the asynchronous queue was full
+	uint64_t logger_dropped_messages();
 }
@@ -3,4 +3,7 @@
 extern "C"
 {
 	void renderer_render();
+	
+	void renderer_set_scale(float p_scale);
+	float renderer_get_scale();
 }
@@ -44,4 +44,19 @@ extern "C"
 	void screen_clear();
 
 	void screen_set_depth(uvec2_t* pos, uint8_t depth);	
+	
+	// Screen layers. All other screen functions operate on the selected layer,
+	// which initially is the base layer with id 0. Cells with glyph 0 and
+	// black colors are transparent in all layers except the base layer.
+	uint32_t screen_create_layer(uvec2_t* dims, ivec2_t* offset, int z_order);
+	
+	void screen_destroy_layer(uint32_t layer);
+	
+	void screen_select_layer(uint32_t layer);
+	
+	void screen_set_layer_offset(uint32_t layer, ivec2_t* offset);
+	
+	void screen_set_layer_z_order(uint32_t layer, int z_order);
+	
+	void screen_set_layer_visible(uint32_t layer, bool_t flag);
 }
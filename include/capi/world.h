@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include "types.h"
+
+extern "C"
+{
+	// Create screen layer showing a new, empty world through a viewport with
+	// given dimensions. The layer is destroyed using screen_destroy_layer.
+	uint32_t world_create_layer(uvec2_t* dims, ivec2_t* offset, int z_order);
+	
+	// Create screen layer showing the persistent world with given name, which
+	// is stored in the user directory. Only a bounded number of chunks is kept
+	// in memory.
+	uint32_t world_open_layer(const char* name, uvec2_t* dims, ivec2_t* offset, int z_order);
+	
+	// Write index of a persistent world to disk
+	void world_flush(uint32_t layer);
+
+	void world_scroll_to(uint32_t layer, ivec2_t* pos);
+	
+	void world_scroll(uint32_t layer, ivec2_t* delta);
+	
+	void world_get_position(uint32_t layer, ivec2_t* out);
+
+	void world_set_tile(uint32_t layer, ivec2_t* pos, uvec3_t* front, uvec3_t* back, uint8_t glyph);
+	
+	void world_clear_tile(uint32_t layer, ivec2_t* pos);
+	
+	void world_set_light_mode(uint32_t layer, ivec2_t* pos, int mode);
+	
+	void world_set_depth(uint32_t layer, ivec2_t* pos, uint8_t depth);
+}
@@ -13,7 +13,10 @@ enum class cl_argument
 	logger_verbosity,
 	logger_verbose,
 	logger_enable_file,
-	logger_append_file
+	logger_append_file,
+	logger_mode,
+	logger_overflow,
+	logger_trace
 };
 
 extern cl::handler g_clHandler;
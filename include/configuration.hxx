@@ -1,14 +1,22 @@
 #pragma once
 
 #include <string>
+#include <cstddef>
 #include <optional>
 #include <type_traits>
+#include <stdexcept>
+#include <memory>
+#include <map>
+#include <functional>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <cl.hxx>
 #include <ut/type_traits.hxx>
+#include <ut/throwf.hxx>
 
 #include <application_layer/config/config_scheme.hxx>
+#include <application_layer/config/config_watcher.hxx>
+#include "file_stamp.hxx"
 #include "global_system.hxx"
 
 
@@ -25,17 +33,82 @@ namespace internal
 	>;
 }
 
+class configuration;
+
+// A typed handle to a single configuration entry. The key is resolved and
+// converted only once; subsequent reads return the cached value as long as
+// the configuration has not been modified since. Any modification of the
+// configuration trees (reload, overrides, bounds checks) bumps the
+// configuration generation, which causes the handle to lazily re-resolve
+// on its next access. This makes reading settings in hot code (e.g. every
+// frame) cost a single integer comparison.
+template< typename T >
+class config_handle
+{
+	using path_type = typename boost::property_tree::ptree::path_type;
+	using generation_type = ::std::size_t;
+
+	public:
+		config_handle(const configuration& p_cfg, const path_type& p_path)
+			: m_Config{&p_cfg}, m_Path{p_path}
+		{
+		}
+		
+	public:
+		config_handle(const config_handle&) = default;
+		config_handle(config_handle&&) = default;
+		
+		config_handle& operator=(const config_handle&) = default;
+		config_handle& operator=(config_handle&&) = default;
+		
+	public:
+		// Retrieve cached value, re-resolving it if the configuration
+		// changed since the last access.
+		auto get() const
+			-> const ::std::optional<T>&;
+			
+		// Retrieve cached value. Throws if the entry does not exist or
+		// could not be converted to T.
+		auto value() const
+			-> const T&;
+			
+		auto operator*() const
+			-> const T&
+		{
+			return value();
+		}
+		
+		explicit operator bool() const
+		{
+			return get().has_value();
+		}
+		
+	private:
+		const configuration* m_Config;					//< Configuration this handle is bound to
+		path_type m_Path;								//< Path of the referenced entry
+		mutable ::std::optional<T> m_Value{ };			//< Cached, already converted value
+		mutable generation_type m_Generation{ 0U };		//< Generation m_Value was resolved at. 0 is never valid.
+};
+
 class configuration
 	: public global_system
 {
 	using tree_type = pt::ptree;
 	using path_type = typename tree_type::path_type;
 	using scheme_type = application_layer::config::config_scheme;
+	using generation_type = ::std::size_t;
+	
+	public:
+		using listener_id = ::std::size_t;
+		using listener_type = ::std::function<void(const ::std::string&)>;
 	
 	public:
 		auto initialize()
 			-> void;
 			
+		auto shutdown()
+			-> void;
+			
 	public:
 		auto tree()
 			-> tree_type&;
@@ -46,6 +119,12 @@ class configuration
 		auto scheme() const
 			-> const scheme_type&;
 			
+		// Current configuration generation. This is incremented every time
+		// the stored configuration data might have changed, and is used by
+		// config_handle<T> to detect stale cached values.
+		auto generation() const
+			-> generation_type;
+			
 	public:
 		// Write configuration data back to file.
 		// This will only use the information available
@@ -53,22 +132,80 @@ class configuration
 		auto save() const
 			-> void;
 			
+		// Write configuration data back to file, but only if the contents
+		// of the file would actually change. Returns true if the file was written.
+		auto save_if_changed() const
+			-> bool;
+			
 		// Causes the configuration manager to load overrides from the command line handlers.
 		// This is directly called by the commandline system.
 		auto populate_overrides()
 			-> void;
 			
+	public:
+		// Start watching the user configuration file for modifications. Every time
+		// it is changed, the file is reloaded and bounds checked on a background thread.
+		// The result only becomes visible after the next call to apply_changes().
+		auto enable_hot_reload()
+			-> void;
+			
+		auto disable_hot_reload()
+			-> void;
+			
+		// Swap in configuration data that was reloaded in the background, if any,
+		// and notify all listeners about changed entries. This has to be called
+		// on the main thread, for example once per frame.
+		// Returns true if new configuration data was applied.
+		auto apply_changes()
+			-> bool;
+			
+		// Register callback that is invoked by apply_changes() for every changed
+		// entry whose path equals given prefix or lies below it. An empty prefix
+		// matches all entries. Entries that are overridden on the command line
+		// do not cause notifications, since their effective value did not change.
+		auto add_listener(const ::std::string& p_prefix, listener_type p_listener)
+			-> listener_id;
+			
+		auto remove_listener(listener_id p_id)
+			-> void;
+			
 	private:
-		// Perform bounds checks on all configuration values.
+		// Try to restore scheme and data tree from the binary configuration
+		// snapshot. This fails if there is no snapshot or it was created from
+		// different versions of the scheme or configuration file.
+		auto load_snapshot(const file_stamp& p_schemeStamp, const file_stamp& p_configStamp)
+			-> bool;
+			
+		// Write current scheme and given data tree to the binary configuration snapshot
+		auto write_snapshot(const tree_type& p_tree, const file_stamp& p_schemeStamp, const file_stamp& p_configStamp) const
+			-> void;
+	
+		// Load scheme and configuration data from their JSON source documents,
+		// perform bounds checking and write back the configuration file if needed
+		auto load_sources()
+			-> void;
+	
+		// Build a complete data tree from the scheme defaults and the given
+		// configuration file, and bounds check it. This does not access any
+		// state of the configuration manager and can thus safely be called
+		// from the hot-reload thread.
+		static auto resolve(const scheme_type& p_scheme, const boost::filesystem::path& p_path)
+			-> tree_type;
+	
+		// Perform bounds checks on all configuration values in given tree.
 		// This ensures that values set via manually modifying the
 		// config files will not crash the game.
-		auto check_bounds()
+		static auto check_bounds(const scheme_type& p_scheme, tree_type& p_tree)
 			-> void;		
 			
 		// Use scheme to add all mappings to the command line handler as arguments
 		auto populate_cl_arguments()
 			-> void;
 			
+		// Mark all cached values held by configuration handles as stale
+		auto invalidate_handles()
+			-> void;
+			
 	public:
 		// We have to replicate most of the interface here since
 		// we want to control which tree actually gets accessed
@@ -91,6 +228,16 @@ class configuration
 			else return { };
 		}
 		
+		// Create a typed handle to given configuration entry. The handle caches
+		// the converted value and is only refreshed after the configuration
+		// was modified.
+		template< typename T >
+		auto handle(const path_type& p_path) const
+			-> config_handle<T>
+		{
+			return { *this, p_path };
+		}
+		
 		// TODO
 		// get_default()..  // Have a tree_tyoe m_Defaults that has the default values loaded.
 		// This will return default value if requested value was not found.
@@ -105,4 +252,42 @@ class configuration
 		tree_type m_OverrideTree;	//< Tree containg configuration read from command line.
 									//  This separation is done to allow users to change
 									//  configuration without messing it up with the overrides.	
+		generation_type m_Generation{ 1U };	//< Current configuration generation, see generation()
+		file_stamp m_SchemeStamp{ };		//< Stamp of the scheme file loaded on initialization
+		
+		::std::unique_ptr<application_layer::config::config_watcher> m_Watcher{ };	//< Watches the configuration file, if hot-reload is enabled
+		::std::shared_ptr<const tree_type> m_PendingTree{ };	//< Data tree reloaded in the background. Only accessed atomically.
+		::std::map<listener_id, ::std::pair<::std::string, listener_type>> m_Listeners{ };	//< Registered change listeners and their path prefixes
+		listener_id m_NextListener{ 1U };	//< Id given to the next registered listener
 };
+
+
+template< typename T >
+auto config_handle<T>::get() const
+	-> const ::std::optional<T>&
+{
+	// Only re-resolve the path if the configuration changed in the meantime
+	if(const auto t_gen = m_Config->generation(); t_gen != m_Generation)
+	{
+		m_Value = m_Config->get<T>(m_Path);
+		m_Generation = t_gen;
+	}
+	
+	return m_Value;
+}
+
+template< typename T >
+auto config_handle<T>::value() const
+	-> const T&
+{
+	const auto& t_val = get();
+	
+	if(!t_val)
+	{
+		ut::throwf<::std::runtime_error>("config_handle: requested configuration entry does not exist or type mismatch: \"%s\"",
+			m_Path.dump()
+		);
+	}
+	
+	return *t_val;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <boost/filesystem.hpp>
+
+// Calculate 64 bit FNV-1a hash of given memory block. A previously
+// calculated hash can be passed as seed to hash multiple blocks in sequence.
+auto fnv1a_hash(const void* p_data, ::std::size_t p_length, ::std::uint64_t p_seed = 14695981039346656037ULL)
+	-> ::std::uint64_t;
+
+// Identifies a certain version of a file on disk. This is used to validate
+// caches derived from source files, like the binary configuration snapshot.
+// Files that do not exist result in an "absent" stamp with all fields
+// set to zero.
+class file_stamp
+{
+	using path_type = boost::filesystem::path;
+	
+	public:
+		using size_type = ::std::uint64_t;
+		using time_type = ::std::int64_t;
+		using hash_type = ::std::uint64_t;
+
+	public:
+		file_stamp() = default;
+		
+		// Create stamp by inspecting given file. This reads the whole file
+		// to calculate the content hash.
+		explicit file_stamp(const path_type& p_path);
+		
+		file_stamp(size_type p_size, time_type p_time, hash_type p_hash)
+			: m_Size{p_size}, m_ModTime{p_time}, m_Hash{p_hash}
+		{
+		}
+		
+	public:
+		file_stamp(const file_stamp&) = default;
+		file_stamp(file_stamp&&) = default;
+		
+		file_stamp& operator=(const file_stamp&) = default;
+		file_stamp& operator=(file_stamp&&) = default;
+		
+	public:
+		auto size() const
+			-> size_type;
+			
+		auto modification_time() const
+			-> time_type;
+			
+		auto hash() const
+			-> hash_type;
+			
+		// Whether the file this stamp was created from existed
+		auto exists() const
+			-> bool;
+			
+	public:
+		auto operator==(const file_stamp&) const
+			-> bool;
+			
+		auto operator!=(const file_stamp&) const
+			-> bool;
+
+	private:
+		size_type m_Size{ };		//< File size in bytes
+		time_type m_ModTime{ };		//< Last modification time, as reported by the filesystem
+		hash_type m_Hash{ };		//< FNV-1a hash of file contents
+};
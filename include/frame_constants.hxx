@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <GLXW/glxw.h>
+#include <glm/glm.hpp>
+
+// Per-frame shader constants. Layout matches the std140 "FrameConstants"
+// uniform block in the shaders.
+struct frame_constants
+{
+	glm::mat4 m_Projection{1.f};			//< Orthographic projection, in unscaled pixels
+	glm::vec4 m_FogColor{0.1f, 0.1f, 0.3f, 1.f};
+	glm::ivec2 m_GlyphDimensions{};			//< Dimensions of a single glyph, in pixels
+	glm::ivec2 m_SheetDimensions{};			//< Dimensions of a glyph sheet, in glyphs
+	glm::ivec2 m_GlyphCount{};				//< Screen size, in glyphs
+	float m_FogDensity{.15f};
+	::std::uint32_t m_ShadowLayer{};		//< Glyph atlas layer containing the drop shadows
+};
+
+// Owns the GPU buffer backing the frame constants uniform block.
+// Like the light manager, the buffer is only updated in sync() if the
+// constants were modified.
+class frame_constants_buffer
+{
+	static constexpr ::std::size_t buffer_size = 64 + 16 + 8 + 8 + 8 + 4 + 4;
+	
+	static_assert(sizeof(frame_constants) == buffer_size, "size of struct frame_constants does not match buffer_size");
+
+	public:
+		// The light data block uses binding 0
+		static constexpr GLuint binding = 1U;
+
+	public:
+		frame_constants_buffer() = default;
+		~frame_constants_buffer();
+		
+		frame_constants_buffer(const frame_constants_buffer&) = delete;
+		frame_constants_buffer& operator=(const frame_constants_buffer&) = delete;
+		
+	public:
+		auto initialize()
+			-> void;
+			
+		// Upload constants to the GPU if they were modified
+		auto sync()
+			-> void;
+			
+		// Write given constants to the GPU buffer, regardless of the stored
+		// constants. Used by the render thread, which only works on snapshots.
+		auto upload(const frame_constants& p_constants) const
+			-> void;
+			
+		// Retrieve reference to stored constants. Using this method signals
+		// that the constants have been changed.
+		auto modify()
+			-> frame_constants&;
+			
+		auto constants() const
+			-> const frame_constants&;
+			
+	private:
+		bool m_Dirty{true};				//< Whether the constants were modified since the last sync
+		GLuint m_GPUBuffer{};			//< Handle of GPU buffer
+		frame_constants m_Constants;	//< Current constants
+};
@@ -0,0 +1,168 @@
+// Hands completed frames from a producer thread to a consumer thread.
+//
+// Three slots are used: the producer fills the back slot, the consumer reads
+// the front slot, and the middle slot holds the most recently published frame.
+// Publishing and acquiring only exchange slot indices, so neither side ever
+// waits for the other to finish copying or drawing a frame.
+//
+// In triple buffered mode, the producer never waits and the consumer always
+// receives the newest frame, skipping older ones it did not get to. In double
+// buffered mode, the producer waits until the previously published frame was
+// acquired, which keeps it at most one frame ahead and never skips frames.
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+
+enum class handoff_mode
+{
+	double_buffered,	//< Producer waits for the consumer, no frames are skipped
+	triple_buffered		//< Producer never waits, consumer only sees the newest frame
+};
+
+template< typename T >
+class frame_handoff
+{
+	using index_type = ::std::uint8_t;
+	
+	static constexpr const index_type index_mask = 0x3U;
+	static constexpr const index_type fresh_bit = 0x4U;		//< Set if the middle slot was not acquired yet
+	
+	public:
+		using counter_type = ::std::uint64_t;
+	
+	public:
+		explicit frame_handoff(handoff_mode p_mode = handoff_mode::triple_buffered)
+			: m_Mode{p_mode}
+		{
+		}
+		
+		frame_handoff(const frame_handoff&) = delete;
+		frame_handoff& operator=(const frame_handoff&) = delete;
+	
+	public:
+		// Slot the next frame is written to. Only to be used by the producer.
+		// Slots are reused, so it still contains the frame published three
+		// frames ago.
+		auto back()
+			-> T&
+		{
+			return m_Slots[m_Back];
+		}
+		
+		// Publish the back slot. Returns false if the handoff was closed while
+		// waiting for the consumer.
+		auto publish()
+			-> bool
+		{
+			if(m_Mode == handoff_mode::double_buffered)
+			{
+				::std::unique_lock<::std::mutex> t_lock{ m_WaitMutex };
+				
+				m_Consumed.wait(t_lock, [this]()
+				{
+					return !(m_Middle.load(::std::memory_order_acquire) & fresh_bit) || closed();
+				});
+				
+				if(closed())
+					return false;
+			}
+			
+			const auto t_old = m_Middle.exchange(static_cast<index_type>(m_Back | fresh_bit), ::std::memory_order_acq_rel);
+			m_Back = t_old & index_mask;
+			
+			if(t_old & fresh_bit)
+				m_Skipped.fetch_add(1U, ::std::memory_order_relaxed);
+			
+			notify(m_Published);
+			return true;
+		}
+		
+		// Acquire the most recently published frame, waiting up to given time
+		// for one to arrive. Returns nullptr if no new frame was published. The
+		// frame stays valid until the next call. Only to be used by the consumer.
+		template< typename Trep, typename Tperiod >
+		auto acquire(const ::std::chrono::duration<Trep, Tperiod>& p_timeout)
+			-> const T*
+		{
+			if(!(m_Middle.load(::std::memory_order_acquire) & fresh_bit))
+			{
+				::std::unique_lock<::std::mutex> t_lock{ m_WaitMutex };
+				
+				const auto t_fresh = m_Published.wait_for(t_lock, p_timeout, [this]()
+				{
+					return (m_Middle.load(::std::memory_order_acquire) & fresh_bit) || closed();
+				});
+				
+				if(!t_fresh || closed())
+					return nullptr;
+			}
+			
+			const auto t_old = m_Middle.exchange(m_Front, ::std::memory_order_acq_rel);
+			m_Front = t_old & index_mask;
+			
+			notify(m_Consumed);
+			return &m_Slots[m_Front];
+		}
+		
+		// Wake up and release both sides. Neither publishes nor acquires succeed
+		// afterwards.
+		auto close()
+			-> void
+		{
+			m_Closed.store(true, ::std::memory_order_release);
+			
+			notify(m_Published);
+			notify(m_Consumed);
+		}
+		
+		auto closed() const
+			-> bool
+		{
+			return m_Closed.load(::std::memory_order_acquire);
+		}
+		
+		auto mode() const
+			-> handoff_mode
+		{
+			return m_Mode;
+		}
+		
+		// Number of published frames that were replaced before being acquired
+		auto skipped() const
+			-> counter_type
+		{
+			return m_Skipped.load(::std::memory_order_relaxed);
+		}
+	
+	private:
+		// The mutex is only used to sleep, but has to be taken before notifying
+		// to not lose a wakeup between the waiter checking its predicate and
+		// going to sleep
+		auto notify(::std::condition_variable& p_cond)
+			-> void
+		{
+			{
+				::std::lock_guard<::std::mutex> t_lock{ m_WaitMutex };
+			}
+			
+			p_cond.notify_all();
+		}
+	
+	private:
+		handoff_mode m_Mode;
+		::std::array<T, 3U> m_Slots{ };
+		index_type m_Back{0U};							//< Slot owned by the producer
+		index_type m_Front{1U};							//< Slot owned by the consumer
+		::std::atomic<index_type> m_Middle{2U};			//< Published slot and fresh bit
+		::std::atomic_bool m_Closed{false};
+		::std::atomic<counter_type> m_Skipped{0U};
+		::std::mutex m_WaitMutex;						//< Only used to sleep on the condition variables
+		::std::condition_variable m_Published;			//< Signaled after a frame was published
+		::std::condition_variable m_Consumed;			//< Signaled after a frame was acquired
+};
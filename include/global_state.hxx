@@ -15,9 +15,107 @@
 #include "input_manager.hxx"
 #include "commandline.hxx"
 
-// Define global state type by providing initialization
-// sequence of the subsystems. They will be deinitialized
-// in reverse order.
+// Initialization requirements of the subsystems. Everything using the GL
+// context or GLFW has to stay on the main thread. Systems logging during
+// initialization depend on the log manager. The log manager and its
+// dependencies form a chain, so they run on the main thread instead of being
+// handed from worker to worker.
+template< >
+struct system_traits<path_manager>
+{
+	using dependencies = system_list<>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "path_manager";
+};
+
+template< >
+struct system_traits<configuration>
+{
+	using dependencies = system_list<path_manager>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "configuration";
+};
+
+template< >
+struct system_traits<commandline>
+{
+	using dependencies = system_list<configuration>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "commandline";
+};
+
+template< >
+struct system_traits<log_manager>
+{
+	using dependencies = system_list<path_manager, commandline>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "log_manager";
+};
+
+template< >
+struct system_traits<process_manager>
+{
+	using dependencies = system_list<log_manager>;
+	
+	static constexpr const init_policy policy = init_policy::lazy;
+	static constexpr const char* name = "process_manager";
+};
+
+template< >
+struct system_traits<render_context>
+{
+	using dependencies = system_list<log_manager>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "render_context";
+};
+
+template< >
+struct system_traits<input_manager>
+{
+	using dependencies = system_list<render_context>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "input_manager";
+};
+
+template< >
+struct system_traits<asset_manager>
+{
+	// Only starts the I/O pool, which is idle until assets are requested, so
+	// it overlaps with the log manager chain
+	using dependencies = system_list<>;
+	
+	static constexpr const init_policy policy = init_policy::worker_thread;
+	static constexpr const char* name = "asset_manager";
+};
+
+template< >
+struct system_traits<render_manager>
+{
+	using dependencies = system_list<path_manager, configuration, render_context, asset_manager>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "render_manager";
+};
+
+template< >
+struct system_traits<light_manager>
+{
+	using dependencies = system_list<render_context>;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "light_manager";
+};
+
+
+// Define global state type by providing the subsystems. They are initialized
+// in dependency order, as declared by their system_traits, and deinitialized
+// in reverse order of this list.
 using global_state_t = internal::global_state_impl<
 	path_manager,
 	configuration,
@@ -46,5 +144,5 @@ auto global_state()
 	static_assert(is_global_system_v<T>,
 		"T needs to be a global system!");
 		
-	return ::std::get<T>(global_state().systems());	
+	return global_state().get<T>();
 }
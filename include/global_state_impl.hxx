@@ -3,10 +3,33 @@
 #include <type_traits>
 #include <initializer_list>
 #include <tuple>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdint>
 #include <utility>
+#include <exception>
+#include <stdexcept>
+#include <condition_variable>
 #include <ut/type_traits.hxx>
+#include <log.hxx>
 
 #include "global_system.hxx"
+#include "io_pool.hxx"
+
+// Startup timing of a single global system
+struct startup_record
+{
+	using duration_type = ::std::chrono::duration<double, ::std::milli>;
+	
+	const char* m_Name{ };
+	init_policy m_Policy{init_policy::main_thread};
+	bool m_Initialized{false};		//< Lazy systems might never be initialized
+	duration_type m_Start{ };		//< Start of initialization, relative to start of global initialization
+	duration_type m_Duration{ };
+};
 
 namespace internal
 {
@@ -26,36 +49,142 @@ namespace internal
 	using reversed = typename index_list_reverser<T>::type;
 	//
 	
+	// Index of type T in given list of types. Fails to compile if T is not
+	// contained in the list.
+	template< typename T, typename... Ts >
+	struct index_of;
+	
+	template< typename T, typename... Ts >
+	struct index_of<T, T, Ts...>
+		: ::std::integral_constant<::std::size_t, 0U>
+	{
+	};
+	
+	template< typename T, typename U, typename... Ts >
+	struct index_of<T, U, Ts...>
+		: ::std::integral_constant<::std::size_t, 1U + index_of<T, Ts...>::value>
+	{
+	};
+	//
 	
+
+	// Initializes global systems in dependency order. Systems with policy
+	// worker_thread are initialized on a temporary thread pool, all others on
+	// the calling thread. Lazy systems are initialized on first access.
 	template< typename... Ts >
 	class global_state_impl
 	{
 		// TODO assert that all types are unique
-	
+		
 		// Assert that all given types are actually global systems
 		static_assert(::std::conjunction_v<is_global_system<Ts>...>,
 			"global_state_impl: All given types have to adhere to the"
 			"global_state concept!");
-	
+		
+		static_assert(sizeof...(Ts) <= 64U, "global_state_impl: Too many global systems");
+		
 		using tuple_type = ::std::tuple<Ts...>;
 		using index_type = ::std::index_sequence_for<Ts...>;
 		using reverse_index_type = reversed<index_type>;
+		using mask_type = ::std::uint64_t;
+		using clock_type = ::std::chrono::steady_clock;
+		
+		static constexpr const ::std::size_t system_count = sizeof...(Ts);
+		
+		enum class system_state
+		{
+			pending,
+			running,
+			done
+		};
+		
+		public:
+			using report_type = ::std::array<startup_record, system_count>;
 		
 		public:
 			global_state_impl() = default;
-			
+		
 		public:
 			global_state_impl(const global_state_impl&) = delete;
 			global_state_impl(global_state_impl&&) = delete;
 			
 			global_state_impl& operator=(const global_state_impl&) = delete;
 			global_state_impl& operator=(global_state_impl&&) = delete;
-			
+		
 		public:
 			auto initialize()
 				-> void
 			{
-				initialize_impl(index_type{});
+				m_Start = clock_type::now();
+				m_Report = report_type{ startup_record{ system_traits<Ts>::name, system_traits<Ts>::policy }... };
+				
+				io_pool t_pool{ };
+				
+				if(((system_traits<Ts>::policy == init_policy::worker_thread) || ...))
+					t_pool.start();
+				
+				::std::unique_lock<::std::mutex> t_lock{ m_Mutex };
+				
+				while(true)
+				{
+					bool t_finished{ true };		//< Whether all eager systems are done
+					bool t_running{ false };		//< Whether workers are still busy
+					::std::size_t t_next{ system_count };	//< Next system to initialize on this thread
+					
+					for(::std::size_t t_ix = 0; t_ix < system_count; ++t_ix)
+					{
+						if(policies()[t_ix] == init_policy::lazy || m_States[t_ix] == system_state::done)
+							continue;
+						
+						t_finished = false;
+						
+						if(m_States[t_ix] == system_state::running)
+						{
+							t_running = true;
+							continue;
+						}
+						
+						// Nothing new is started once a system failed
+						if(m_Error || !is_ready(t_ix))
+							continue;
+						
+						if(policies()[t_ix] == init_policy::worker_thread)
+						{
+							m_States[t_ix] = system_state::running;
+							t_running = true;
+							
+							t_pool.post([this, t_ix]() { run_system(t_ix); });
+						}
+						else if(t_next == system_count)
+							t_next = t_ix;
+					}
+					
+					// Running workers reference this object, so they have to finish
+					// before a failure can be reported
+					if(t_finished || (m_Error && !t_running))
+						break;
+					
+					if(t_next != system_count)
+					{
+						m_States[t_next] = system_state::running;
+						
+						t_lock.unlock();
+						run_system(t_next);
+						t_lock.lock();
+					}
+					else if(t_running)
+						m_Changed.wait(t_lock);
+					else
+						throw ::std::runtime_error("global_state_impl: unsatisfiable system dependencies");
+				}
+				
+				const auto t_error = ::std::exchange(m_Error, nullptr);
+				t_lock.unlock();
+				
+				if(t_error)
+					::std::rethrow_exception(t_error);
+				
+				report();
 			}
 			
 			auto shutdown()
@@ -63,7 +192,7 @@ namespace internal
 			{
 				shutdown_impl(reverse_index_type{});
 			}
-			
+		
 		public:
 			auto systems()
 				-> tuple_type&
@@ -71,24 +200,215 @@ namespace internal
 				return m_Systems;
 			}
 			
+			// Retrieve given system, initializing it first if it is lazy
+			template< typename T >
+			auto get()
+				-> T&
+			{
+				if constexpr(system_traits<T>::policy == init_policy::lazy)
+					ensure_initialized(index_of<T, Ts...>::value);
+				
+				return ::std::get<T>(m_Systems);
+			}
+			
+			// Startup timing of all systems. Lazy systems only have a valid entry
+			// once they were accessed.
+			auto startup_report() const
+				-> report_type
+			{
+				::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+				return m_Report;
+			}
+		
 		private:
+			template< typename T >
+			static constexpr auto dependency_mask()
+				-> mask_type
+			{
+				using list_type = typename system_traits<T>::dependencies;
+				
+				if constexpr(::std::is_same_v<list_type, all_previous>)
+					return (mask_type{ 1U } << index_of<T, Ts...>::value) - 1U;
+				else
+					return mask_of(list_type{ });
+			}
+			
+			template< typename... Us >
+			static constexpr auto mask_of(system_list<Us...>)
+				-> mask_type
+			{
+				return (mask_type{ 0U } | ... | (mask_type{ 1U } << index_of<Us, Ts...>::value));
+			}
+			
+			static auto dependencies()
+				-> const ::std::array<mask_type, system_count>&
+			{
+				static constexpr const ::std::array<mask_type, system_count> t_masks{ dependency_mask<Ts>()... };
+				return t_masks;
+			}
+			
+			static auto policies()
+				-> const ::std::array<init_policy, system_count>&
+			{
+				static constexpr const ::std::array<init_policy, system_count> t_policies{ system_traits<Ts>::policy... };
+				return t_policies;
+			}
+			
+			// Whether all eager dependencies of given system are initialized.
+			// Requires the mutex to be held.
+			auto is_ready(::std::size_t p_index) const
+				-> bool
+			{
+				const auto t_deps = dependencies()[p_index];
+				
+				for(::std::size_t t_ix = 0; t_ix < system_count; ++t_ix)
+				{
+					if(!(t_deps & (mask_type{ 1U } << t_ix)) || policies()[t_ix] == init_policy::lazy)
+						continue;
+					
+					if(m_States[t_ix] != system_state::done)
+						return false;
+				}
+				
+				return true;
+			}
+			
+			// Initialize given system and record its timing. Returns the exception
+			// thrown by the system, if any, in which case it is marked as pending
+			// again. Failures of eager systems are also stored to be reported by
+			// initialize().
+			auto run_system(::std::size_t p_index)
+				-> ::std::exception_ptr
+			{
+				const auto t_begin = clock_type::now();
+				::std::exception_ptr t_error{ };
+				
+				try
+				{
+					initialize_system(p_index, index_type{ });
+				}
+				catch(...)
+				{
+					t_error = ::std::current_exception();
+				}
+				
+				const auto t_end = clock_type::now();
+				
+				{
+					::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+					
+					auto& t_record = m_Report[p_index];
+					t_record.m_Initialized = !t_error;
+					t_record.m_Start = t_begin - m_Start;
+					t_record.m_Duration = t_end - t_begin;
+					
+					m_States[p_index] = t_error ? system_state::pending : system_state::done;
+					m_Done[p_index].store(!t_error, ::std::memory_order_release);
+					
+					if(t_error && !m_Error && policies()[p_index] != init_policy::lazy)
+						m_Error = t_error;
+				}
+				
+				m_Changed.notify_all();
+				return t_error;
+			}
+			
 			template< ::std::size_t... Ns >
-			auto initialize_impl(::std::index_sequence<Ns...>)
+			auto initialize_system(::std::size_t p_index, ::std::index_sequence<Ns...>)
+				-> void
+			{
+				((p_index == Ns ? ::std::get<Ns>(m_Systems).initialize() : void()), ...);
+			}
+			
+			// Initialize lazy system on first access. Other threads accessing it
+			// concurrently wait for the initialization to finish, while accesses
+			// from the system itself during initialization are let through.
+			auto ensure_initialized(::std::size_t p_index)
 				-> void
 			{
-				auto x = { (::std::get<Ns>(m_Systems).initialize(), 0)... };
+				if(m_Done[p_index].load(::std::memory_order_acquire))
+					return;
+				
+				{
+					::std::unique_lock<::std::mutex> t_lock{ m_Mutex };
+					
+					if(m_States[p_index] == system_state::running)
+					{
+						if(m_Owners[p_index] == ::std::this_thread::get_id())
+							return;
+						
+						m_Changed.wait(t_lock, [this, p_index]() { return m_States[p_index] != system_state::running; });
+					}
+					
+					if(m_States[p_index] == system_state::done)
+						return;
+					
+					m_States[p_index] = system_state::running;
+					m_Owners[p_index] = ::std::this_thread::get_id();
+				}
+				
+				if(auto t_error = run_system(p_index))
+					::std::rethrow_exception(t_error);
 			}
 			
+			// Log startup timing of all eagerly initialized systems
+			auto report() const
+				-> void
+			{
+				const startup_record::duration_type t_total{ clock_type::now() - m_Start };
+				
+				LOG_I_TAG("global_state") << "initialized global systems in " << t_total.count() << " ms";
+				
+				for(const auto& t_record: m_Report)
+				{
+					if(t_record.m_Policy == init_policy::lazy)
+					{
+						LOG_D_TAG("global_state") << "  " << t_record.m_Name << ": deferred until first use";
+						continue;
+					}
+					
+					LOG_D_TAG("global_state") << "  " << t_record.m_Name << ": " << t_record.m_Duration.count() << " ms, started at "
+						<< t_record.m_Start.count() << " ms" << ((t_record.m_Policy == init_policy::worker_thread) ? " on worker" : "");
+				}
+			}
+			
+			// Only systems that were initialized are shut down
 			template< ::std::size_t... Ns >
 			auto shutdown_impl(::std::index_sequence<Ns...>)
 				-> void
 			{
-				auto x = { (::std::get<Ns>(m_Systems).shutdown(), 0)... };
+				auto x = { (shutdown_system<Ns>(), 0)... };
 			}
 			
+			template< ::std::size_t N >
+			auto shutdown_system()
+				-> void
+			{
+				{
+					::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+					
+					if(m_States[N] != system_state::done)
+						return;
+					
+					m_States[N] = system_state::pending;
+					m_Done[N].store(false, ::std::memory_order_release);
+				}
+				
+				::std::get<N>(m_Systems).shutdown();
+			}
+		
 		private:
 			tuple_type m_Systems;	//< This is default_constructible, since all global
 									//  systems are required to be trivially default
 									//  constructible
+			
+			mutable ::std::mutex m_Mutex;							//< Protects the states, owners and the report
+			::std::condition_variable m_Changed;					//< Signaled when a system finished initialization
+			::std::array<system_state, system_count> m_States{ };
+			::std::array<::std::atomic_bool, system_count> m_Done{ };	//< Fast path for lazy system access
+			::std::array<::std::thread::id, system_count> m_Owners{ };	//< Thread initializing lazy systems
+			::std::exception_ptr m_Error{ };						//< First failure on a worker thread
+			clock_type::time_point m_Start{ };
+			report_type m_Report{ };
 	};
 }
@@ -69,3 +69,38 @@ using is_global_system = ::std::conjunction<
 template< typename T >
 constexpr bool is_global_system_v = is_global_system<T>::value;
 //
+
+
+// Determines on which thread a global system is initialized
+enum class init_policy
+{
+	main_thread,	//< On the thread calling global_state().initialize()
+	worker_thread,	//< On a worker thread, concurrently with independent systems
+	lazy			//< On the first access through global_state<T>()
+};
+
+// List of global systems a system depends on
+template< typename... Ts >
+struct system_list
+{
+};
+
+// Dependency on all systems listed before the system in the global state
+struct all_previous
+{
+};
+
+// Describes how a global system is initialized. A system is only initialized
+// once all of its dependencies are. Lazy dependencies do not delay
+// initialization, since they are initialized on first access.
+//
+// The defaults keep the system in initialization order on the main thread.
+// Specialize this to allow systems to be initialized concurrently.
+template< typename T >
+struct system_traits
+{
+	using dependencies = all_previous;
+	
+	static constexpr const init_policy policy = init_policy::main_thread;
+	static constexpr const char* name = "global_system";
+};
@@ -0,0 +1,92 @@
+// Cache of decoded and canonicalized glyph sheets. Decoding PNG files and
+// converting them to RGBA8 is comparatively expensive, so the result is stored
+// in the user directory and memory mapped on subsequent runs. Cache entries are
+// validated using the stamp of the source image.
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+
+#include "file_stamp.hxx"
+
+namespace boost::interprocess
+{
+	class mapped_region;
+}
+
+namespace internal
+{
+	// Header of a glyph cache file. The pixel data follows immediately.
+	struct glyph_cache_header
+	{
+		::std::uint64_t m_Magic;
+		::std::uint32_t m_Version;
+		::std::uint32_t m_Width;			//< Image width, in pixels
+		::std::uint32_t m_Height;			//< Image height, in pixels
+		::std::uint32_t m_Reserved;
+		::std::uint64_t m_SourceSize;		//< Stamp of the source image
+		::std::int64_t m_SourceTime;		//
+		::std::uint64_t m_SourceHash;		//
+	};
+}
+
+// A memory mapped, canonicalized RGBA8 image from the glyph cache
+class glyph_cache_entry
+{
+	using region_type = boost::interprocess::mapped_region;
+
+	public:
+		glyph_cache_entry(::std::unique_ptr<region_type> p_region);
+		~glyph_cache_entry();
+		
+		glyph_cache_entry(const glyph_cache_entry&) = delete;
+		glyph_cache_entry& operator=(const glyph_cache_entry&) = delete;
+		
+	public:
+		auto width() const
+			-> int;
+			
+		auto height() const
+			-> int;
+			
+		// Pointer to the pixel data inside the mapped file
+		auto pixels() const
+			-> const void*;
+			
+		auto header() const
+			-> const internal::glyph_cache_header&;
+			
+	private:
+		::std::unique_ptr<region_type> m_Region;
+};
+
+class glyph_cache
+{
+	using path_type = boost::filesystem::path;
+
+	public:
+		static constexpr ::std::uint64_t magic = 0x434850594C475341ULL; // "ASGLYPHC"
+		static constexpr ::std::uint32_t version = 1U;
+
+	public:
+		explicit glyph_cache(const path_type& p_directory);
+		
+	public:
+		// Retrieve cached image for given source file. Returns an empty pointer
+		// if there is no entry or it does not match the source stamp.
+		auto load(const path_type& p_source, const file_stamp& p_stamp) const
+			-> ::std::unique_ptr<glyph_cache_entry>;
+			
+		// Store canonicalized RGBA8 image data for given source file
+		auto store(const path_type& p_source, const file_stamp& p_stamp, int p_width, int p_height, int p_pitch, const void* p_pixels) const
+			-> void;
+			
+	private:
+		auto entry_path(const path_type& p_source) const
+			-> path_type;
+			
+	private:
+		path_type m_Directory;	//< Directory containing the cache files
+};
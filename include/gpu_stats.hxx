@@ -0,0 +1,25 @@
+// Counters of data transferred to the GPU. Every buffer or texture upload
+// records its size here, so tools can measure the upload cost of a frame by
+// comparing the counters before and after it. Counters are never reset.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gpu_stats
+{
+	using counter_type = ::std::uint64_t;
+	
+	// Record an upload of given size. Can be called from any thread.
+	auto record_upload(::std::size_t p_bytes)
+		-> void;
+		
+	// Total number of bytes uploaded so far
+	auto uploaded_bytes()
+		-> counter_type;
+		
+	// Total number of upload calls so far
+	auto upload_count()
+		-> counter_type;
+}
@@ -1,9 +1,16 @@
 #pragma once
 
-#include <unordered_set>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <optional>
 
+#include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
 #include "global_system.hxx"
+#include "capi/input.h"
+
+using input_event = input_event_t;
 
 class input_manager
 	: public global_system
@@ -11,34 +18,84 @@ class input_manager
 	// GLFW uses int to represent a key.
 	using key_type = int;
 	using action_type = int;
-
+	using key_set = ::std::bitset<GLFW_KEY_LAST + 1>;
+	using size_type = ::std::size_t;
+	
+	public:
+		// Maximum number of events kept between two drains
+		static constexpr const size_type event_capacity = 1024U;
+	
 	public:
 		auto initialize()
 			-> void;
-			
+	
 	public:
 		// This should be called at the very beginning of every frame.
 		auto begin_input()
 			-> void;
-	
+		
 		// This should be called at the end of every frame.
 		auto end_input()
 			-> void;
-			
+		
 		// Query whether given key is pressed or not.
 		// This uses the symbolic key name provided by GLFW.
-		auto has_key(key_type p_key)
+		auto has_key(key_type p_key) const
 			-> bool;
-			
+		
+		// Move up to given number of pending events, oldest first, into given
+		// array. Returns the number of events moved.
+		auto drain_events(input_event* p_events, size_type p_capacity)
+			-> size_type;
+		
+		auto pending_events() const
+			-> size_type;
+		
+		// Number of events discarded because the queue was full. Once full, the
+		// oldest events are discarded first.
+		auto dropped_events() const
+			-> ::std::uint64_t;
+	
 	public:
-		auto process_key(key_type p_key, action_type p_action)
+		auto process_key(key_type p_key, action_type p_action, int p_mods)
+			-> void;
+		
+		auto process_text(unsigned p_codepoint)
+			-> void;
+		
+		auto process_cursor(double p_x, double p_y)
+			-> void;
+		
+		auto process_wheel(double p_x, double p_y)
 			-> void;
-			
+	
 	private:
-		::std::unordered_set<key_type> keyDown;
-		::std::unordered_set<key_type> keyRepeated;
+		// Create event of given type, stamped with the current time
+		auto make_event(::std::uint32_t p_type) const
+			-> input_event;
+		
+		auto push_event(const input_event& p_event)
+			-> void;
+	
+	private:
+		key_set m_KeyDown;									//< Keys pressed this frame
+		key_set m_KeyRepeated;								//< Keys held down long enough to repeat
+		::std::array<input_event, event_capacity> m_Events;	//< Ring buffer of pending events
+		size_type m_First{0U};								//< Index of oldest pending event
+		size_type m_Count{0U};								//< Number of pending events
+		::std::uint64_t m_Dropped{0U};
+		::std::optional<glm::ivec2> m_Cursor;				//< Last reported cell under the cursor
 };
 
-// Callback functions that will be called by GLFW on key events
+// Callback functions that will be called by GLFW on input events
 auto key_callback(GLFWwindow* p_window, int p_key, int p_scancode, int p_action, int p_mods)
 	-> void;
+
+auto char_callback(GLFWwindow* p_window, unsigned int p_codepoint)
+	-> void;
+
+auto cursor_callback(GLFWwindow* p_window, double p_x, double p_y)
+	-> void;
+
+auto scroll_callback(GLFWwindow* p_window, double p_x, double p_y)
+	-> void;
@@ -0,0 +1,51 @@
+// A small pool of worker threads used to perform blocking I/O and decoding work
+// off the main thread.
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+class io_pool
+{
+	using task_type = ::std::function<void()>;
+
+	public:
+		io_pool() = default;
+		~io_pool();
+		
+		io_pool(const io_pool&) = delete;
+		io_pool& operator=(const io_pool&) = delete;
+		
+	public:
+		// Start given number of worker threads. A count of zero selects a count
+		// based on the available hardware concurrency.
+		auto start(::std::size_t p_count = 0U)
+			-> void;
+		
+		// Stop all workers. Tasks that have not been started yet are discarded.
+		auto stop()
+			-> void;
+			
+		// Enqueue task to be executed on one of the worker threads
+		auto post(task_type p_task)
+			-> void;
+			
+		auto is_running() const
+			-> bool;
+			
+	private:
+		auto run()
+			-> void;
+			
+	private:
+		mutable ::std::mutex m_Mutex;			//< Protects the task queue and the running flag
+		::std::condition_variable m_Condition;	//< Signaled when new tasks arrive or the pool is stopped
+		::std::deque<task_type> m_Tasks;		//< Pending tasks
+		::std::vector<::std::thread> m_Workers;	//< Worker threads
+		bool m_Running{false};					//< Whether workers should keep waiting for tasks
+};
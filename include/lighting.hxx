@@ -8,6 +8,7 @@
 #include <type_traits>
 #include <vector>
 #include <array>
+#include <cstdint>
 #include <GLXW/glxw.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -60,6 +61,7 @@ class light_manager
 	public:
 		using handle_type = ::std::size_t;
 		using size_type = ::std::uint32_t;
+		using buffer_type = ::std::array<::std::uint8_t, buffer_size>;	//< Contents of the GPU buffer
 	
 	public:
 		light_manager() = default;
@@ -79,6 +81,16 @@ class light_manager
 		// Sync buffer on GPU with state contained in this object
 		void sync();
 		
+		// Write GPU buffer contents for the current state into given buffer.
+		// This does not touch the GPU, and is used to hand the lighting state
+		// to the render thread.
+		void pack(buffer_type& p_buffer) const;
+		
+		// Replace contents of the GPU buffer with given data. This only uses
+		// the buffer handle, and can therefore be called on the render thread
+		// while the state is modified on another thread.
+		void upload(const buffer_type& p_buffer) const;
+		
 		// Create new light from given template and return handle.
 		// Will throw if no space is left.
 		handle_type create_light(const light& p_light);
@@ -101,6 +113,12 @@ class light_manager
 		// Checks if there is enough space left for N lights
 		bool has_space(::std::size_t p_amount = 1U) const;
 		
+		// Retrieve current lighting state without marking it as modified
+		const lighting_state& state() const;
+		
+		// Retrieve number of active lights
+		size_type light_count() const;
+		
 	private:
 		// Check if handle is in bounds
 		bool check_handle(handle_type) const;
@@ -1,25 +1,144 @@
 #pragma once
 
+#include <mutex>
+#include <atomic>
 #include <memory>
+#include <string>
+#include <thread>
+#include <sstream>
+#include <cstdint>
+#include <condition_variable>
 #include <log.hxx>
 #include "global_system.hxx"
 #include "commandline.hxx"
+#include "log_queue.hxx"
+#include "trace_log.hxx"
 
+enum class log_mode
+{
+	sync,	//< Messages are written on the posting thread
+	async	//< Messages are queued and written by a background thread
+};
 
 class log_manager	//< Manage liblog targets and configuration
 	: public global_system
 {
 	using console_target = lg::console_target<lg::clang_formatter>;
 	using file_target = lg::file_target<>;
+	using queue_type = mpsc_ring<log_record>;
+	
+	public:
+		using counter_type = ::std::uint64_t;
+		
+		// Number of records the queue can hold in asynchronous mode
+		static constexpr const ::std::size_t queue_capacity = 8192U;
 	
 	public:
 		auto initialize()
 			-> void;
-			
+		
 		auto shutdown()
 			-> void;
-
+	
+	public:
+		// Post given record. In asynchronous mode this only enqueues the record,
+		// unless the queue is full and the overflow policy says otherwise.
+		// Fatal messages are always written synchronously, after all queued
+		// messages, since the application is likely to terminate right after.
+		auto post(log_record p_record)
+			-> void;
+		
+		// Wait until all messages posted so far have been written
+		auto flush()
+			-> void;
+		
+		auto mode() const
+			-> log_mode;
+		
+		auto overflow_policy() const
+			-> log_overflow_policy;
+		
+		auto set_overflow_policy(log_overflow_policy p_policy)
+			-> void;
+		
+		// Number of messages discarded because the queue was full
+		auto dropped() const
+			-> counter_type;
+	
+	private:
+		// Write record to the liblog targets on the calling thread
+		auto write(log_record& p_record)
+			-> void;
+		
+		// Enqueue record for the worker, applying the overflow policy
+		auto enqueue(log_record& p_record)
+			-> void;
+		
+		// Background thread draining the queue
+		auto run()
+			-> void;
+		
+		auto start_worker()
+			-> void;
+		
+		auto stop_worker()
+			-> void;
+	
 	private:
 		::std::unique_ptr<console_target> m_Console{ };
 		::std::unique_ptr<file_target> m_File{ };
+		::std::unique_ptr<trace_log> m_Trace{ };			//< Binary trace log, if enabled
+		
+		log_mode m_Mode{log_mode::sync};
+		::std::atomic<log_overflow_policy> m_Policy{log_overflow_policy::drop};
+		::std::unique_ptr<queue_type> m_Queue{ };		//< Pending records, in asynchronous mode
+		::std::thread m_Worker{ };						//< Thread draining the queue
+		::std::atomic_bool m_Running{false};			//< Whether the worker should keep draining
+		::std::atomic<counter_type> m_Producers{0U};	//< Number of threads currently in post
+		::std::atomic<counter_type> m_Posted{0U};		//< Number of records enqueued
+		::std::atomic<counter_type> m_Written{0U};		//< Number of enqueued records written by the worker
+		::std::atomic<counter_type> m_Dropped{0U};		//< Number of records discarded due to overflow
+		::std::mutex m_WaitMutex;						//< Only used to sleep on the condition variables
+		::std::condition_variable m_Wakeup;				//< Wakes the worker before its polling interval ends
+		::std::condition_variable m_Drained;			//< Signaled by the worker after writing records
+};
+
+
+// Formats a message using stream syntax and posts it to the log manager once
+// the full expression ends. Unlike the LOG_*_TAG macros, this does not write to
+// the targets on the calling thread in asynchronous mode, which is why threads
+// that should not wait for console or file I/O use it, see LOG_POST_TAG.
+class log_stream
+{
+	public:
+		log_stream(lg::severity_level p_level, const char* p_tag)
+			:	m_Level{p_level},
+				m_Tag{p_tag}
+		{
+		}
+		
+		~log_stream();
+		
+		log_stream(const log_stream&) = delete;
+		log_stream& operator=(const log_stream&) = delete;
+	
+	public:
+		template< typename T >
+		auto operator<<(const T& p_value)
+			-> log_stream&
+		{
+			m_Stream << p_value;
+			return *this;
+		}
+	
+	private:
+		lg::severity_level m_Level;
+		const char* m_Tag;				//< Message tag, has to outlive this object
+		::std::ostringstream m_Stream;	//< Message text
 };
+
+#define LOG_POST_TAG(lvl, tag) log_stream{ lvl, tag }
+#define LOG_POST_D_TAG(tag) LOG_POST_TAG(lg::severity_level::debug, tag)
+#define LOG_POST_I_TAG(tag) LOG_POST_TAG(lg::severity_level::info, tag)
+#define LOG_POST_W_TAG(tag) LOG_POST_TAG(lg::severity_level::warning, tag)
+#define LOG_POST_E_TAG(tag) LOG_POST_TAG(lg::severity_level::error, tag)
@@ -0,0 +1,181 @@
+// Lock-free queue used by the asynchronous logging backend.
+//
+// Log records are pushed by any number of producer threads and drained by a
+// single background thread. Producers never take a lock, so threads emitting
+// log messages never wait for console or file I/O.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <log.hxx>
+
+// What to do with records when the queue is full
+enum class log_overflow_policy
+{
+	drop,			//< Discard the new record and count it as dropped
+	block,			//< Wait until the background thread made room
+	write_through	//< Write the record synchronously on the posting thread
+};
+
+// A single log message. The message text is formatted by the posting thread,
+// so the background thread only has to write it to the targets.
+class log_record
+{
+	public:
+		log_record() = default;
+		
+		log_record(lg::severity_level p_level, ::std::string p_tag, ::std::string p_message, bool p_bare = false)
+			:	m_Level{p_level},
+				m_Bare{p_bare},
+				m_Tag{ ::std::move(p_tag) },
+				m_Message{ ::std::move(p_message) }
+		{
+		}
+	
+	public:
+		auto level() const
+			-> lg::severity_level
+		{
+			return m_Level;
+		}
+		
+		auto is_bare() const
+			-> bool
+		{
+			return m_Bare;
+		}
+		
+		auto tag() const
+			-> const ::std::string&
+		{
+			return m_Tag;
+		}
+		
+		auto message() const
+			-> const ::std::string&
+		{
+			return m_Message;
+		}
+	
+	private:
+		lg::severity_level m_Level{lg::severity_level::info};
+		bool m_Bare{false};				//< Whether the message is printed without prefix
+		::std::string m_Tag;			//< Message tag, might be empty
+		::std::string m_Message;		//< Formatted message text
+};
+
+
+// Bounded multi-producer, single-consumer ring buffer. Every slot carries a
+// sequence number telling producers and the consumer whose turn it is, so
+// neither side ever takes a lock.
+template< typename T >
+class mpsc_ring
+{
+	using sequence_type = ::std::size_t;
+	using difference_type = ::std::ptrdiff_t;
+	
+	public:
+		using size_type = ::std::size_t;
+		using value_type = T;
+	
+	public:
+		// Capacity is rounded up to the next power of two
+		explicit mpsc_ring(size_type p_capacity)
+		{
+			size_type t_capacity{ 2U };
+			
+			while(t_capacity < p_capacity)
+				t_capacity <<= 1U;
+			
+			m_Mask = t_capacity - 1U;
+			m_Slots = ::std::make_unique<slot[]>(t_capacity);
+			
+			for(size_type t_ix = 0; t_ix < t_capacity; ++t_ix)
+				m_Slots[t_ix].m_Sequence.store(t_ix, ::std::memory_order_relaxed);
+		}
+		
+		mpsc_ring(const mpsc_ring&) = delete;
+		mpsc_ring& operator=(const mpsc_ring&) = delete;
+	
+	public:
+		// Try to enqueue given value. Returns false if the ring is full, in which
+		// case the value is left untouched. Safe to call from any thread.
+		auto try_push(value_type& p_value)
+			-> bool
+		{
+			auto t_pos = m_Head.load(::std::memory_order_relaxed);
+			slot* t_slot{ nullptr };
+			
+			while(true)
+			{
+				t_slot = &m_Slots[t_pos & m_Mask];
+				
+				const auto t_seq = t_slot->m_Sequence.load(::std::memory_order_acquire);
+				const auto t_diff = static_cast<difference_type>(t_seq) - static_cast<difference_type>(t_pos);
+				
+				if(t_diff == 0)
+				{
+					// Slot is free, try to claim it
+					if(m_Head.compare_exchange_weak(t_pos, t_pos + 1U, ::std::memory_order_relaxed))
+						break;
+				}
+				else if(t_diff < 0)
+				{
+					// Slot still holds a value from the previous lap
+					return false;
+				}
+				else
+				{
+					// Another producer claimed this slot first
+					t_pos = m_Head.load(::std::memory_order_relaxed);
+				}
+			}
+			
+			t_slot->m_Value = ::std::move(p_value);
+			t_slot->m_Sequence.store(t_pos + 1U, ::std::memory_order_release);
+			
+			return true;
+		}
+		
+		// Try to dequeue a value. Must only be called by the consumer thread.
+		auto try_pop(value_type& p_value)
+			-> bool
+		{
+			auto& t_slot = m_Slots[m_Tail & m_Mask];
+			
+			if(t_slot.m_Sequence.load(::std::memory_order_acquire) != m_Tail + 1U)
+				return false;
+			
+			p_value = ::std::move(t_slot.m_Value);
+			
+			// Hand slot back to the producers for the next lap
+			t_slot.m_Sequence.store(m_Tail + m_Mask + 1U, ::std::memory_order_release);
+			++m_Tail;
+			
+			return true;
+		}
+		
+		auto capacity() const
+			-> size_type
+		{
+			return m_Mask + 1U;
+		}
+	
+	private:
+		struct slot
+		{
+			::std::atomic<sequence_type> m_Sequence{0U};
+			value_type m_Value{ };
+		};
+	
+	private:
+		::std::unique_ptr<slot[]> m_Slots;
+		size_type m_Mask{0U};
+		alignas(64) ::std::atomic<sequence_type> m_Head{0U};	//< Next position to be claimed by a producer
+		alignas(64) sequence_type m_Tail{0U};					//< Next position to be read by the consumer
+};
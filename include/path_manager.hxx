@@ -18,6 +18,23 @@ class path_manager
 		auto config_path() const
 			-> const path_type&;
 			
+		// Returns the path to the binary configuration snapshot, which is
+		// stored alongside the configuration file.
+		auto config_cache_path() const
+			-> const path_type&;
+			
+		// Returns the directory used to cache decoded glyph sheets
+		auto glyph_cache_path() const
+			-> const path_type&;
+			
+		// Returns the directory used to cache shader program binaries
+		auto shader_cache_path() const
+			-> const path_type&;
+			
+		// Returns the directory containing persistent worlds
+		auto world_path() const
+			-> const path_type&;
+			
 		// Returns the path to the games asset folder. This will always prioritize
 		// asset folders present in the working directory.
 		auto data_path() const
@@ -49,6 +66,10 @@ class path_manager
 	private:
 		path_type m_UserPath;
 		path_type m_ConfigPath;
+		path_type m_ConfigCachePath;
+		path_type m_GlyphCachePath;
+		path_type m_ShaderCachePath;
+		path_type m_WorldPath;
 		path_type m_DataPath;
 		
 };
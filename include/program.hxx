@@ -1,8 +1,13 @@
 #pragma once
 
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
 #include <stdexcept>
 #include <GLXW/glxw.h>
 #include <ut/format.hxx>
+#include <ut/string_view.hxx>
 #include "shader.hxx"
 
 
@@ -11,6 +16,22 @@ namespace gl
 	struct defer_creation_t{ };
 	
 	constexpr defer_creation_t defer_creation{ };
+	
+	namespace internal
+	{
+		struct from_binary_t
+		{
+		};
+	}
+	
+	constexpr internal::from_binary_t from_binary{ };
+	
+	// Driver-specific binary representation of a linked program
+	struct program_binary
+	{
+		GLenum m_Format{ };				//< Driver-specific binary format
+		::std::vector<char> m_Data;		//< Binary data
+	};
 
 	// Shader program abstraction
 	class program final
@@ -38,6 +59,20 @@ namespace gl
 			{
 			}
 			
+			// Create program from binary previously retrieved using binary().
+			// This will throw if the driver rejects the binary, for example
+			// because the driver was updated in the meantime.
+			program(internal::from_binary_t, const program_binary& p_binary)
+				: program()
+			{
+				glProgramBinary(m_Handle, p_binary.m_Format, p_binary.m_Data.data(), static_cast<GLsizei>(p_binary.m_Data.size()));
+				
+				if(query(GL_LINK_STATUS) == GL_FALSE)
+					throw shader_exception("Failed to load program binary!", info_log());
+					
+				reflect_uniforms();
+			}
+			
 		public:
 			~program()
 			{
@@ -57,6 +92,7 @@ namespace gl
 				: m_Handle{ }
 			{
 				::std::swap(this->m_Handle, p_prog.m_Handle);
+				::std::swap(this->m_Uniforms, p_prog.m_Uniforms);
 			}
 			
 			program& operator=(program&& p_prog)
@@ -65,8 +101,10 @@ namespace gl
 					glDeleteProgram(this->m_Handle);
 					
 				this->m_Handle = { };
+				this->m_Uniforms.clear();
 			
 				::std::swap(this->m_Handle, p_prog.m_Handle);
+				::std::swap(this->m_Uniforms, p_prog.m_Uniforms);
 			
 				return *this;
 			}
@@ -83,10 +121,56 @@ namespace gl
 			auto link()
 				-> void
 			{
+				// Allow the linked program to be retrieved as binary for caching
+				glProgramParameteri(m_Handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			
 				glLinkProgram(m_Handle);
 				
 				if(query(GL_LINK_STATUS) == GL_FALSE)
 					throw shader_exception("Failed to link shader program!", info_log());
+					
+				reflect_uniforms();
+			}
+			
+			// Retrieve location of uniform with given name. Returns -1 if
+			// the program does not contain an active uniform with that name.
+			// Callers setting a uniform every frame should retrieve the location
+			// once and keep it.
+			auto uniform_location(ut::string_view p_name) const
+				-> GLint
+			{
+				const auto t_it = ::std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), p_name,
+					[](const uniform_entry& p_entry, ut::string_view p_key)
+					{
+						return p_entry.first.compare(0U, ::std::string::npos, p_key.data(), p_key.size()) < 0;
+					}
+				);
+				
+				if(t_it == m_Uniforms.end() || t_it->first.compare(0U, ::std::string::npos, p_name.data(), p_name.size()) != 0)
+					return -1;
+				
+				return t_it->second;
+			}
+			
+			// Retrieve binary representation of this program. The returned data
+			// is empty if the driver does not support program binaries.
+			auto binary() const
+				-> program_binary
+			{
+				program_binary t_binary{ };
+				
+				const auto t_len = query(GL_PROGRAM_BINARY_LENGTH);
+				
+				if(t_len <= 0)
+					return t_binary;
+					
+				t_binary.m_Data.resize(t_len);
+				
+				GLsizei t_written{ };
+				glGetProgramBinary(m_Handle, t_len, &t_written, &t_binary.m_Format, t_binary.m_Data.data());
+				t_binary.m_Data.resize(t_written);
+				
+				return t_binary;
 			}
 			
 			auto handle() const
@@ -131,7 +215,49 @@ namespace gl
 				return{ t_buf.begin(), t_buf.end() };		
 			}
 	
+		private:
+			// Build uniform location cache by enumerating all active uniforms
+			auto reflect_uniforms()
+				-> void
+			{
+				m_Uniforms.clear();
+			
+				const auto t_count = query(GL_ACTIVE_UNIFORMS);
+				::std::vector<char> t_buf(query(GL_ACTIVE_UNIFORM_MAX_LENGTH) + 1);
+				
+				for(GLint t_ix = 0; t_ix < t_count; ++t_ix)
+				{
+					GLsizei t_len{ };
+					GLint t_size{ };
+					GLenum t_type{ };
+					
+					glGetActiveUniform(m_Handle, t_ix, t_buf.size(), &t_len, &t_size, &t_type, t_buf.data());
+					
+					::std::string t_name{ t_buf.data(), static_cast<::std::size_t>(t_len) };
+					
+					// Uniforms inside of blocks don't have a location
+					const auto t_loc = glGetUniformLocation(m_Handle, t_name.c_str());
+					
+					if(t_loc == -1)
+						continue;
+					
+					// Arrays are reported as "name[0]", but are also accessible as "name"
+					if(t_name.size() > 3U && t_name.compare(t_name.size() - 3U, 3U, "[0]") == 0)
+						m_Uniforms.emplace_back(t_name.substr(0, t_name.size() - 3U), t_loc);
+						
+					m_Uniforms.emplace_back(::std::move(t_name), t_loc);
+				}
+				
+				// Programs only have a handful of uniforms, so a sorted vector allows
+				// lookups by string view without allocating a key
+				::std::sort(m_Uniforms.begin(), m_Uniforms.end());
+			}
+	
+		private:
+			using uniform_entry = ::std::pair<::std::string, GLint>;
+	
 		private:
 			GLuint m_Handle{ };
+			::std::vector<uniform_entry> m_Uniforms;	//< Uniform location cache sorted by name, built at link time
 	};
 }
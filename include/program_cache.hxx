@@ -0,0 +1,67 @@
+// Creates shader programs from source files, using an on-disk cache of program
+// binaries to avoid recompilation on subsequent runs. Cache entries are keyed
+// by a hash of the shader sources and validated against the driver, since
+// binaries are only valid for the exact driver that created them.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <boost/filesystem.hpp>
+
+#include "program.hxx"
+
+namespace internal
+{
+	// Header of a program cache file. The binary data follows immediately.
+	struct program_cache_header
+	{
+		::std::uint64_t m_Magic;
+		::std::uint32_t m_Version;
+		::std::uint32_t m_Format;		//< Driver-specific binary format
+		::std::uint64_t m_SourceHash;	//< Hash of all shader sources
+		::std::uint64_t m_DriverHash;	//< Hash of vendor, renderer and version strings
+		::std::uint64_t m_Length;		//< Length of binary data, in bytes
+	};
+}
+
+class program_cache
+{
+	using path_type = boost::filesystem::path;
+
+	public:
+		static constexpr ::std::uint64_t magic = 0x4E49424752505341ULL; // "ASPRGBIN"
+		static constexpr ::std::uint32_t version = 1U;
+
+	public:
+		// Requires an active render context
+		explicit program_cache(const path_type& p_directory);
+		
+	public:
+		// Create program from given vertex and fragment shader source files.
+		// If the cache contains a binary for the exact same sources and driver,
+		// it is used instead of compiling the shaders.
+		//
+		// The given preprocessor symbols are defined in both shaders, right after
+		// the version directive. This allows building specialized variants of
+		// the same sources.
+		auto load(const path_type& p_vertex, const path_type& p_fragment, const ::std::vector<::std::string>& p_defines = { }) const
+			-> gl::program;
+			
+	private:
+		auto entry_path(::std::uint64_t p_sourceHash) const
+			-> path_type;
+			
+		auto load_binary(::std::uint64_t p_sourceHash) const
+			-> ::std::optional<gl::program_binary>;
+			
+		auto store_binary(::std::uint64_t p_sourceHash, const gl::program_binary& p_binary) const
+			-> void;
+			
+	private:
+		path_type m_Directory;			//< Directory containing the cache files
+		::std::uint64_t m_DriverHash;	//< Identifies the current driver
+		bool m_Supported;				//< Whether the driver supports program binaries
+};
@@ -40,12 +40,27 @@ class render_context
 		auto should_close() const
 			-> bool;
 
+		// Clear and present the frame. Both do nothing while the context is
+		// detached, since frames are then presented by the render thread.
 		auto begin_frame()
 			-> void;
 			
 		auto end_frame()
 			-> void;
 			
+		// Release the GL context from the calling thread, so it can be made
+		// current on the render thread. Resizing the window then no longer
+		// changes the viewport, which is left to the render thread.
+		auto detach_context()
+			-> void;
+			
+		// Make the GL context current on the calling thread again
+		auto attach_context()
+			-> void;
+			
+		auto is_detached() const
+			-> bool;
+			
 	private:
 		auto init_glfw()
 			-> void;
@@ -63,5 +78,6 @@ class render_context
 		bool m_Initialized{false}; //< This is only used to safely destruct objects of this type
 		handle_type m_WindowHandle{};
 		dimension_type m_WindowSize{100, 100};
+		bool m_Detached{false};		//< Whether the context is owned by the render thread
 };
 
@@ -1,18 +1,102 @@
 #pragma once
 
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <exception>
 #include "screen.hxx"
+#include "lighting.hxx"
+#include "frame_handoff.hxx"
+#include "world_viewport.hxx"
 #include "uniform.hxx"
 #include "program.hxx"
 #include "texture_set.hxx"
 #include "render_context.hxx"
 #include "empty_vbo.hxx"
+#include "frame_constants.hxx"
 #include "global_system.hxx"
 
+// Optional shader features that can be compiled out of the main program.
+// A variant is described by a combination of these flags.
+namespace shader_variant
+{
+	using mask_type = ::std::uint32_t;
+	
+	constexpr const mask_type full = 0x0U;					//< All features enabled
+	constexpr const mask_type no_lighting = 0x1U;			//< No lighting at all
+	constexpr const mask_type no_dynamic_lighting = 0x2U;	//< Only ambient lighting
+	constexpr const mask_type no_shadows = 0x4U;			//< No drop shadows
+	constexpr const mask_type no_fog = 0x8U;				//< No fog
+}
+
+
+// A single screen layer. Layers are drawn on top of each other in ascending
+// z order, and each of them only uploads its cells if they were modified.
+// In all layers except the base layer, cells with glyph 0 and black colors
+// are transparent. World layers show a scrollable part of a world grid
+// instead of their own cells.
+struct screen_layer
+{
+	using offset_type = glm::ivec2;
+
+	screen_manager m_Screen;		//< Cells of this layer, if it is not a world layer
+	::std::unique_ptr<world_viewport> m_Viewport;	//< Viewport of world layers
+	offset_type m_Offset{};			//< Position of top left cell on screen, in glyphs
+	int m_ZOrder{0};				//< Layers with higher z order are drawn on top
+	bool m_Visible{true};			//< Whether this layer is drawn at all
+};
+
+// Snapshot of everything required to draw a frame. In threaded mode, the game
+// thread fills it and hands it to the render thread, which only ever reads
+// snapshots and never touches the live screen, world or light state.
+struct render_frame
+{
+	using layer_id = ::std::uint32_t;
+	using revision_type = ::std::uint64_t;
+
+	// Cells of a single layer. Snapshots are reused, so the cells are only
+	// copied if the layer was modified since this snapshot was last filled.
+	struct layer_cells
+	{
+		revision_type m_Revision{0U};	//< Revision of the layer the cells were copied at
+		glm::uvec2 m_Dims{};			//< Dimensions of the layer, in glyphs
+		::std::vector<cell> m_Cells;	//< All cells, in row-major order
+		screen_contents m_Contents{ };	//< Features used by the cells
+	};
+	
+	// Draw call of a visible layer, in drawing order
+	struct layer_draw
+	{
+		layer_id m_Id;
+		glm::ivec2 m_Offset;
+		bool m_Transparent;
+		shader_variant::mask_type m_Variant;	//< Selected on the game thread, since it depends on the light state
+	};
+	
+	frame_constants m_Constants{ };
+	light_manager::buffer_type m_Lights{ };			//< Packed contents of the light buffer
+	float m_Scale{1.f};
+	glm::uvec2 m_Window{ };							//< Window size, in pixels
+	::std::map<layer_id, layer_cells> m_Cells;		//< Cells of all layers that were visible at some point
+	::std::vector<layer_draw> m_Draws;
+};
+
 class render_manager
 	: public global_system
 {
 	using dimension_type = glm::uvec2;
+	using offset_type = screen_layer::offset_type;
 	using handle_type = render_context::handle_type;
+	
+	public:
+		using layer_id = ::std::uint32_t;
+		
+		// The base layer always exists, covers the whole screen and is opaque
+		static constexpr const layer_id base_layer = 0U;
 
 	public:
 		render_manager() = default;
@@ -21,23 +105,184 @@ class render_manager
 	public:
 		auto initialize()
 			-> void;
+			
+		auto shutdown()
+			-> void;
 		
-	public:		
+	public:
+		// Retrieve the base layer
 		auto screen()
 			-> screen_manager&;
 			
+		// Create a new layer with given dimensions. Among layers with the same
+		// z order, newer layers are drawn on top.
+		auto create_layer(const dimension_type& p_dims, const offset_type& p_offset = { }, int p_zOrder = 0)
+			-> layer_id;
+			
+		// Create a new layer showing given world through a viewport with given
+		// dimensions. The lowest visible world layer also determines the world
+		// position used for lighting.
+		auto create_world_layer(::std::shared_ptr<world_grid> p_world, const dimension_type& p_dims, const offset_type& p_offset = { }, int p_zOrder = 0)
+			-> layer_id;
+			
+		auto destroy_layer(layer_id p_id)
+			-> void;
+			
+		// Retrieve cells of given layer. Throws for world layers.
+		auto layer(layer_id p_id)
+			-> screen_manager&;
+			
+		// Retrieve viewport of given world layer
+		auto viewport(layer_id p_id)
+			-> world_viewport&;
+			
+		auto set_layer_offset(layer_id p_id, const offset_type& p_offset)
+			-> void;
+			
+		auto set_layer_z_order(layer_id p_id, int p_zOrder)
+			-> void;
+			
+		auto set_layer_visible(layer_id p_id, bool p_visible)
+			-> void;
+			
 		auto render()
 			-> void;
+			
+		// Retrieve per-frame shader constants, like fog parameters, for modification.
+		// They are uploaded on the next call to render().
+		auto modify_frame_constants()
+			-> frame_constants&;
+			
+		// Set factor the output is scaled by. Integral factors result in crisp,
+		// pixel-exact upscaling, while fractional factors are filtered.
+		auto set_scale(float p_scale)
+			-> void;
+			
+		auto scale() const
+			-> float;
+			
+		// Whether frames are drawn by a dedicated render thread. This is
+		// enabled by the graphics.render_thread configuration entry, and the
+		// thread is started on the first call to render(). From then on,
+		// render() only publishes a snapshot of the current frame, and the
+		// render thread owns the GL context. Assets with GPU data then have to
+		// be loaded asynchronously.
+		auto is_threaded() const
+			-> bool;
+			
+		// Stop render thread, if running, and make the GL context current on the
+		// calling thread again. Later frames are drawn on the calling thread.
+		auto stop_render_thread()
+			-> void;
+			
+		// Number of published frames the render thread did not get to draw
+		auto skipped_frames() const
+			-> ::std::uint64_t;
+	
+	private:
+		// GPU copy of a layer, owned by the render thread
+		struct gpu_layer
+		{
+			GLuint m_Buffer{0};
+			GLuint m_Texture{0};
+			render_frame::revision_type m_Revision{0U};	//< Revision of the uploaded cells
+		};
+		
+		// Program of a shader variant, with the locations of all uniforms that
+		// are set for every drawn layer
+		struct variant_program
+		{
+			explicit variant_program(gl::program&& p_program);
+		
+			gl::program m_Program;
+			GLint m_LayerOffset{-1};
+			GLint m_LayerSize{-1};
+			GLint m_LayerTransparent{-1};
+			GLint m_LayerScroll{-1};
+			GLint m_LayerRing{-1};
+		};
+		
+		using visible_list = ::std::vector<::std::pair<layer_id, screen_layer*>>;
 	
 	private:
 		auto set_uniforms()
 			-> void;
+			
+		// Returns size of the rendered image before scaling, in pixels
+		auto logical_size() const
+			-> dimension_type;
+			
+		// Resize window and select sampler filters for the current scale
+		auto apply_scale()
+			-> void;
+			
+		// Select sampler filters for given scale
+		auto apply_filtering(float p_scale)
+			-> void;
+			
+		// Collect visible layers in drawing order and update the lighting origin
+		auto prepare_frame()
+			-> visible_list;
+			
+		// Set uniforms for a layer and draw it. The cell buffer of the layer
+		// has to be bound already.
+		auto draw_layer(shader_variant::mask_type p_variant, const offset_type& p_offset, const dimension_type& p_dims,
+			bool p_transparent, const glm::ivec2& p_scroll, const glm::ivec2& p_ring)
+			-> void;
+			
+		// Game thread side of threaded rendering
+		auto publish_frame()
+			-> void;
+			
+		auto start_render_thread()
+			-> void;
+			
+		// Render thread side of threaded rendering
+		auto run_render_thread()
+			-> void;
+			
+		auto draw_frame(const render_frame& p_frame)
+			-> void;
+			
+		auto upload_layer(gpu_layer& p_layer, const render_frame::layer_cells& p_cells)
+			-> void;
+			
+		auto release_gpu_layer(gpu_layer& p_layer)
+			-> void;
+			
+		// Determine cheapest shader variant able to render given screen contents
+		auto select_variant(const screen_contents& p_contents) const
+			-> shader_variant::mask_type;
+			
+		auto find_layer(layer_id p_id)
+			-> screen_layer&;
+			
+		// Retrieve program for given shader variant, creating it if needed
+		auto program_for(shader_variant::mask_type p_variant)
+			-> variant_program&;
 					
 	private:
-		texture_set m_Tex;
-		gl::program m_Program{gl::defer_creation};
-		screen_manager m_Screen;
+		asset_handle<texture_set> m_Tex;
+		::std::map<shader_variant::mask_type, variant_program> m_Programs;	//< All shader variants created so far
+		::std::map<layer_id, ::std::unique_ptr<screen_layer>> m_Layers;	//< All layers, including the base layer
+		layer_id m_NextLayer{base_layer + 1U};		//< Identifier of next created layer
 		empty_vbo m_Vbo;
+		frame_constants_buffer m_Constants;
 		dimension_type m_GlyphCount;
+		float m_Scale{1.f};		//< Output scale factor
+		GLuint m_Sampler{0};	//< Sampler used for the glyph atlas, depends on scale
+		
+		bool m_Threaded{false};									//< Whether a render thread is used
+		handoff_mode m_HandoffMode{handoff_mode::triple_buffered};
+		::std::unique_ptr<frame_handoff<render_frame>> m_Handoff;	//< Frames published for the render thread
+		::std::thread m_RenderThread;
+		::std::atomic_bool m_RenderRunning{false};				//< Whether the render thread should keep running
+		::std::mutex m_ErrorMutex;								//< Protects m_RenderError
+		::std::exception_ptr m_RenderError;						//< Exception that terminated the render thread
+		
+		// Only used by the render thread
+		::std::map<layer_id, gpu_layer> m_GPULayers;	//< GPU copies of all layers
+		float m_AppliedScale{0.f};					//< Scale the sampler filters were selected for
+		dimension_type m_AppliedWindow{ };			//< Window size the viewport was set to
 };
 
@@ -7,6 +7,7 @@
 #include <optional>
 #include <cstdint>
 #include <array>
+#include <algorithm>
 #include <GLXW/glxw.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -61,6 +62,20 @@ namespace internal
 	constexpr const ::std::uint32_t glyph_mask = 0xFFU;
 	constexpr const ::std::uint32_t glyph_set_mask = 0xF00U;
 	constexpr const ::std::uint32_t glyph_set_shift = 8U;
+	
+	// Whether given shape can produce whole horizontal spans of cells via
+	// next_span(), instead of single positions
+	template< typename Tshape, typename = void >
+	struct has_next_span
+		: ::std::false_type
+	{
+	};
+	
+	template< typename Tshape >
+	struct has_next_span<Tshape, ::std::void_t<decltype(::std::declval<Tshape&>().next_span())>>
+		: ::std::true_type
+	{
+	};
 }
 
 
@@ -112,6 +127,19 @@ static_assert(sizeof(cell) == 32, "cell struct size mismatch!");
 static_assert(alignof(cell) == 4, "cell struct alignment mismatch!");	
 
 
+// Summary of the features used by the cells currently on screen. This is
+// used to select the cheapest shader variant able to render the screen.
+struct screen_contents
+{
+	bool m_HasShadows{true};	//< Whether any cell has drop shadows
+	bool m_HasFog{true};		//< Whether any cell has a non-zero depth
+	bool m_HasLitCells{true};	//< Whether any cell reacts to lighting
+};
+
+// Add features used by given cell to the screen contents summary
+void accumulate_contents(screen_contents&, const cell&);
+
+
 class screen_manager
 {
 	public:
@@ -119,10 +147,13 @@ class screen_manager
 		using dimension_type = glm::uvec2;
 		using index_type = ::std::size_t;
 		using container_type = ::std::vector<cell>;
+		using size_type = ::std::size_t;
+		using revision_type = ::std::uint64_t;
 
 	public:
 		//screen_manager(dimension_type p_screenSize);
 		screen_manager() = default;
+		~screen_manager();
 		
 	public:
 		screen_manager(const screen_manager&) = delete;
@@ -132,16 +163,45 @@ class screen_manager
 		screen_manager& operator=(screen_manager&&) = delete;
 		
 	public:
+		// Create screen with the dimensions stored in the configuration
 		void initialize();
+		
+		// Create screen with given dimensions. The GPU buffer is only created
+		// on the first sync, so this does not require a current GL context.
+		void initialize(dimension_type);
 	
 	public:
 		// Sync buffer on GPU with state contained in this object
 		void sync();
 		
+		// Bind the cell buffer texture to texture unit 3. Requires a prior sync.
+		void use() const;
+		
+		// Read-only view of all cells, in row-major order
+		const container_type& cells() const;
+		
+		// Increased on every modification. Unlike the dirty flag, this is not
+		// reset by sync, so copies of the cells can be checked for staleness.
+		revision_type revision() const;
+		
 		void clear();
 		dimension_type screen_size() const;
+		
+		// Features used by the screen contents, as of the last sync or call
+		// to update_contents
+		const screen_contents& contents() const;
+		
+		// Update the features summary. Only rows modified since the last update
+		// are scanned again.
+		void update_contents();
+
 		void clear_cell(position_type);
 		cell& modify_cell(position_type);
+		
+		// Retrieve given number of consecutive cells on the same row, starting
+		// at given position. The span must not cross the right screen border.
+		cell* modify_span(position_type, size_type);
+		
 		const cell& read_cell(position_type) const;
 		void set_cell(position_type, const cell&);
 		
@@ -151,18 +211,50 @@ class screen_manager
 		// Maybe it should be a context struct containg info it is a corner piece etc
 		// This would allow "border", but that would destroy the idea of decoupled, because
 		// border would only work with rectangle!
+		//
+		// Shapes producing spans are applied one row segment at a time, and
+		// are clipped to the screen.
 		template< typename Tshape, typename Taction >
 		void modify(Tshape&& p_shape, Taction&& p_action)
 		{
-			Tshape t_shape{ ::std::forward<Tshape>(p_shape) };
-		
-			::std::optional<position_type> t_next;
-			while((t_next = t_shape.next()))
+			::std::decay_t<Tshape> t_shape{ ::std::forward<Tshape>(p_shape) };
+			
+			if constexpr(internal::has_next_span<::std::decay_t<Tshape>>::value)
 			{
-				p_action(modify_cell(t_next.value()));
+				// Range of rows touched by the spans
+				size_type t_first{ m_ScreenDims.y };
+				size_type t_last{ 0U };
+				
+				for(auto t_span = t_shape.next_span(); t_span; t_span = t_shape.next_span())
+				{
+					const auto& t_start = t_span->m_Start;
+					
+					if(t_start.x >= m_ScreenDims.x || t_start.y >= m_ScreenDims.y)
+						continue;
+					
+					const auto t_count = ::std::min<size_type>(t_span->m_Length, m_ScreenDims.x - t_start.x);
+					auto* t_cells = &get_cell(calc_index(t_start));
+					
+					for(size_type t_ix = 0; t_ix < t_count; ++t_ix)
+						p_action(t_cells[t_ix]);
+					
+					t_first = ::std::min<size_type>(t_first, t_start.y);
+					t_last = ::std::max<size_type>(t_last, t_start.y);
+				}
+				
+				// Shapes entirely outside of the screen do not modify anything
+				if(t_first <= t_last)
+					set_dirty(t_first, t_last + 1U);
+			}
+			else
+			{
+				// Every modified cell marks its own row dirty
+				::std::optional<position_type> t_next;
+				while((t_next = t_shape.next()))
+				{
+					p_action(modify_cell(t_next.value()));
+				}
 			}
-			
-			set_dirty();
 		}
 		
 		template< typename Taction >
@@ -178,13 +270,24 @@ class screen_manager
 		void clear_cell(index_type);
 		cell& get_cell(index_type);
 		const cell& get_cell(index_type) const;
+		// Mark all rows as modified
 		void set_dirty();
+		
+		// Mark rows in [begin, end) as modified
+		void set_dirty(size_type, size_type);
+		
 		bool check_position(position_type) const;
+		void create_buffer();
 	
 	private:
 		bool m_Dirty{false}; 						//< Whether the data was modified this frame
-		GLuint m_GPUBuffer;							//< Handle of GPU Buffer
-		GLuint m_GPUTexture;						//< Handle of the GPU texture
-		dimension_type m_ScreenDims;			//< Dimensions of screen, in glyphs
+		revision_type m_Revision{1U};				//< Modification counter
+		GLuint m_GPUBuffer{0};						//< Handle of GPU Buffer
+		GLuint m_GPUTexture{0};						//< Handle of the GPU texture
+		dimension_type m_ScreenDims{};				//< Dimensions of screen, in glyphs
 		container_type m_Data;						//< Actual screen data
+		screen_contents m_Contents;					//< Features used by the screen data
+		::std::vector<screen_contents> m_RowContents;	//< Features used by each row
+		size_type m_ContentsBegin{0U};				//< First row modified since the last contents update
+		size_type m_ContentsEnd{0U};				//< One past the last row modified since the last contents update
 };
@@ -1,8 +1,10 @@
-// TODO: Put internal implementation into .cxx file
+// TODO: Put internal implementation of the simple shapes into .cxx file
 
 #pragma once
 
 #include <optional>
+#include <vector>
+#include <functional>
 #include <cmath>
 #include <cstdlib>
 #include <string_view>
@@ -226,8 +228,67 @@ namespace internal
 			int m_Ix;
 			int m_Iy;
 	};
+	
+	// A horizontal run of cells on a single row
+	struct span
+	{
+		screen_manager::position_type m_Start;	//< Leftmost cell of the span
+		::std::size_t m_Length;					//< Number of cells, at least one
+	};
+	
+	// Shape made up of precomputed spans, ordered by row. These are applied
+	// span by span by screen_manager::modify, but can be iterated cell by cell
+	// as well.
+	class span_impl
+	{
+		using position_type = screen_manager::position_type;
+		using size_type = ::std::size_t;
+		
+		public:
+			explicit span_impl(::std::vector<span> p_spans)
+				: m_Spans{ ::std::move(p_spans) }
+			{
+			}
+		
+		public:
+			auto next_span() -> ::std::optional<span>
+			{
+				if(m_Span >= m_Spans.size())
+					return { };
+				
+				m_X = 0U;
+				return ::std::make_optional(m_Spans[m_Span++]);
+			}
+			
+			auto next() -> ::std::optional<position_type>
+			{
+				while(m_Span < m_Spans.size() && m_X >= m_Spans[m_Span].m_Length)
+				{
+					m_X = 0U; ++m_Span;
+				}
+				
+				if(m_Span >= m_Spans.size()) return { };
+				
+				const auto t_pos = m_Spans[m_Span].m_Start + position_type{m_X, 0U};
+				++m_X;
+				
+				return ::std::make_optional(t_pos);
+			}
+			
+			auto spans() const -> const ::std::vector<span>&
+			{
+				return m_Spans;
+			}
+		
+		private:
+			::std::vector<span> m_Spans;
+			size_type m_Span{0U};		//< Current span
+			size_type m_X{0U};			//< Offset into current span
+	};
 }
 
+using cell_predicate = ::std::function<bool(const cell&)>;
+
 static auto point(const screen_manager::position_type& p_position)
 	-> internal::point_impl
 {
@@ -259,3 +320,46 @@ static auto line(const screen_manager::position_type& p_start, const screen_mana
 {
 	return {p_start, p_end};
 }
+
+
+// The following shapes produce horizontal spans. Cells left of or above the
+// screen origin are dropped, which means these can be partially off-screen.
+
+// Circle of given radius around given center, including its interior
+auto filled_circle(const screen_manager::position_type& p_center, unsigned p_radius)
+	-> internal::span_impl;
+
+// Outline of a circle of given radius around given center
+auto circle(const screen_manager::position_type& p_center, unsigned p_radius)
+	-> internal::span_impl;
+
+// Axis-aligned ellipse with given horizontal and vertical radii, including its interior
+auto filled_ellipse(const screen_manager::position_type& p_center, const glm::uvec2& p_radii)
+	-> internal::span_impl;
+
+// Outline of an axis-aligned ellipse with given horizontal and vertical radii
+auto ellipse(const screen_manager::position_type& p_center, const glm::uvec2& p_radii)
+	-> internal::span_impl;
+
+// Convex polygon formed by given vertices, including its interior. The
+// vertices may be given in either winding order.
+auto convex_polygon(const ::std::vector<screen_manager::position_type>& p_vertices)
+	-> internal::span_impl;
+
+// All cells 4-connected to given start position that satisfy given predicate.
+// The region is determined when the shape is created, so actions applied to it
+// may freely modify the cells.
+auto flood_fill(const screen_manager& p_screen, const screen_manager::position_type& p_start, const cell_predicate& p_predicate)
+	-> internal::span_impl;
+
+// All cells within given radius that are visible from given origin, determined
+// using recursive shadowcasting. Cells satisfying the opacity predicate block
+// vision, but are visible themselves.
+auto field_of_view(const screen_manager& p_screen, const screen_manager::position_type& p_origin, unsigned p_radius, const cell_predicate& p_opaque)
+	-> internal::span_impl;
+
+// Like field_of_view, but limited to a cone around given direction. The angle
+// is the full opening angle of the cone, in radians.
+auto view_cone(const screen_manager& p_screen, const screen_manager::position_type& p_origin, unsigned p_radius,
+	const glm::vec2& p_direction, float p_angle, const cell_predicate& p_opaque)
+	-> internal::span_impl;
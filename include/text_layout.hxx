@@ -0,0 +1,165 @@
+// Text layout engine used to render formatted strings.
+//
+// Strings are parsed, wrapped, aligned and clipped once into a list of glyph
+// runs, which can then be copied into the screen cells directly. Since most
+// text does not change from frame to frame, layouts can be cached.
+//
+// Formatted strings support the following markup:
+//
+//   %fX			Set foreground to palette color X (hex digit, see enum color)
+//   %bX			Set background to palette color X
+//   %F#rrggbb	Set foreground to given RGB color
+//   %B#rrggbb	Set background to given RGB color
+//   %r			Reset colors to the defaults of the layout
+//   %%			Literal percent sign
+//
+// Newlines start a new line. Palette colors require a palette to be supplied
+// in the layout parameters.
+
+#pragma once
+
+#include <list>
+#include <limits>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "screen.hxx"
+#include "palette.hxx"
+
+enum class text_align
+{
+	left,
+	center,
+	right
+};
+
+enum class text_wrap
+{
+	none,		//< Clip lines that are too long
+	word,		//< Break lines between words, and inside of words that do not fit a line
+	character	//< Break lines at any character
+};
+
+struct text_layout_params
+{
+	using dimension_type = glm::uvec2;
+	
+	dimension_type m_Box{ ::std::numeric_limits<unsigned>::max(), ::std::numeric_limits<unsigned>::max() };	//< Size of the box the text is clipped to, in cells
+	text_align m_Align{text_align::left};
+	text_wrap m_Wrap{text_wrap::word};
+	cell::integral_color_type m_Foreground{255U, 255U, 255U};	//< Default foreground color
+	cell::integral_color_type m_Background{0U};				//< Default background color
+	glyph_set m_GlyphSet{glyph_set::text};
+	const palette* m_Palette{nullptr};		//< Palette used for palette color markup
+	bool m_Markup{true};					//< Whether markup is interpreted
+};
+
+// A sequence of glyphs on the same line sharing the same colors
+struct glyph_run
+{
+	glm::uvec2 m_Position;						//< Position of first glyph, relative to the box
+	::std::uint32_t m_First;					//< Index of first glyph in the glyph buffer
+	::std::uint32_t m_Length;					//< Number of glyphs
+	cell::integral_color_type m_Foreground;
+	cell::integral_color_type m_Background;
+};
+
+class text_layout
+{
+	public:
+		using position_type = screen_manager::position_type;
+		using dimension_type = glm::uvec2;
+		using size_type = ::std::size_t;
+	
+	public:
+		// Lay out given formatted string. Throws if the string contains
+		// non-printable characters or invalid markup.
+		text_layout(::std::string_view p_text, const text_layout_params& p_params);
+	
+	public:
+		// Copy all glyph runs into the cells of given screen, with the top left
+		// corner of the box at given position. Glyphs outside of the screen are
+		// clipped.
+		auto blit(screen_manager& p_screen, const position_type& p_pos) const
+			-> void;
+		
+		auto runs() const
+			-> const ::std::vector<glyph_run>&;
+		
+		auto glyphs() const
+			-> const ::std::vector<cell::glyph_type>&;
+		
+		// Size of the area covered by the text, in cells
+		auto extent() const
+			-> const dimension_type&;
+		
+		// Number of lines after wrapping and clipping
+		auto line_count() const
+			-> size_type;
+		
+		// Approximate amount of memory used by this layout, in bytes
+		auto memory_usage() const
+			-> size_type;
+	
+	private:
+		::std::vector<glyph_run> m_Runs;			//< All runs, ordered by line
+		::std::vector<cell::glyph_type> m_Glyphs;	//< Glyphs of all runs
+		dimension_type m_Extent{ };					//< Size of area covered by text
+		glyph_set m_GlyphSet{glyph_set::text};
+};
+
+// Cache of text layouts, keyed by string and layout parameters. The least
+// recently used layouts are discarded once the capacity is exceeded. All
+// methods are thread safe.
+class text_layout_cache
+{
+	public:
+		using size_type = ::std::size_t;
+		using layout_ptr = ::std::shared_ptr<const text_layout>;
+	
+	public:
+		explicit text_layout_cache(size_type p_capacity = 512U);
+	
+	public:
+		// Cache used by the draw_text and draw_string actions
+		static auto shared()
+			-> text_layout_cache&;
+	
+	public:
+		// Retrieve layout for given string and parameters, creating it if it
+		// is not cached
+		auto get(::std::string_view p_text, const text_layout_params& p_params)
+			-> layout_ptr;
+		
+		auto clear()
+			-> void;
+		
+		auto size() const
+			-> size_type;
+		
+		auto hits() const
+			-> size_type;
+		
+		auto misses() const
+			-> size_type;
+	
+	private:
+		using lru_list = ::std::list<::std::pair<::std::string, layout_ptr>>;
+	
+	private:
+		static auto make_key(::std::string_view p_text, const text_layout_params& p_params)
+			-> ::std::string;
+	
+	private:
+		mutable ::std::mutex m_Mutex;	//< Protects all members below
+		size_type m_Capacity;		//< Maximum number of cached layouts
+		lru_list m_Entries;			//< Cached layouts, most recently used first
+		::std::unordered_map<::std::string_view, lru_list::iterator> m_Index;	//< Lookup of entries by key
+		size_type m_Hits{0};
+		size_type m_Misses{0};
+};
@@ -1,12 +1,20 @@
 #pragma once
 
 #include <string>
+#include <memory>
+#include <vector>
+#include <optional>
 #include <type_traits>
 #include <stdexcept>
 #include <glm/glm.hpp>
 #include <ut/type_traits.hxx>
 #include <ut/throwf.hxx>
 
+#include "asset_manager.hxx"
+
+struct SDL_Surface;
+class glyph_cache_entry;
+
 namespace internal
 {
 	struct shadow_texture_t
@@ -23,19 +31,30 @@ namespace internal
 	{
 		::std::string m_Path;
 	};
+	
+	// Glyph sheet for an arbitrary glyph set
+	struct glyph_sheet_t
+	{
+		::std::size_t m_GlyphSet;
+		::std::string m_Path;
+	};
 
 	template< typename T >
 	using is_texture_tag = 	::std::disjunction<
 								::std::is_same<::std::decay_t<T>, shadow_texture_t>,
 								::std::is_same<::std::decay_t<T>, text_texture_t>,
-								::std::is_same<::std::decay_t<T>, graphics_texture_t>
+								::std::is_same<::std::decay_t<T>, graphics_texture_t>,
+								::std::is_same<::std::decay_t<T>, glyph_sheet_t>
 							>;
 						
 	template< typename T >
 	constexpr bool is_texture_tag_v = is_texture_tag<T>::value;
 
+	// Glyph sheet tags may appear multiple times, since they carry their glyph set
 	template< typename T, typename... Ts >
-	using all_unique_impl = ::std::bool_constant<ut::count_of_v<T, Ts...> <= 1U>;
+	using all_unique_impl = ::std::bool_constant<
+		::std::is_same_v<T, glyph_sheet_t> || ut::count_of_v<T, Ts...> <= 1U
+	>;
 
 	template< typename... Ts >
 	using all_unique = 	::std::conjunction<
@@ -44,12 +63,90 @@ namespace internal
 }
 
 
+// Image data that was loaded from disk and converted to RGBA8, ready to be
+// uploaded to the GPU. Does not require a render context and can thus be
+// created on any thread.
+//
+// Decoded images are kept in the glyph cache. If a valid cache entry exists,
+// the image is memory mapped from it instead of being decoded.
+class texture_image
+{
+	struct surface_deleter
+	{
+		auto operator()(SDL_Surface*) const
+			-> void;
+	};
+	
+	using surface_ptr = ::std::unique_ptr<SDL_Surface, surface_deleter>;
+	
+	public:
+		explicit texture_image(const ::std::string& p_path);
+		~texture_image();
+		
+		texture_image(texture_image&&);
+		texture_image& operator=(texture_image&&);
+		
+	public:
+		auto width() const
+			-> int;
+			
+		auto height() const
+			-> int;
+			
+		auto pixels() const
+			-> const void*;
+			
+	private:
+		surface_ptr m_Surface;							//< Decoded image, if it was not cached
+		::std::unique_ptr<glyph_cache_entry> m_Cached;	//< Mapped cache entry, if it was cached
+};
+
+namespace internal
+{
+	// All images required to create a texture set
+	struct texture_set_data
+	{
+		texture_set_data() = default;
+	
+		template<	typename... Ts,
+					typename = ::std::enable_if_t<
+						(sizeof...(Ts) > 0U) &&
+						::std::conjunction_v<is_texture_tag<Ts>...>
+					>
+		>
+		texture_set_data(const Ts&... p_args)
+		{
+			auto t_x = { (dispatch(p_args), 0)... }; 
+			(void)t_x;
+		}
+		
+		void dispatch(const shadow_texture_t&);
+		void dispatch(const text_texture_t&);
+		void dispatch(const graphics_texture_t&);
+		void dispatch(const glyph_sheet_t&);
+		
+		::std::vector<::std::optional<texture_image>> m_Sheets;	//< Glyph sheets, indexed by glyph set
+		::std::optional<texture_image> m_Shadow;
+	};
+}
+
+
 internal::shadow_texture_t shadow_texture(const ::std::string&);
 internal::text_texture_t text_texture(const ::std::string&);
 internal::graphics_texture_t graphics_texture(const ::std::string&);
+internal::glyph_sheet_t glyph_sheet(::std::size_t, const ::std::string&);
 
 
-// A class managing the ascii glyph sheet
+// A class managing the ascii glyph sheets.
+//
+// All glyph sets are stored as layers of a single 2D array texture, indexed
+// by glyph set. An additional layer after the last glyph set contains all 256
+// combinations of drop shadows, pre-composited from the shadow sheet and
+// indexed like glyphs by the cell's shadow mask. This allows the whole set to be
+// used with only one texture binding.
+//
+// The atlas uses immutable storage with a mipmap chain, which keeps glyphs
+// stable when the output is scaled down.
 class texture_set
 {
 	using size_type = ::std::size_t;
@@ -60,10 +157,13 @@ class texture_set
 		const static size_type sheet_width = 16;
 		const static size_type sheet_height = 16;
 		
+		// Maximum number of glyph sets, determined by the size of the glyph set
+		// field in the cell data
+		const static size_type max_glyph_sets = 16;
+		
 	public:
 		template<	typename... Ts,
 					typename = ::std::enable_if_t<
-						sizeof...(Ts) <= 3U &&
 						::std::conjunction_v<
 							internal::is_texture_tag<::std::decay_t<Ts>>...,
 							internal::all_unique<::std::decay_t<Ts>...>
@@ -72,20 +172,20 @@ class texture_set
 		>
 		texture_set(Ts&&... p_args)
 		{
-			static_assert(ut::contains_v<internal::text_texture_t, ::std::decay_t<Ts>...>,
+			static_assert(ut::contains_v<internal::text_texture_t, ::std::decay_t<Ts>...> ||
+				ut::contains_v<internal::glyph_sheet_t, ::std::decay_t<Ts>...>,
 				"texture_set: text texture required but not supplied");
 			
 			static_assert(ut::contains_v<internal::shadow_texture_t, ::std::decay_t<Ts>...>,
 				"texture_set: shadow texture required but not supplied");
-			
-			glEnable(GL_TEXTURE_2D);
-			
-			auto t_x = { (dispatch(p_args), 0)... }; 
-			(void)t_x;
-			
-			use();
+				
+			upload(internal::texture_set_data{ p_args... });
 		}
 		
+		// Create texture set from already decoded images. Requires text and shadow
+		// images to be present.
+		explicit texture_set(internal::texture_set_data&&);
+		
 		texture_set() = default;
 		~texture_set();
 		
@@ -96,15 +196,7 @@ class texture_set
 		texture_set& operator=(const texture_set&) = delete;
 
 	private:
-		void dispatch(const internal::shadow_texture_t&);
-		void dispatch(const internal::text_texture_t&);
-		void dispatch(const internal::graphics_texture_t&);
-		
-	private:
-		auto recv_dims(GLuint p_tex)
-			-> dimension_type;
-			
-		auto update_dims(const dimension_type&)
+		auto upload(internal::texture_set_data&&)
 			-> void;
 
 	public:
@@ -112,12 +204,50 @@ class texture_set
 		auto glyph_size() const
 			-> const dimension_type&;
 			
+		// Returns number of mipmap levels of the atlas
+		auto mip_levels() const
+			-> GLsizei;
+			
+		// Returns number of glyph sets stored in the atlas
+		auto glyph_set_count() const
+			-> size_type;
+			
+		// Returns the array layer containing the drop shadow sheet
+		auto shadow_layer() const
+			-> size_type;
+			
 		auto use() const
 			-> void;
+			
+		// Returns amount of texture memory used by this set, in bytes
+		auto memory_usage() const
+			-> size_type;
 
 	private:
-		GLuint m_TextTex{0};
-		GLuint m_GfxTex{0};
-		GLuint m_ShadowTex{0};
-		dimension_type m_GlyphDim{};	
+		GLuint m_Atlas{0};
+		size_type m_GlyphSets{0};
+		dimension_type m_GlyphDim{};
+		size_type m_MemoryUsage{};
+};
+
+
+// Loads the texture set with given name from the data directory. Decoding is
+// done separately from the upload, which allows asynchronous loading.
+//
+// Glyph sets 0 and 1 are read from "text.png" and "graphics.png", all further
+// sets from "set<N>.png".
+template<>
+struct asset_loader <texture_set>
+{
+	auto decode(const ::std::string& p_name) const
+		-> internal::texture_set_data;
+		
+	auto upload(internal::texture_set_data&& p_data) const
+		-> texture_set;
+		
+	static auto memory_usage(const texture_set& p_set)
+		-> ::std::size_t;
+		
+	auto load_asset(const ::std::string& p_name) const
+		-> texture_set;
 };
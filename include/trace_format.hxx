@@ -0,0 +1,92 @@
+// On-disk format of binary trace files. This header is shared by the trace
+// log and the offline decoder, and therefore must not depend on anything but
+// the standard library.
+//
+// A trace file starts with a file header, followed by a sequence of records.
+// Every record starts with a record header, followed by its payload, padded
+// to a multiple of eight bytes. Files are preallocated and zero-filled, so a
+// record of type `end` marks the end of the data.
+//
+// Event records reference their tag and format string by id. The definitions
+// of all ids used in a file are stored in that file before the first event
+// using them, so every file of a rotated set can be decoded on its own.
+//
+// Format strings use `{}` as placeholders for the event arguments. Arguments
+// are stored as a type byte followed by the raw value; strings are stored as
+// a 16 bit length followed by the characters.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace trace_format
+{
+	// ASCII "ASCTRACE" in little endian
+	constexpr const ::std::uint64_t magic = 0x4543415254435341ULL;
+	constexpr const ::std::uint32_t version = 1U;
+	
+	// Alignment of all records
+	constexpr const ::std::size_t record_alignment = 8U;
+	
+	enum class record_type
+		: ::std::uint8_t
+	{
+		end = 0U,
+		tag_definition,		//< Payload is the name of tag `m_Tag`
+		format_definition,	//< Payload is the format string with id `m_Format`
+		event				//< Payload are the encoded arguments
+	};
+	
+	enum class level
+		: ::std::uint8_t
+	{
+		fatal = 0U,
+		error,
+		warning,
+		info,
+		debug
+	};
+	
+	enum class argument_type
+		: ::std::uint8_t
+	{
+		signed_integer = 0U,	//< 64 bit signed integer
+		unsigned_integer,		//< 64 bit unsigned integer
+		floating_point,			//< 64 bit IEEE float
+		boolean,				//< Single byte
+		string					//< 16 bit length and characters
+	};
+	
+	struct file_header
+	{
+		::std::uint64_t m_Magic;
+		::std::uint32_t m_Version;
+		::std::uint32_t m_Sequence;		//< Number of files created before this one in the session
+		::std::int64_t m_StartTime;		//< Wall clock time the file was created, in ns since the UNIX epoch
+		::std::uint64_t m_StartTicks;	//< Event timestamp corresponding to m_StartTime
+	};
+	
+	struct record_header
+	{
+		record_type m_Type;
+		level m_Level;
+		::std::uint16_t m_Size;			//< Payload size in bytes, without padding
+		::std::uint16_t m_Tag;
+		::std::uint16_t m_Format;
+		::std::uint64_t m_Timestamp;	//< Monotonic timestamp, in ns
+	};
+	
+	static_assert(sizeof(file_header) == 32U, "file_header size mismatch");
+	static_assert(sizeof(record_header) == 16U, "record_header size mismatch");
+	static_assert(::std::is_trivially_copyable_v<file_header>, "file_header needs to be trivially copyable");
+	static_assert(::std::is_trivially_copyable_v<record_header>, "record_header needs to be trivially copyable");
+	
+	// Size of a record with given payload size, including padding
+	constexpr auto record_size(::std::size_t p_payload)
+		-> ::std::size_t
+	{
+		return sizeof(record_header) + ((p_payload + record_alignment - 1U) / record_alignment) * record_alignment;
+	}
+}
@@ -0,0 +1,299 @@
+// Binary trace log.
+//
+// Events are written as compact binary records into a memory mapped file,
+// instead of being formatted as text. Tags and format strings are only stored
+// once per file and referenced by id, and arguments are stored as raw values.
+// Formatting happens offline, using the trace_decode tool. This makes tracing
+// cheap enough to be left enabled at debug level.
+//
+// Besides TRACE_* events, the trace receives all messages posted through the
+// log manager. Messages logged directly using liblog are not recorded.
+//
+// Once a file is full, it is rotated: "trace.bin" is renamed to "trace.1.bin",
+// "trace.1.bin" to "trace.2.bin" and so on, discarding the oldest file.
+
+#pragma once
+
+#include <mutex>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <boost/filesystem.hpp>
+#include <log.hxx>
+#include "trace_format.hxx"
+
+namespace boost::interprocess
+{
+	class file_mapping;
+	class mapped_region;
+}
+
+namespace internal
+{
+	// Encodes event arguments into a fixed size buffer. Arguments that do not
+	// fit are discarded, long strings are truncated.
+	class trace_encoder
+	{
+		public:
+			static constexpr const ::std::size_t capacity = 1024U;
+		
+		public:
+			template< typename T >
+			auto encode(const T& p_value)
+				-> void
+			{
+				using namespace trace_format;
+				
+				if constexpr(::std::is_same_v<T, bool>)
+				{
+					const ::std::uint8_t t_value = p_value ? 1U : 0U;
+					put(argument_type::boolean, &t_value, sizeof(t_value));
+				}
+				else if constexpr(::std::is_enum_v<T>)
+				{
+					encode(static_cast<::std::underlying_type_t<T>>(p_value));
+				}
+				else if constexpr(::std::is_integral_v<T> && ::std::is_signed_v<T>)
+				{
+					const auto t_value = static_cast<::std::int64_t>(p_value);
+					put(argument_type::signed_integer, &t_value, sizeof(t_value));
+				}
+				else if constexpr(::std::is_integral_v<T>)
+				{
+					const auto t_value = static_cast<::std::uint64_t>(p_value);
+					put(argument_type::unsigned_integer, &t_value, sizeof(t_value));
+				}
+				else if constexpr(::std::is_floating_point_v<T>)
+				{
+					const auto t_value = static_cast<double>(p_value);
+					put(argument_type::floating_point, &t_value, sizeof(t_value));
+				}
+				else
+				{
+					static_assert(::std::is_convertible_v<const T&, ::std::string_view>,
+						"trace_encoder: unsupported argument type");
+					
+					put_string(::std::string_view{ p_value });
+				}
+			}
+			
+			auto data() const
+				-> const ::std::uint8_t*
+			{
+				return m_Buffer.data();
+			}
+			
+			auto size() const
+				-> ::std::size_t
+			{
+				return m_Size;
+			}
+		
+		private:
+			auto put(trace_format::argument_type p_type, const void* p_data, ::std::size_t p_size)
+				-> void
+			{
+				if(m_Size + 1U + p_size > capacity)
+					return;
+				
+				m_Buffer[m_Size++] = static_cast<::std::uint8_t>(p_type);
+				::std::memcpy(&m_Buffer[m_Size], p_data, p_size);
+				m_Size += p_size;
+			}
+			
+			auto put_string(::std::string_view p_str)
+				-> void
+			{
+				const auto t_header = 1U + sizeof(::std::uint16_t);
+				
+				if(m_Size + t_header > capacity)
+					return;
+				
+				const auto t_length = static_cast<::std::uint16_t>(::std::min(p_str.size(), capacity - m_Size - t_header));
+				
+				m_Buffer[m_Size++] = static_cast<::std::uint8_t>(trace_format::argument_type::string);
+				::std::memcpy(&m_Buffer[m_Size], &t_length, sizeof(t_length));
+				m_Size += sizeof(t_length);
+				::std::memcpy(&m_Buffer[m_Size], p_str.data(), t_length);
+				m_Size += t_length;
+			}
+		
+		private:
+			::std::array<::std::uint8_t, capacity> m_Buffer;
+			::std::size_t m_Size{0U};
+	};
+}
+
+
+class trace_log
+{
+	using region_type = boost::interprocess::mapped_region;
+	using mapping_type = boost::interprocess::file_mapping;
+	
+	public:
+		using path_type = boost::filesystem::path;
+		using size_type = ::std::size_t;
+		using id_type = ::std::uint16_t;
+		
+		// Ids of an interned tag and format string pair
+		struct event_id
+		{
+			id_type m_Tag;
+			id_type m_Format;
+		};
+		
+		static constexpr const size_type default_file_size = 8U * 1024U * 1024U;
+		static constexpr const size_type default_file_count = 4U;
+		static constexpr const size_type min_file_size = 64U * 1024U;
+	
+	public:
+		// Open trace log writing to given path. At most given number of files
+		// are kept, including the one currently written to.
+		trace_log(const path_type& p_path, size_type p_fileSize = default_file_size, size_type p_fileCount = default_file_count);
+		~trace_log();
+		
+		trace_log(const trace_log&) = delete;
+		trace_log& operator=(const trace_log&) = delete;
+	
+	public:
+		// The trace log events are currently written to, or nullptr if tracing
+		// is disabled
+		static auto active()
+			-> trace_log*;
+		
+		static auto set_active(trace_log* p_log)
+			-> void;
+	
+	public:
+		// Retrieve ids for given tag and format string, assigning new ids if
+		// they were not used before. The result is meant to be cached by the
+		// caller, see trace_site.
+		auto intern(::std::string_view p_tag, ::std::string_view p_format)
+			-> event_id;
+		
+		// Number identifying this trace log within the process. Interned ids
+		// are only valid for the trace log that returned them.
+		auto generation() const
+			-> ::std::uint32_t;
+		
+		template< typename... Ts >
+		auto write(lg::severity_level p_level, event_id p_id, const Ts&... p_args)
+			-> void
+		{
+			internal::trace_encoder t_encoder{ };
+			(t_encoder.encode(p_args), ...);
+			
+			write_event(p_level, p_id, t_encoder.data(), t_encoder.size());
+		}
+		
+		// Schedule writing of mapped data to disk
+		auto flush()
+			-> void;
+		
+		// Number of records lost because they did not fit into an empty file
+		auto dropped() const
+			-> ::std::uint64_t;
+	
+	private:
+		auto write_event(lg::severity_level p_level, event_id p_id, const void* p_data, size_type p_size)
+			-> void;
+		
+		// Write record to current file, if it fits. Requires the mutex to be held.
+		auto put(const trace_format::record_header& p_header, const void* p_data, size_type p_size)
+			-> bool;
+		
+		// Append record to current file, rotating it if it is full. Requires
+		// the mutex to be held.
+		auto append(const trace_format::record_header& p_header, const void* p_data, size_type p_size)
+			-> bool;
+		
+		auto intern_string(::std::unordered_map<::std::string, id_type>& p_map, ::std::vector<::std::string>& p_list,
+			trace_format::record_type p_type, ::std::string_view p_str)
+			-> id_type;
+		
+		auto open_file()
+			-> void;
+		
+		auto close_file()
+			-> void;
+		
+		auto rotate()
+			-> void;
+		
+		auto file_path(size_type p_index) const
+			-> path_type;
+	
+	private:
+		const ::std::uint32_t m_Generation;			//< Never zero
+		::std::mutex m_Mutex;						//< Protects the mapping and the interned strings
+		path_type m_Path;
+		size_type m_FileSize;						//< Size of every trace file, in bytes
+		size_type m_FileCount;						//< Maximum number of trace files
+		::std::uint32_t m_Sequence{0U};				//< Number of files created so far
+		::std::unique_ptr<mapping_type> m_File;
+		::std::unique_ptr<region_type> m_Region;
+		::std::uint8_t* m_Data{nullptr};			//< Start of mapped file
+		size_type m_Offset{0U};						//< Write position in current file
+		::std::vector<::std::string> m_Tags;		//< Interned tags, by id
+		::std::vector<::std::string> m_Formats;		//< Interned format strings, by id
+		::std::unordered_map<::std::string, id_type> m_TagIds;
+		::std::unordered_map<::std::string, id_type> m_FormatIds;
+		::std::atomic<::std::uint64_t> m_Dropped{0U};
+};
+
+
+// Caches the ids of the tag and format string of a single TRACE_EVENT. The ids
+// are stored along with the generation of the trace log that interned them, and
+// are interned again once a different trace log is active.
+class trace_site
+{
+	using id_type = trace_log::id_type;
+	
+	public:
+		auto id(trace_log& p_log, ::std::string_view p_tag, ::std::string_view p_format)
+			-> trace_log::event_id
+		{
+			const auto t_cached = m_Value.load(::std::memory_order_relaxed);
+			
+			if(static_cast<::std::uint32_t>(t_cached >> 32U) == p_log.generation())
+				return { static_cast<id_type>(t_cached >> 16U), static_cast<id_type>(t_cached) };
+			
+			// Racing threads intern the same strings, so they store the same value
+			const auto t_id = p_log.intern(p_tag, p_format);
+			
+			m_Value.store((::std::uint64_t{ p_log.generation() } << 32U)
+				| (::std::uint64_t{ t_id.m_Tag } << 16U) | t_id.m_Format, ::std::memory_order_relaxed);
+			
+			return t_id;
+		}
+	
+	private:
+		::std::atomic<::std::uint64_t> m_Value{0U};	//< Generation, tag id and format id
+};
+
+
+// Write event to the active trace log, if any. Tag and format string have to
+// be string literals, since their ids are cached in a local static.
+#define TRACE_EVENT(lvl, tag, fmt, ...) \
+	do \
+	{ \
+		if(auto* t_traceLog = ::trace_log::active()) \
+		{ \
+			static ::trace_site t_traceSite{ }; \
+			t_traceLog->write(lvl, t_traceSite.id(*t_traceLog, tag, fmt), ##__VA_ARGS__); \
+		} \
+	} \
+	while(false)
+
+#define TRACE_D(tag, fmt, ...) TRACE_EVENT(lg::severity_level::debug, tag, fmt, ##__VA_ARGS__)
+#define TRACE_I(tag, fmt, ...) TRACE_EVENT(lg::severity_level::info, tag, fmt, ##__VA_ARGS__)
+#define TRACE_W(tag, fmt, ...) TRACE_EVENT(lg::severity_level::warning, tag, fmt, ##__VA_ARGS__)
+#define TRACE_E(tag, fmt, ...) TRACE_EVENT(lg::severity_level::error, tag, fmt, ##__VA_ARGS__)
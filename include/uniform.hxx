@@ -97,9 +97,8 @@ namespace gl
 	auto set_uniform(const program& p_prog, ut::string_view p_name, const T& p_value)
 		-> void
 	{
-		// Get location. We need a zero-terminated string here.
-		auto t_str = p_name.to_string();
-		auto t_loc = glGetUniformLocation(p_prog.handle(), t_str.c_str());
+		// Get location from the cache built when the program was linked
+		auto t_loc = p_prog.uniform_location(p_name);
 	
 		if(t_loc != -1)
 		{
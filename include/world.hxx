@@ -0,0 +1,243 @@
+#pragma once
+
+#include <list>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "screen.hxx"
+
+// Position of a cell in the world, in cells. World positions may be negative.
+using world_position = glm::ivec2;
+
+// Position of a chunk in the world, in chunks
+using chunk_position = glm::ivec2;
+
+class world_store;
+
+namespace boost::interprocess
+{
+	class mapped_region;
+}
+
+
+namespace internal
+{
+	struct chunk_position_hash
+	{
+		auto operator()(const chunk_position& p_pos) const
+			-> ::std::size_t
+		{
+			const auto t_x = static_cast<::std::uint64_t>(static_cast<::std::uint32_t>(p_pos.x));
+			const auto t_y = static_cast<::std::uint64_t>(static_cast<::std::uint32_t>(p_pos.y));
+			
+			return ::std::hash<::std::uint64_t>{}((t_x << 32U) | t_y);
+		}
+	};
+}
+
+
+// A square block of cells. Chunks are the unit of storage, paging and GPU
+// upload. The cells are either owned by the chunk or live in a memory mapped
+// record of a world store.
+class world_chunk
+{
+	using region_type = boost::interprocess::mapped_region;
+	
+	public:
+		static constexpr const int chunk_size = 32;
+		static constexpr const int chunk_shift = 5;
+		static constexpr const ::std::size_t cell_count = chunk_size * chunk_size;
+		
+		using container_type = ::std::array<cell, cell_count>;
+		using revision_type = ::std::uint64_t;
+	
+	public:
+		// Create chunk with empty cells in memory
+		world_chunk();
+		
+		// Create chunk using the cells stored in given mapped record
+		explicit world_chunk(::std::unique_ptr<region_type> p_region);
+		
+		~world_chunk();
+		
+		world_chunk(const world_chunk&) = delete;
+		world_chunk& operator=(const world_chunk&) = delete;
+	
+	public:
+		// Cells in row-major order
+		auto cells()
+			-> container_type&;
+		
+		auto cells() const
+			-> const container_type&;
+	
+	private:
+		::std::unique_ptr<container_type> m_Owned;	//< Cells, if they are owned by this chunk
+		::std::unique_ptr<region_type> m_Region;	//< Mapped record, if the chunk is persistent
+		container_type* m_Cells{nullptr};			//< Cells used by this chunk
+};
+
+static_assert((1 << world_chunk::chunk_shift) == world_chunk::chunk_size, "chunk_shift does not match chunk_size");
+
+
+// Sparse, chunked storage for a world much larger than the screen.
+// Chunks are only allocated once a cell inside of them is modified. Cells
+// of chunks that do not exist read as empty cells.
+//
+// A world can optionally be backed by a world store. In that case only a
+// limited number of chunks is kept mapped at a time, and the least recently
+// used chunks are unmapped when that limit is exceeded. This keeps memory
+// usage bounded regardless of the size of the world. Note that references to
+// cells of persistent worlds are only valid until the chunk is evicted, which
+// can happen on any access to another chunk.
+class world_grid
+{
+	public:
+		using size_type = ::std::size_t;
+		using revision_type = world_chunk::revision_type;
+		
+		// Default number of chunks kept in memory for persistent worlds
+		static constexpr const size_type default_resident_limit = 1024U;
+	
+	public:
+		// Create world that is only stored in memory
+		world_grid();
+		
+		// Create world backed by given store. Chunks already present in the
+		// store become part of the world.
+		explicit world_grid(::std::unique_ptr<world_store> p_store, size_type p_residentLimit = default_resident_limit);
+		
+		~world_grid();
+		
+		world_grid(const world_grid&) = delete;
+		world_grid& operator=(const world_grid&) = delete;
+	
+	public:
+		// Chunk containing given cell
+		static auto chunk_of(const world_position& p_pos)
+			-> chunk_position;
+		
+		// World position of the top left cell of given chunk
+		static auto chunk_origin(const chunk_position& p_chunk)
+			-> world_position;
+	
+	public:
+		// Cells of chunks that do not exist are empty. Reading might page in
+		// chunks of persistent worlds, so concurrent reads are not allowed.
+		auto read_cell(const world_position& p_pos) const
+			-> const cell&;
+		
+		auto modify_cell(const world_position& p_pos)
+			-> cell&;
+		
+		auto set_cell(const world_position& p_pos, const cell& p_cell)
+			-> void;
+		
+		auto clear_cell(const world_position& p_pos)
+			-> void;
+		
+		// Remove all chunks
+		auto clear()
+			-> void;
+		
+		// Retrieve chunk at given position, or nullptr if it does not exist.
+		// Persistent chunks are paged in if required.
+		auto chunk(const chunk_position& p_chunk) const
+			-> const world_chunk*;
+		
+		// Revision of given chunk. This does not require the chunk to be
+		// resident. Chunks that do not exist have revision 0.
+		auto revision(const chunk_position& p_chunk) const
+			-> revision_type;
+		
+		// Number of chunks in the world
+		auto chunk_count() const
+			-> size_type;
+		
+		// Number of chunks currently kept in memory
+		auto resident_count() const
+			-> size_type;
+		
+		auto is_persistent() const
+			-> bool;
+		
+		// Write index of persistent worlds to disk
+		auto flush()
+			-> void;
+	
+	public:
+		// Apply action to all cells of given shape. Shape positions are relative
+		// to given world position. Shapes producing spans are applied one row
+		// segment per chunk at a time.
+		template< typename Tshape, typename Taction >
+		void modify(const world_position& p_origin, Tshape&& p_shape, Taction&& p_action)
+		{
+			::std::decay_t<Tshape> t_shape{ ::std::forward<Tshape>(p_shape) };
+			
+			if constexpr(internal::has_next_span<::std::decay_t<Tshape>>::value)
+			{
+				for(auto t_span = t_shape.next_span(); t_span; t_span = t_shape.next_span())
+				{
+					auto t_pos = p_origin + world_position{ t_span->m_Start };
+					auto t_remaining = static_cast<size_type>(t_span->m_Length);
+					
+					// Split span at chunk borders, so every chunk is only looked up once
+					while(t_remaining > 0U)
+					{
+						const auto t_chunk = chunk_of(t_pos);
+						const auto t_chunkEnd = (t_chunk.x + 1) * world_chunk::chunk_size;
+						const auto t_count = ::std::min<size_type>(t_remaining, static_cast<size_type>(t_chunkEnd - t_pos.x));
+						auto* t_cells = &modify_chunk(t_chunk).cells()[cell_index(t_pos)];
+						
+						for(size_type t_ix = 0; t_ix < t_count; ++t_ix)
+							p_action(t_cells[t_ix]);
+						
+						t_pos.x += static_cast<int>(t_count);
+						t_remaining -= t_count;
+					}
+				}
+			}
+			else
+			{
+				for(auto t_next = t_shape.next(); t_next; t_next = t_shape.next())
+					p_action(modify_cell(p_origin + world_position{ *t_next }));
+			}
+		}
+	
+	private:
+		// Bookkeeping for a single chunk of the world
+		struct chunk_entry
+		{
+			mutable ::std::unique_ptr<world_chunk> m_Chunk;	//< Chunk data, if resident
+			::std::optional<size_type> m_Record;		//< Store record, if persistent
+			revision_type m_Revision{0};				//< Changes every time a cell is modified
+			mutable ::std::list<chunk_position>::iterator m_Use;	//< Position in LRU list, if resident
+		};
+	
+	private:
+		// Make chunk resident and mark it as most recently used. Paging does not
+		// change the contents of the world, which is why this is const.
+		auto page_in(const chunk_position& p_pos, const chunk_entry& p_entry) const
+			-> world_chunk&;
+		
+		// Unmap least recently used chunks until the resident limit is met
+		auto evict() const
+			-> void;
+		
+		auto modify_chunk(const chunk_position& p_chunk)
+			-> world_chunk&;
+		
+		static auto cell_index(const world_position& p_pos)
+			-> size_type;
+	
+	private:
+		::std::unordered_map<chunk_position, chunk_entry, internal::chunk_position_hash> m_Chunks;	//< All chunks of the world
+		mutable ::std::list<chunk_position> m_LRU;	//< Resident chunks, most recently used first
+		::std::unique_ptr<world_store> m_Store;		//< Backing store, if persistent
+		size_type m_ResidentLimit{0};				//< Maximum number of resident chunks, if persistent
+		revision_type m_Revision{0};				//< Last assigned chunk revision
+};
@@ -0,0 +1,99 @@
+// Persistent storage for world chunks.
+//
+// Chunk cells are stored in a data file as fixed size, page aligned records,
+// which allows them to be memory mapped and modified in place. A separate index
+// file maps chunk positions to records. It is rewritten atomically on flush,
+// like the other binary caches.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include "world.hxx"
+
+namespace boost::interprocess
+{
+	class file_mapping;
+	class mapped_region;
+}
+
+namespace internal
+{
+	// Header of a world index file. One world_index_entry per stored chunk follows.
+	struct world_index_header
+	{
+		::std::uint64_t m_Magic;
+		::std::uint32_t m_Version;
+		::std::uint32_t m_ChunkSize;		//< Chunk dimensions the world was stored with
+		::std::uint64_t m_ChunkCount;		//< Number of stored chunks
+	};
+	
+	struct world_index_entry
+	{
+		::std::int32_t m_X;					//< Chunk position
+		::std::int32_t m_Y;					//
+	};
+}
+
+class world_store
+{
+	using path_type = boost::filesystem::path;
+	
+	public:
+		using size_type = ::std::size_t;
+		using region_type = boost::interprocess::mapped_region;
+		
+		// Size of a single chunk record
+		static constexpr size_type record_size = sizeof(world_chunk::container_type);
+	
+	public:
+		static constexpr ::std::uint64_t magic = 0x49444C524F575341ULL; // "ASWORLDI"
+		static constexpr ::std::uint32_t version = 1U;
+	
+	public:
+		// Open world with given base path, creating it if it does not exist.
+		// Data and index are stored in "<path>.chunks" and "<path>.index".
+		explicit world_store(const path_type& p_path);
+		~world_store();
+		
+		world_store(const world_store&) = delete;
+		world_store& operator=(const world_store&) = delete;
+	
+	public:
+		// Positions of all stored chunks, indexed by record
+		auto chunks() const
+			-> const ::std::vector<chunk_position>&;
+		
+		// Create record for given chunk. Its cells are initially empty.
+		auto allocate(const chunk_position& p_chunk)
+			-> size_type;
+		
+		// Map cells of given record into memory
+		auto map(size_type p_record)
+			-> ::std::unique_ptr<region_type>;
+		
+		// Remove all chunks
+		auto reset()
+			-> void;
+		
+		// Write index to disk. Mapped records are written back by the system.
+		auto flush()
+			-> void;
+	
+	private:
+		auto read_index()
+			-> void;
+		
+		auto reserve(size_type p_count)
+			-> void;
+	
+	private:
+		path_type m_DataPath;		//< File containing chunk records
+		path_type m_IndexPath;		//< File containing the chunk index
+		::std::unique_ptr<boost::interprocess::file_mapping> m_File;	//< Mapping of the data file
+		::std::vector<chunk_position> m_Chunks;		//< Chunk position of every record
+		size_type m_Capacity{0};	//< Number of records the data file can hold
+		bool m_Dirty{false};		//< Whether the index changed since the last flush
+};
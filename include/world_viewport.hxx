@@ -0,0 +1,123 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <GLXW/glxw.h>
+#include <glm/glm.hpp>
+#include "world.hxx"
+#include "screen.hxx"
+
+// A scrollable view into a world grid.
+//
+// The GPU buffer is a ring of chunk-sized slots that covers the viewport
+// plus one additional chunk in each direction. Every chunk is always stored
+// in the slot given by its chunk position modulo the ring dimensions, so
+// scrolling only requires uploading chunks that were not visible before.
+// Visible chunks that were modified since their last upload are uploaded
+// again.
+//
+// The GPU buffer is created on the first sync, so viewports can be created
+// without a current GL context.
+class world_viewport
+{
+	public:
+		using dimension_type = glm::uvec2;
+		using ring_type = glm::ivec2;
+		using size_type = ::std::size_t;
+		using revision_type = ::std::uint64_t;
+	
+	public:
+		world_viewport(::std::shared_ptr<world_grid> p_world, const dimension_type& p_dims);
+		~world_viewport();
+		
+		world_viewport(const world_viewport&) = delete;
+		world_viewport& operator=(const world_viewport&) = delete;
+	
+	public:
+		// Upload all visible chunks that are not resident or were modified
+		auto sync()
+			-> void;
+		
+		// Bind the cell buffer texture to texture unit 3
+		auto use() const
+			-> void;
+		
+		// Set world position of the top left cell of the viewport
+		auto scroll_to(const world_position& p_pos)
+			-> void;
+		
+		// Move viewport by given amount of cells
+		auto scroll(const world_position& p_delta)
+			-> void;
+		
+		auto position() const
+			-> const world_position&;
+		
+		// Dimensions of the viewport, in cells
+		auto size() const
+			-> const dimension_type&;
+		
+		// Dimensions of the chunk ring, in chunks
+		auto ring_size() const
+			-> const ring_type&;
+		
+		auto world()
+			-> world_grid&;
+		
+		auto world() const
+			-> const world_grid&;
+		
+		// Features used by the visible chunks, as of the last sync
+		auto contents() const
+			-> const screen_contents&;
+		
+		// Number of chunk uploads performed since creation
+		auto uploaded_chunks() const
+			-> size_type;
+		
+		// Copy visible cells into given array of size().x * size().y cells, in
+		// row-major order. Features used by the copied cells are added to given
+		// contents summary.
+		auto copy_cells(cell* p_dest, screen_contents& p_contents)
+			-> void;
+		
+		// Revision of the visible cells. It is increased whenever the viewport
+		// was scrolled or a visible chunk was modified since the last call.
+		auto content_revision()
+			-> revision_type;
+	
+	private:
+		// Information about the chunk stored in a ring slot
+		struct slot
+		{
+			::std::optional<chunk_position> m_Chunk;	//< Chunk stored in this slot, if any
+			world_grid::revision_type m_Revision{0};	//< Revision of the stored chunk
+			screen_contents m_Contents{ };				//< Features used by the stored chunk
+		};
+	
+	private:
+		auto slot_index(const chunk_position& p_chunk) const
+			-> size_type;
+		
+		auto upload(size_type p_slot, const chunk_position& p_chunk)
+			-> void;
+		
+		auto create_buffer()
+			-> void;
+	
+	private:
+		::std::shared_ptr<world_grid> m_World;	//< World this viewport shows
+		dimension_type m_Dims;					//< Dimensions of viewport, in cells
+		ring_type m_Ring;						//< Dimensions of ring, in chunks
+		world_position m_Position{ };			//< World position of top left cell
+		::std::vector<slot> m_Slots;			//< State of all ring slots
+		screen_contents m_Contents;				//< Features used by visible chunks
+		size_type m_Uploads{0};					//< Number of chunk uploads
+		revision_type m_Revision{1U};			//< Revision of the visible cells
+		world_position m_RevisionPosition{ };	//< Position when the revision was last checked
+		::std::vector<world_grid::revision_type> m_ChunkRevisions;	//< Visible chunk revisions when last checked
+		GLuint m_GPUBuffer{0};					//< Handle of GPU buffer
+		GLuint m_GPUTexture{0};					//< Handle of buffer texture
+};
@@ -9,6 +9,14 @@
 //
 // This file contains the main fragment shader for the ascii graphics engine.
 //
+// Specialization variants:
+//  The program loader may inject the following defines to build cheaper
+//  variants of this shader for scenes that don't use certain features:
+//   - NO_LIGHTING:			Skip all lighting calculations
+//   - NO_DYNAMIC_LIGHTING:	Only apply ambient lighting
+//   - NO_SHADOWS:			Skip drop shadow rendering
+//   - NO_FOG:				Skip fog calculation
+//
 //===----------------------------------------------------------------------===//
 // TODO:
 //  - Cursor support
@@ -32,9 +40,6 @@
 #define SHADOW_BL 	0x1U << 14U
 #define SHADOW_BR 	0x1U << 15U
 
-// Amount of different shadow orientations
-#define NUM_SHADOWS 8U
-
 // Shadow bit mask, contains shadow orientation bit field
 #define SHADOW_MASK 0xFF00U
 
@@ -47,10 +52,6 @@
 #define LIGHT_MASK 	0xF0000U
 #define LIGHT_SHIFT 16U
 
-// Glyph sets
-#define GLYPH_SET_TEXT 0U
-#define GLYPH_SET_GRAPHICS 1U
-
 // Gui mode bit position
 #define GUI_MODE 0x1U << 20U
 
@@ -120,11 +121,26 @@ layout (std140, binding = 0) uniform LightData
 } light_data;
 
 
+// Per-frame constants. Changes to these only require a single buffer update.
+layout (std140, binding = 1) uniform FrameConstants
+{
+	mat4 projection_mat;		//< Projection matrix
+	vec4 fog_color;				//< Color fog fades to
+	ivec2 glyph_dimensions;		//< Dimensions of a single glyph in pixels
+	ivec2 sheet_dimensions;		//< Dimensions of glyph sheet in glyphs
+	ivec2 glyph_count;			//< Screen size in glyphs
+	float fog_density;			//< Density value for fog calculation
+	uint shadow_layer;			//< Glyph atlas layer containing drop shadows.
+								//  This equals the number of glyph sets.
+};
+
+
+// Glyph atlas. Every glyph set is stored in its own layer, indexed by the
+// glyph set value. The layer following the last glyph set contains every
+// combination of drop shadows, indexed like glyphs by the shadow bit field.
+uniform sampler2DArray glyph_atlas;
+
 // Miscellaneous uniforms
-uniform sampler2D text_texture;
-uniform sampler2D graphics_texture;
-uniform sampler2D shadow_texture;
-uniform vec4 fog_color;
 uniform vec4 cursor_default; //< Default cursor front color
 
 //===----------------------------------------------------------------------===//
@@ -154,7 +170,7 @@ in vs_flat_out
 	flat vec4 front_color;		//< Foreground color of glyph
 	flat vec4 back_color;		//< Background color of glyph
 	flat float fog_factor;		//< Fog interpolation value [0, 1]
-	flat uint[8] shadows;		//< Array of shadow orientation flags
+	flat uint shadows;			//< Drop shadow orientation bit field
 	flat int has_cursor;		//< Flag indicating presence of cursor
 	flat uint light_mode;		//< How this cell should react to light
 	flat uint gui_mode;			//< Flag indicating GUI mode (see CellData)
@@ -170,10 +186,8 @@ in vs_smooth_out
 {
 	smooth vec2 tex_coords;		//< Glyph texture coordinates for cell
 	smooth vec2 cursor_coords;	//< Cursor texture coordinates for cell
-	smooth vec2 shadow_coords;	//< Shadow texture coordinates. This actually
-								//  references the leftmost shadow texture,
-								//  but will be offset in fragment shader
-								//  to blend all needed orientations together.
+	smooth vec2 shadow_coords;	//< Texture coordinates of the pre-composited
+								//  drop shadow combination for this cell
 } smooth_in;
 
 //===----------------------------------------------------------------------===//
@@ -187,21 +201,9 @@ in vs_smooth_out
 // Calculate base pixel color using the sheet texture
 vec4 calc_pixel()
 {
-	vec4 t_texColor = vec4(0.f);
-	
-	switch(flat_in.glyph_set)
-	{
-		case GLYPH_SET_TEXT:
-		{
-			t_texColor = texture2D(text_texture, smooth_in.tex_coords);
-			break;
-		}		
-		case GLYPH_SET_GRAPHICS:
-		{
-			t_texColor = texture2D(graphics_texture, smooth_in.tex_coords);
-			break;
-		}
-	}
+	// The glyph set directly selects the atlas layer
+	const vec4 t_texColor = texture(glyph_atlas,
+		vec3(smooth_in.tex_coords, float(flat_in.glyph_set)));
 
 	return mix(	flat_in.back_color,
 				flat_in.front_color * t_texColor,
@@ -218,6 +220,7 @@ void light_pixel(inout vec4 p_pixel)
 		// Apply ambient lighting
 		p_pixel = mix(vec4(0.f), p_pixel, light_data.state.ambient);
 		
+#ifndef NO_DYNAMIC_LIGHTING
 		// Only apply dynamic lighting if requested
 		if(light_data.state.use_dynamic)
 		{
@@ -231,33 +234,22 @@ void light_pixel(inout vec4 p_pixel)
 				p_pixel += light_data.state.dim_light * flat_in.lighting_result;
 			}
 		}
+#endif
 	}
 }
 
 void add_shadows(inout vec4 p_pixel)
 {
-	for(uint i = 0; i < NUM_SHADOWS; ++i)
+	if(flat_in.shadows != 0U)
 	{
-		if(flat_in.shadows[i] > 0)
-		{
-			// We only need to modify the U-component of the shadow texture
-			// coordinates, since all shadow textures are stored in one
-			// sequential line
-			const float t_u_offset = i * 1.f/8.f;
-			
-			// Calculate new shadow texture coordinates
-			const vec2 t_shadowCoords = vec2(
-				smooth_in.shadow_coords.x + t_u_offset,
-				smooth_in.shadow_coords.y
-			);
-			
-			// Fetch texel
-			const vec4 t_color = texture2D(shadow_texture, t_shadowCoords);
-			
-			// Blend it using alpha blending
-			p_pixel = mix(p_pixel, t_color, t_color.a);
-			p_pixel.a = 1.f;
-		}
+		// All shadows of this cell were composited into a single texel
+		// beforehand, so only one fetch is needed regardless of their count
+		const vec4 t_color = texture(glyph_atlas,
+			vec3(smooth_in.shadow_coords, float(shadow_layer)));
+		
+		// Blend it using alpha blending
+		p_pixel = mix(p_pixel, t_color, t_color.a);
+		p_pixel.a = 1.f;
 	}
 }
 
@@ -279,14 +271,22 @@ void main()
 	// Calculate pixel color based on glyph texture
 	vec4 t_color = calc_pixel();
 	
+#ifndef NO_LIGHTING
 	// Light the pixel
 	light_pixel(t_color);
-	
+#endif
+
+#ifndef NO_SHADOWS
 	// Mix in drop shadows
 	add_shadows(t_color);
+#endif
 	
+#ifndef NO_FOG
 	// Mix in fog
 	add_fog(t_color);
+#else
+	t_color.a = 1.f;
+#endif
 	
 	// Output pixel
 	fragmentColor = t_color;
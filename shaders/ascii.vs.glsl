@@ -16,6 +16,14 @@
 // drawing to cause the GPU to execute this shader six times per glyph position
 // (two triangles to form one quad).
 //
+// Specialization variants:
+//  The program loader may inject the following defines to build cheaper
+//  variants of this shader for scenes that don't use certain features:
+//   - NO_LIGHTING:			Skip all lighting calculations
+//   - NO_DYNAMIC_LIGHTING:	Only apply ambient lighting
+//   - NO_SHADOWS:			Skip drop shadow rendering
+//   - NO_FOG:				Skip fog calculation
+//
 //===----------------------------------------------------------------------===//
 // TODO:
 //  - Add real glow. Add flag that controls if bg or fg are glowing,
@@ -23,15 +31,6 @@
 //    blur them, blend them additively over main scene)
 //    (glBlendEquation(GL_ADD); glBlendFunc(GL_ONE, GL_ONE);)
 //
-//  - Support MULTIPLE glyph sets: glyph_set::graphical, glyph_set::text,
-//    glyph_set::draw (<= special set to draw pictures, contains triangles etc)
-//    (see ultima ratio regum)
-//    ==> Could use upper bits of glyph entry to set that
-//    IMPLEMENTATION: One class to manage ALL glyph textures. Takes up to two
-//                    paths, or ONE NAME (from_name, from_path(1str or 2str)
-//                    from_name appends "graphic" and "text" to it.
-//                    Will check if size is the same.
-//
 //  - CanSeeLight: If the start is a LIGHT_DIM, then it should still receive
 //    light, if it is directly connected to a tile that is permeable
 //    (Only the first layer of wall should be illuminated)
@@ -78,6 +77,11 @@
 // Shadow bit mask, contains shadow orientation bit field
 #define SHADOW_MASK 0xFF00U
 
+// World layer chunk dimensions. Every chunk is stored as a contiguous block
+// of cells in row-major order.
+#define CHUNK_SIZE 32
+#define CHUNK_SHIFT 5
+
 // Light modes. These are used to determine how a cell reacts to lighting.
 #define LIGHT_NONE 	0U	//< Block light. Stays completely dark.
 #define LIGHT_DIM 	1U	//< Block light. Receive small amount of light.
@@ -99,10 +103,6 @@
 // Maximum number of lights allowed in the light data uniform
 #define MAX_LIGHTS 25U
 
-// Glyph sets
-#define GLYPH_SET_TEXT 0U
-#define GLYPH_SET_GRAPHICS 1U
-
 // Glyph set mask and shift value
 #define GLYPH_SET_MASK 0xF00U
 #define GLYPH_SET_SHIFT 0x8U
@@ -121,18 +121,6 @@ const vec2 texture_offset[] = vec2[6](
 	vec2(0, 1)	// BL
 );
 
-// Drop shadow coordinates of the first shadow element for the 6 vertices of
-// the cell
-const vec2 shadow_coords[] = vec2[6](
-	vec2(1.f/8.f, 1),	// BR
-	vec2(1.f/8.f, 0),	// TR
-	vec2(0, 0),			// TL
-	
-	vec2(1.f/8.f, 1),	// BR
-	vec2(0, 0),			// TL
-	vec2(0, 1)			// BL
-);
-
 // Offset from top left vertex for each of the six vertices of the cell quad.
 // These are used to calculate the vertex data for every shader call.
 const vec2 vertex_offset[] = vec2[6](
@@ -192,9 +180,10 @@ struct CellData
 	vec4 back_color;		//< Back color of the glyph
 	vec2 glyph;				//< Glyph coordinates on glyph sheet
 	uint depth;				//< Depth of the tile. Used to calculate fog.
-	uint shadows[8];		//< Array of shadow orientation flags
+	uint shadows;			//< Drop shadow orientation bit field
 	uint light_mode;		//< Light calulation mode
 	uint glyph_set;			//< Glyph set to use to render this cell
+	bool empty;				//< Cell is transparent and will not be drawn
 	bool gui_mode;			//< Act like a normal tile for light calculations,
 							//  but be fully lit (for GUI elements that overlap
 							//  lit scenery)
@@ -240,14 +229,35 @@ layout (std140, binding = 0) uniform LightData
 } light_data;
 
 
+// Per-frame constants. Changes to these only require a single buffer update.
+layout (std140, binding = 1) uniform FrameConstants
+{
+	mat4 projection_mat;		//< Projection matrix
+	vec4 fog_color;				//< Color fog fades to
+	ivec2 glyph_dimensions;		//< Dimensions of a single glyph in pixels
+	ivec2 sheet_dimensions;		//< Dimensions of glyph sheet in glyphs
+	ivec2 glyph_count;			//< Screen size in glyphs
+	float fog_density;			//< Density value for fog calculation
+	uint shadow_layer;			//< Glyph atlas layer containing drop shadows.
+								//  This equals the number of glyph sets.
+};
+
+
 // Miscellaneous uniforms
-uniform ivec2 glyph_dimensions;	//< Dimensions of a single glyph in pixels
-uniform ivec2 sheet_dimensions;	//< Dimensions of glyph sheet in glyphs
-uniform ivec2 glyph_count;		//< Screen size in glyphs
-uniform mat4 projection_mat;	//< Projection matrix
-uniform float fog_density;		//< Density value for fog calculation
 uniform ivec2 cursor_pos;		//< Position of cursor, in screen coordinates
 
+// Screen layer uniforms. Every layer is rendered with its own draw call.
+uniform ivec2 layer_offset;		//< Position of the layer on screen, in glyphs
+uniform ivec2 layer_size;		//< Dimensions of the layer, in glyphs
+uniform bool layer_transparent;	//< Whether empty cells are not drawn. Cells
+								//  are empty if they use glyph 0 and black
+								//  colors.
+uniform ivec2 layer_scroll;		//< World position of the top left cell of a
+								//  world layer
+uniform ivec2 layer_ring;		//< Dimensions of the chunk ring of a world
+								//  layer, in chunks. Zero for normal layers,
+								//  which are stored in row-major order.
+
 //===----------------------------------------------------------------------===//
 
 
@@ -263,7 +273,7 @@ out vs_flat_out
 	flat vec4 front_color;		//< Foreground color of glyph
 	flat vec4 back_color;		//< Background color of glyph
 	flat float fog_factor;		//< Fog interpolation value [0, 1]
-	flat uint[8] shadows;		//< Array of shadow orientation flags
+	flat uint shadows;			//< Drop shadow orientation bit field
 	flat int has_cursor;		//< Flag indicating presence of cursor
 	flat uint light_mode;		//< How this cell should react to light
 	flat uint gui_mode;			//< Flag indicating GUI mode (see CellData)
@@ -279,10 +289,8 @@ out vs_smooth_out
 {
 	smooth vec2 tex_coords;		//< Glyph texture coordinates for cell
 	smooth vec2 cursor_coords;	//< Cursor texture coordinates for cell
-	smooth vec2 shadow_coords;	//< Shadow texture coordinates. This actually
-								//  references the leftmost shadow texture,
-								//  but will be offset in fragment shader
-								//  to blend all needed orientations together.
+	smooth vec2 shadow_coords;	//< Texture coordinates of the pre-composited
+								//  drop shadow combination for this cell
 } smooth_out;
 
 //===----------------------------------------------------------------------===//
@@ -314,20 +322,11 @@ uint read_lm(in uint p_in)
 	return (p_in & LIGHT_MASK) >> LIGHT_SHIFT;
 }
 
-// Retrieve drop shadow orientations
-void read_shadows(in uint p_in)
+// Retrieve drop shadow orientations. The resulting bit field directly indexes
+// the pre-composited shadow combination in the drop shadow layer.
+uint read_shadows(in uint p_in)
 {
-	this_cell.shadows = uint[8]
-	(
-		p_in & SHADOW_W,
-		p_in & SHADOW_S,
-		p_in & SHADOW_N,
-		p_in & SHADOW_E,	
-		p_in & SHADOW_BR,
-		p_in & SHADOW_BL,
-		p_in & SHADOW_TL,
-		p_in & SHADOW_TR
-	);
+	return (p_in & SHADOW_MASK) >> 8U;
 }
 
 // Calculate vertex for this shader call
@@ -369,8 +368,11 @@ void calc_tex_coords()
 
 void calc_shadow_coords()
 {
-	// Lookup value and write to output interface block
-	smooth_out.shadow_coords = shadow_coords[gl_VertexID];
+	// The drop shadow layer is laid out like a glyph sheet, with the shadow
+	// bit field used as glyph index
+	const vec2 t_tile = vec2(this_cell.shadows % 16U, this_cell.shadows / 16U);
+	
+	smooth_out.shadow_coords = (t_tile + texture_offset[gl_VertexID]) / vec2(sheet_dimensions);
 }
 
 void calc_fog()
@@ -382,6 +384,22 @@ void calc_fog()
 }
 
 
+// Calculates the index of the cell at given layer position in the input buffer
+int cell_index(in ivec2 p_local)
+{
+	if(layer_ring.x == 0)
+		return (p_local.y * layer_size.x) + p_local.x;
+		
+	// World layers store chunks in a ring, indexed by chunk position modulo
+	// the ring dimensions
+	const ivec2 t_world = p_local + layer_scroll;
+	const ivec2 t_slot = ivec2(mod(vec2(t_world >> CHUNK_SHIFT), vec2(layer_ring)));
+	const ivec2 t_cell = t_world & (CHUNK_SIZE - 1);
+	
+	return ((t_slot.y * layer_ring.x + t_slot.x) * CHUNK_SIZE * CHUNK_SIZE)
+		+ (t_cell.y * CHUNK_SIZE) + t_cell.x;
+}
+
 // Checks whether the screen cell lets light through
 bool check_point(in ivec2 p_point)
 {
@@ -394,13 +412,16 @@ bool check_point(in ivec2 p_point)
 	if(t_relPoint == this_cell.screen_coords && this_cell.light_mode == LIGHT_DIM)
 		return true;
 	
-	// Check if it is in screen bounds
+	// Only cells of the current layer can be checked
+	const ivec2 t_layerPoint = t_relPoint - layer_offset;
+	
+	// Check if it is in layer bounds
 	const ivec2 t_clamped = ivec2(
-		clamp(t_relPoint.x, 0, glyph_count.x-1),
-		clamp(t_relPoint.y, 0, glyph_count.y-1)
+		clamp(t_layerPoint.x, 0, layer_size.x-1),
+		clamp(t_layerPoint.y, 0, layer_size.y-1)
 	);
 	
-	if(t_relPoint != t_clamped)
+	if(t_layerPoint != t_clamped)
 		return false; // Assume that the light is not visible anymore.
 		// This COULD be problematic (lights suddenly disappearing even though
 		// they should still be in range), but we can't do any better here
@@ -409,7 +430,7 @@ bool check_point(in ivec2 p_point)
 		// player to make this limitation less obvious.
 		
 	// Fetch entry containg the lighting mode (low word)
-	const int t_index = int((t_relPoint.y * glyph_count.x) + t_relPoint.x);
+	const int t_index = cell_index(t_layerPoint);
 	const uint t_word = texelFetch(input_buffer, (t_index*2)+1).a;
 	
 	const  uint t_lm = read_lm(t_word);
@@ -420,15 +441,22 @@ bool check_point(in ivec2 p_point)
 // Reads data of this cell and saves it to the global cell info variable
 void read_cell()
 {
-	// Determine screen coordinates of this cell
-	this_cell.screen_coords = vec2(
-		gl_InstanceID % glyph_count.x,
-		gl_InstanceID / glyph_count.x
+	// Determine screen coordinates of this cell. The instances of a draw call
+	// cover the current layer.
+	const ivec2 t_local = ivec2(
+		gl_InstanceID % layer_size.x,
+		gl_InstanceID / layer_size.x
 	);
 	
+	this_cell.screen_coords = vec2(layer_offset + t_local);
+	
 	// Retrieve the two uvec4 containing all cell data
-	const uvec4 t_high = texelFetch(input_buffer, gl_InstanceID*2);
-	const uvec4 t_low = texelFetch(input_buffer, (gl_InstanceID*2)+1);
+	const int t_index = cell_index(t_local);
+	const uvec4 t_high = texelFetch(input_buffer, t_index*2);
+	const uvec4 t_low = texelFetch(input_buffer, (t_index*2)+1);
+	
+	// Empty cells let the layers below show through
+	this_cell.empty = layer_transparent && (t_high == uvec4(0U)) && (t_low.rgb == uvec3(0U));
 	
 	// Retrieve front and back color
 	this_cell.front_color = vec4(vec3(t_high.rgb) / 255.f, 1.f);
@@ -452,10 +480,12 @@ void read_cell()
 	this_cell.light_mode = read_lm(t_low.a);
 	
 	// Read drop shadow orientations
-	read_shadows(t_low.a);
+	this_cell.shadows = read_shadows(t_low.a);
 	
-	// Read glyph set
-	this_cell.glyph_set = ((t_high.a & GLYPH_SET_MASK) >> GLYPH_SET_SHIFT);
+	// Read glyph set. Sets that are not present in the atlas fall back to
+	// the last one, instead of sampling the drop shadow layer.
+	this_cell.glyph_set = min((t_high.a & GLYPH_SET_MASK) >> GLYPH_SET_SHIFT,
+		shadow_layer - 1U);
 }
 
 // Calculates whether a light source can be seen from given cell
@@ -617,20 +647,34 @@ void main()
 	// Read cell data
 	read_cell();
 	
+	// Collapse all vertices of empty cells into one point, which results in
+	// no fragments being generated for them
+	if(this_cell.empty)
+	{
+		gl_Position = vec4(0.f, 0.f, 0.f, 1.f);
+		return;
+	}
+	
 	// Create vertex depending on current vertex ID
 	emit_vertex();
 	
 	// Calculate glyph texture coordinates for this cell
 	calc_tex_coords();
 	
+#ifndef NO_SHADOWS
 	// Calculate shadow coordinates for this cell
 	calc_shadow_coords();
+#endif
 	
+#ifndef NO_FOG
 	// Calculate fog
 	calc_fog();
+#endif
 	
+#if !defined(NO_LIGHTING) && !defined(NO_DYNAMIC_LIGHTING)
 	// Do lighting
 	calc_lighting();
+#endif
 	
 	// Write remaining data to output interface blocks
 	write_data();
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <asset_manager.hxx>
+#include <trace_log.hxx>
+
+auto asset_manager::set_memory_budget(::std::size_t p_bytes)
+	-> void
+{
+	{
+		::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+		m_Budget = p_bytes;
+	}
+	
+	m_TrimPending.store(true);
+}
+
+auto asset_manager::memory_budget() const
+	-> ::std::size_t
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	return m_Budget;
+}
+
+auto asset_manager::statistics() const
+	-> asset_cache_stats
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	auto t_stats = m_Stats;
+	t_stats.m_Entries = m_Cache.size();
+	
+	return t_stats;
+}
+
+auto asset_manager::trim()
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	evict_until(m_Budget);
+}
+
+auto asset_manager::purge()
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	evict_until(0U);
+}
+
+auto asset_manager::register_asset(const key_type& p_key, ::std::size_t p_size, ::std::shared_ptr<const void> p_asset)
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	if(const auto t_it = m_Cache.find(p_key); t_it != m_Cache.end())
+	{
+		t_it->second->m_Size = p_size;
+		t_it->second->m_Asset = p_asset;
+		t_it->second->m_Loaded = true;
+		m_Stats.m_MemoryUsage += p_size;
+	}
+}
+
+auto asset_manager::mark_failed(const key_type& p_key)
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	if(const auto t_it = m_Cache.find(p_key); t_it != m_Cache.end())
+		t_it->second->m_Failed = true;
+}
+
+auto asset_manager::remove_entry(const key_type& p_key)
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	if(const auto t_it = m_Cache.find(p_key); t_it != m_Cache.end())
+	{
+		m_Stats.m_MemoryUsage -= t_it->second->m_Size;
+		m_Cache.erase(t_it);
+	}
+}
+
+auto asset_manager::evict_until(::std::size_t p_bytes)
+	-> void
+{
+	while(m_Stats.m_MemoryUsage > p_bytes)
+	{
+		// Find least recently used entry that can be evicted
+		auto t_victim = m_Cache.end();
+		
+		for(auto t_it = m_Cache.begin(); t_it != m_Cache.end(); ++t_it)
+		{
+			if(!t_it->second->is_evictable())
+				continue;
+				
+			if(t_victim == m_Cache.end() || t_it->second->m_LastUse < t_victim->second->m_LastUse)
+				t_victim = t_it;
+		}
+		
+		// Everything that is left is still in use
+		if(t_victim == m_Cache.end())
+			break;
+			
+		m_Stats.m_MemoryUsage -= t_victim->second->m_Size;
+		m_Cache.erase(t_victim);
+		++m_Stats.m_Evictions;
+	}
+}
+
+auto asset_manager::initialize()
+	-> void
+{
+	m_Pool.start();
+}
+
+auto asset_manager::set_render_thread(::std::thread::id p_id)
+	-> void
+{
+	m_RenderThread.store(p_id);
+}
+
+auto asset_manager::shutdown()
+	-> void
+{
+	// Pending loads are abandoned, their futures will report a broken promise
+	m_Pool.stop();
+	
+	{
+		::std::lock_guard<::std::mutex> t_lock{ m_UploadMutex };
+		m_Uploads.clear();
+	}
+	
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	m_Cache.clear();
+	m_Stats.m_MemoryUsage = 0U;
+}
+
+auto asset_manager::post_upload(upload_type p_upload)
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_UploadMutex };
+	m_Uploads.push_back(::std::move(p_upload));
+}
+
+auto asset_manager::uploads_stalled()
+	-> bool
+{
+	if(m_RenderThread.load() != ::std::thread::id{ })
+		return false;
+	
+	::std::lock_guard<::std::mutex> t_lock{ m_UploadMutex };
+	return !m_Uploads.empty();
+}
+
+auto asset_manager::process_uploads(::std::size_t p_max)
+	-> ::std::size_t
+{
+	::std::size_t t_count{ };
+	
+	// Uploads require the GL context
+	if(::std::this_thread::get_id() != m_RenderThread.load())
+		return t_count;
+	
+	while(t_count < p_max)
+	{
+		upload_type t_upload{ };
+		
+		{
+			::std::lock_guard<::std::mutex> t_lock{ m_UploadMutex };
+			
+			if(m_Uploads.empty())
+				break;
+				
+			t_upload = ::std::move(m_Uploads.front());
+			m_Uploads.pop_front();
+		}
+		
+		// Uploads report errors through their promise
+		t_upload();
+		++t_count;
+	}
+	
+	if(t_count > 0U)
+		TRACE_D("asset_manager", "processed {} uploads", t_count);
+	
+	if(m_TrimPending.exchange(false))
+		trim();
+	
+	return t_count;
+}
@@ -63,4 +63,35 @@ extern "C"
 	{
 		return static_cast<bool_t>(internal::retrieve_config_value<bool>({p_path}));
 	}
+	
+	void configuration_enable_hot_reload()
+	{
+		global_state<configuration>().enable_hot_reload();
+	}
+	
+	void configuration_disable_hot_reload()
+	{
+		global_state<configuration>().disable_hot_reload();
+	}
+	
+	bool_t configuration_apply_changes()
+	{
+		return static_cast<bool_t>(global_state<configuration>().apply_changes());
+	}
+	
+	uint64_t configuration_add_listener(const char* p_prefix, config_listener_t p_listener, void* p_userData)
+	{
+		// A null prefix listens to all entries
+		return global_state<configuration>().add_listener(::std::string{ p_prefix ? p_prefix : "" },
+			[p_listener, p_userData](const ::std::string& p_path) -> void
+			{
+				p_listener(p_path.c_str(), p_userData);
+			}
+		);
+	}
+	
+	void configuration_remove_listener(uint64_t p_id)
+	{
+		global_state<configuration>().remove_listener(p_id);
+	}
 }
@@ -1,32 +1,87 @@
 #include <capi/debug.h>
+#include <cmath>
+#include <string>
 #include <random>
+#include <vector>
+#include <algorithm>
+#include <log.hxx>
 #include <global_state.hxx>
 #include <weighted_distribution.hxx>
 #include <shapes.hxx>
 #include <actions.hxx>
 
-extern "C"
+namespace internal
 {
-	void debug_create_test_scene()
+	// Layers and lights created by the last generated scene
+	struct debug_scene
 	{
-		auto t_palette = global_state<asset_manager>().load_asset<palette>("c64");
+		::std::vector<render_manager::layer_id> m_Layers;
+		::std::vector<light_manager::handle_type> m_Lights;
+	};
 	
-		std::random_device rd;
-		std::mt19937 t_gen(rd());
-    	std::uniform_int_distribution<unsigned> t_distrib(0, 16);
-    	std::uniform_real_distribution<float> t_intensityDistrib(0.4f, 1.0f); 
-		
-		weighted_distribution<glm::uvec3> t_groundClr{
+	debug_scene g_DebugScene{ };
+	
+	auto ground_colors()
+		-> weighted_distribution<glm::uvec3>
+	{
+		return {
 			{ { 0, 102, 43 }, 0.2f },
 			{ { 68, 102, 41 }, 0.2f },
 			{ { 0, 62, 26 }, 0.2f },
-			{ { 107, 107, 54 }, 0.15f },		
-			{ { 51, 77, 31 }, 0.1f },		
+			{ { 107, 107, 54 }, 0.15f },
+			{ { 51, 77, 31 }, 0.1f },
 			{ { 85, 128, 51 }, 0.06f },
 			{ { 0, 92, 38 }, 0.06f },
 			{ { 94, 94, 94 }, 0.03f }
 		};
+	}
 	
+	// Panel covering given fraction of the scene width at its right border,
+	// drawn on top of the scene using GUI mode cells
+	auto create_gui_panel(const glm::uvec2& p_scene, float p_coverage)
+		-> void
+	{
+		const auto t_width = static_cast<unsigned>(::std::lround(p_scene.x * ::std::clamp(p_coverage, 0.f, 1.f)));
+		
+		if(t_width == 0U)
+			return;
+		
+		auto& t_renderer = global_state<render_manager>();
+		
+		const auto t_id = t_renderer.create_layer({ t_width, p_scene.y }, { static_cast<int>(p_scene.x - t_width), 0 }, 1);
+		g_DebugScene.m_Layers.push_back(t_id);
+		
+		auto& t_panel = t_renderer.layer(t_id);
+		const glm::uvec2 t_br{ t_width - 1U, p_scene.y - 1U };
+		
+		t_panel.modify(area({ 0U, 0U }, t_br), draw(cell::glyph_type{ ' ' }, { 255U, 255U, 255U }, { 20U, 20U, 60U }));
+		
+		if(t_width >= 2U && p_scene.y >= 2U)
+			t_panel.modify(draw_border<thin_border_style>({ 0U, 0U }, t_br, set(glyph_set::graphics), background({ 20U, 20U, 60U })));
+		
+		for(unsigned t_row = 1U; t_row + 1U < p_scene.y; ++t_row)
+		{
+			const auto t_text = "Entry " + ::std::to_string(t_row);
+			t_panel.modify(draw_string({ 1U, t_row }, t_text, max_length(t_width - ::std::min(t_width, 2U)), background({ 20U, 20U, 60U })));
+		}
+		
+		t_panel.modify(area({ 0U, 0U }, t_br), set_gui_mode(true));
+	}
+}
+
+extern "C"
+{
+	void debug_create_test_scene()
+	{
+		auto t_palette = global_state<asset_manager>().acquire_asset<palette>("c64");
+		
+		std::random_device rd;
+		std::mt19937 t_gen(rd());
+    	std::uniform_int_distribution<unsigned> t_distrib(0, 16);
+    	std::uniform_real_distribution<float> t_intensityDistrib(0.4f, 1.0f);
+		
+		auto t_groundClr = internal::ground_colors();
+		
 		//===----------------------------------------------------------------------===//
 		// Screen
 		//
@@ -54,10 +109,108 @@ extern "C"
 		
 		for(::std::size_t t_ix = 0; t_ix < 8; ++t_ix)
 		{
-			t_screenManager.modify(point({24+t_ix, 1}), draw(background(t_palette.lookup(ut::enum_cast<color>(t_ix)))));
-			t_screenManager.modify(point({24+t_ix, 2}), draw(background(t_palette.lookup(ut::enum_cast<color>(t_ix+8)))));
+			t_screenManager.modify(point({24+t_ix, 1}), draw(background(t_palette->lookup(ut::enum_cast<color>(t_ix)))));
+			t_screenManager.modify(point({24+t_ix, 2}), draw(background(t_palette->lookup(ut::enum_cast<color>(t_ix+8)))));
+		}
+		
+		//===----------------------------------------------------------------------===//
+	}
+	
+	uint32_t debug_create_scene(scene_params_t* p_params)
+	{
+		debug_destroy_scene();
+		
+		auto& t_renderer = global_state<render_manager>();
+		auto& t_lights = global_state<light_manager>();
+		
+		::std::mt19937 t_gen{ p_params->seed };
+		::std::uniform_real_distribution<float> t_chance{ 0.f, 1.f };
+		::std::uniform_int_distribution<unsigned> t_glyph{ 33U, 126U };
+		::std::uniform_int_distribution<unsigned> t_channel{ 0U, 255U };
+		::std::uniform_int_distribution<unsigned> t_depth{ 0U, 8U };
+		::std::uniform_int_distribution<unsigned> t_shadows{ 1U, 255U };
+		
+		auto t_groundClr = internal::ground_colors();
+		
+		//===----------------------------------------------------------------------===//
+		// Scene layer
+		//
+		auto t_id = render_manager::base_layer;
+		
+		if(p_params->size.x > 0U && p_params->size.y > 0U)
+		{
+			t_id = t_renderer.create_layer({ p_params->size.x, p_params->size.y });
+			internal::g_DebugScene.m_Layers.push_back(t_id);
 		}
 		
+		auto& t_screen = t_renderer.layer(t_id);
+		const auto t_dims = t_screen.screen_size();
+		
+		t_screen.modify(area({ 0U, 0U }, t_dims - 1U), [&](cell& p_cell)
+		{
+			if(t_chance(t_gen) >= p_params->fillRatio)
+			{
+				p_cell = cell{ };
+				return;
+			}
+			
+			p_cell.set_glyph(static_cast<cell::glyph_type>(t_glyph(t_gen)));
+			p_cell.set_fg(cell::integral_color_type{ t_channel(t_gen), t_channel(t_gen), t_channel(t_gen) });
+			p_cell.set_bg(t_groundClr(t_gen));
+			p_cell.set_depth(static_cast<cell::depth_type>(t_depth(t_gen)));
+			p_cell.set_light_mode((t_chance(t_gen) < .5f) ? light_mode::dim : light_mode::full);
+			
+			if(t_chance(t_gen) < p_params->shadowDensity)
+				p_cell.set_shadows(t_shadows(t_gen) << 8U);
+		});
+		
 		//===----------------------------------------------------------------------===//
+		// Lights
+		//
+		::std::uniform_int_distribution<int> t_x{ 0, static_cast<int>(t_dims.x) - 1 };
+		::std::uniform_int_distribution<int> t_y{ 0, static_cast<int>(t_dims.y) - 1 };
+		::std::uniform_real_distribution<float> t_radius{ 3.f, 12.f };
+		::std::uniform_real_distribution<float> t_intensity{ 0.4f, 1.f };
+		
+		for(int t_ix = 0; t_ix < p_params->lightCount; ++t_ix)
+		{
+			if(!t_lights.has_space())
+			{
+				LOG_W_TAG("debug") << "scene only contains " << t_ix << " of " << p_params->lightCount << " requested lights";
+				break;
+			}
+			
+			light t_light{ };
+			t_light.m_Position = glm::ivec2{ t_x(t_gen), t_y(t_gen) };
+			t_light.m_Intensity = t_intensity(t_gen);
+			t_light.m_Color = glm::vec4{ t_chance(t_gen), t_chance(t_gen), t_chance(t_gen), 1.f };
+			t_light.m_AttFactors = glm::vec3{ 1.f, 0.f, 0.f };
+			t_light.m_Radius = t_radius(t_gen);
+			t_light.m_UseRadius = true;
+			
+			internal::g_DebugScene.m_Lights.push_back(t_lights.create_light(t_light));
+		}
+		
+		//===----------------------------------------------------------------------===//
+		// GUI
+		//
+		internal::create_gui_panel(t_dims, p_params->guiCoverage);
+		
+		//===----------------------------------------------------------------------===//
+		
+		return t_id;
+	}
+	
+	void debug_destroy_scene()
+	{
+		auto& t_scene = internal::g_DebugScene;
+		
+		for(const auto t_id: t_scene.m_Layers)
+			global_state<render_manager>().destroy_layer(t_id);
+		
+		for(const auto t_handle: t_scene.m_Lights)
+			global_state<light_manager>().destroy_light(t_handle);
+		
+		t_scene = internal::debug_scene{ };
 	}
 }
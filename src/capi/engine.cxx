@@ -20,6 +20,8 @@ extern "C"
 	
 	void engine_deinitialize()
 	{
+		// The render thread has to release the context before the window is destroyed
+		global_state<render_manager>().stop_render_thread();
 		global_state<render_context>().deinitialize();
 	}
 }
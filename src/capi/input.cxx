@@ -18,4 +18,14 @@ extern "C"
 	{
 		return static_cast<bool_t>(global_state<input_manager>().has_key(p_key));
 	}
+	
+	size_t input_drain_events(input_event_t* p_events, size_t p_capacity)
+	{
+		return global_state<input_manager>().drain_events(p_events, p_capacity);
+	}
+	
+	uint64_t input_dropped_events()
+	{
+		return global_state<input_manager>().dropped_events();
+	}
 }
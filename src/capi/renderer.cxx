@@ -7,5 +7,15 @@ extern "C"
 	void renderer_render()
 	{
 		global_state<render_manager>().render();
-	}	
+	}
+	
+	void renderer_set_scale(float p_scale)
+	{
+		global_state<render_manager>().set_scale(p_scale);
+	}
+	
+	float renderer_get_scale()
+	{
+		return global_state<render_manager>().scale();
+	}
 }
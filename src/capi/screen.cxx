@@ -1,11 +1,23 @@
 #include <capi/screen.h>
 #include <global_state.hxx>
 
+namespace internal
+{
+	// Layer all screen functions operate on
+	render_manager::layer_id g_ActiveLayer{ render_manager::base_layer };
+	
+	auto active_screen()
+		-> screen_manager&
+	{
+		return global_state<render_manager>().layer(g_ActiveLayer);
+	}
+}
+
 extern "C"
 {
 	void screen_get_dimensions(uvec2_t* p_out)
 	{
-		const auto& t_dims = global_state<render_manager>().screen().screen_size();
+		const auto& t_dims = internal::active_screen().screen_size();
 		
 		p_out->x = t_dims.x;
 		p_out->y = t_dims.y;
@@ -13,7 +25,7 @@ extern "C"
 	
 	void screen_set_tile(uvec2_t* p_pos, uvec3_t* p_front, uvec3_t* p_back, uint8_t p_glyph)
 	{
-		auto& t_cell = global_state<render_manager>().screen().modify_cell(*reinterpret_cast<glm::uvec2*>(p_pos));
+		auto& t_cell = internal::active_screen().modify_cell(*reinterpret_cast<glm::uvec2*>(p_pos));
 		
 		t_cell.set_fg(*reinterpret_cast<glm::uvec3*>(p_front));
 		t_cell.set_bg(*reinterpret_cast<glm::uvec3*>(p_back));
@@ -22,12 +34,12 @@ extern "C"
 	
 	void screen_clear_tile(uvec2_t* p_pos)
 	{
-		global_state<render_manager>().screen().clear_cell(*reinterpret_cast<glm::uvec2*>(p_pos));
+		internal::active_screen().clear_cell(*reinterpret_cast<glm::uvec2*>(p_pos));
 	}
 	
 	void screen_apply_commands(command_t* p_cmdbuf, int p_count)
 	{
-		auto& t_scr = global_state<render_manager>().screen();
+		auto& t_scr = internal::active_screen();
 	
 		for(int i = 0; i < p_count; ++i)
 		{
@@ -98,7 +110,7 @@ extern "C"
 	void screen_set_light_mode(uvec2_t* p_pos, int p_mode)
 	{
 		glm::uvec2 t_pos{ p_pos->x, p_pos->y };
-		global_state<render_manager>().screen().modify_cell(t_pos).set_light_mode(ut::enum_cast<light_mode>(p_mode));
+		internal::active_screen().modify_cell(t_pos).set_light_mode(ut::enum_cast<light_mode>(p_mode));
 	}
 	
 	void screen_set_gui_mode(uvec2_t* p_pos, bool_t p_flag)
@@ -106,12 +118,12 @@ extern "C"
 		glm::uvec2 t_pos{ p_pos->x, p_pos->y };
 		auto t_flag = static_cast<bool>(p_flag);
 	
-		global_state<render_manager>().screen().modify_cell(t_pos).set_gui_mode(t_flag);
+		internal::active_screen().modify_cell(t_pos).set_gui_mode(t_flag);
 	}
 	
 	void screen_clear()
 	{
-		auto& t_screen = global_state<render_manager>().screen();
+		auto& t_screen = internal::active_screen();
 		t_screen.clear();
 		
 		const auto t_screenDims = t_screen.screen_size();
@@ -130,6 +142,46 @@ extern "C"
 	{
 		glm::uvec2 t_pos{ p_pos->x, p_pos->y };
 	
-		global_state<render_manager>().screen().modify_cell(t_pos).set_depth(p_depth);
+		internal::active_screen().modify_cell(t_pos).set_depth(p_depth);
+	}
+	
+	uint32_t screen_create_layer(uvec2_t* p_dims, ivec2_t* p_offset, int p_zOrder)
+	{
+		return global_state<render_manager>().create_layer(
+			glm::uvec2{ p_dims->x, p_dims->y },
+			glm::ivec2{ p_offset->x, p_offset->y },
+			p_zOrder
+		);
+	}
+	
+	void screen_destroy_layer(uint32_t p_layer)
+	{
+		global_state<render_manager>().destroy_layer(p_layer);
+		
+		if(internal::g_ActiveLayer == p_layer)
+			internal::g_ActiveLayer = render_manager::base_layer;
+	}
+	
+	void screen_select_layer(uint32_t p_layer)
+	{
+		// Make sure the layer actually exists
+		global_state<render_manager>().layer(p_layer);
+		
+		internal::g_ActiveLayer = p_layer;
+	}
+	
+	void screen_set_layer_offset(uint32_t p_layer, ivec2_t* p_offset)
+	{
+		global_state<render_manager>().set_layer_offset(p_layer, glm::ivec2{ p_offset->x, p_offset->y });
+	}
+	
+	void screen_set_layer_z_order(uint32_t p_layer, int p_zOrder)
+	{
+		global_state<render_manager>().set_layer_z_order(p_layer, p_zOrder);
+	}
+	
+	void screen_set_layer_visible(uint32_t p_layer, bool_t p_flag)
+	{
+		global_state<render_manager>().set_layer_visible(p_layer, static_cast<bool>(p_flag));
 	}
 }
@@ -0,0 +1,84 @@
+#include <capi/world.h>
+#include <global_state.hxx>
+#include <world_store.hxx>
+
+namespace internal
+{
+	auto world_of(uint32_t p_layer)
+		-> world_grid&
+	{
+		return global_state<render_manager>().viewport(p_layer).world();
+	}
+}
+
+extern "C"
+{
+	uint32_t world_create_layer(uvec2_t* p_dims, ivec2_t* p_offset, int p_zOrder)
+	{
+		return global_state<render_manager>().create_world_layer(
+			::std::make_shared<world_grid>(),
+			glm::uvec2{ p_dims->x, p_dims->y },
+			glm::ivec2{ p_offset->x, p_offset->y },
+			p_zOrder
+		);
+	}
+	
+	uint32_t world_open_layer(const char* p_name, uvec2_t* p_dims, ivec2_t* p_offset, int p_zOrder)
+	{
+		const auto t_path = global_state<path_manager>().world_path() / p_name;
+	
+		return global_state<render_manager>().create_world_layer(
+			::std::make_shared<world_grid>(::std::make_unique<world_store>(t_path)),
+			glm::uvec2{ p_dims->x, p_dims->y },
+			glm::ivec2{ p_offset->x, p_offset->y },
+			p_zOrder
+		);
+	}
+	
+	void world_flush(uint32_t p_layer)
+	{
+		internal::world_of(p_layer).flush();
+	}
+	
+	void world_scroll_to(uint32_t p_layer, ivec2_t* p_pos)
+	{
+		global_state<render_manager>().viewport(p_layer).scroll_to({ p_pos->x, p_pos->y });
+	}
+	
+	void world_scroll(uint32_t p_layer, ivec2_t* p_delta)
+	{
+		global_state<render_manager>().viewport(p_layer).scroll({ p_delta->x, p_delta->y });
+	}
+	
+	void world_get_position(uint32_t p_layer, ivec2_t* p_out)
+	{
+		const auto& t_pos = global_state<render_manager>().viewport(p_layer).position();
+		
+		p_out->x = t_pos.x;
+		p_out->y = t_pos.y;
+	}
+	
+	void world_set_tile(uint32_t p_layer, ivec2_t* p_pos, uvec3_t* p_front, uvec3_t* p_back, uint8_t p_glyph)
+	{
+		auto& t_cell = internal::world_of(p_layer).modify_cell({ p_pos->x, p_pos->y });
+		
+		t_cell.set_fg(*reinterpret_cast<glm::uvec3*>(p_front));
+		t_cell.set_bg(*reinterpret_cast<glm::uvec3*>(p_back));
+		t_cell.set_glyph(p_glyph);
+	}
+	
+	void world_clear_tile(uint32_t p_layer, ivec2_t* p_pos)
+	{
+		internal::world_of(p_layer).clear_cell({ p_pos->x, p_pos->y });
+	}
+	
+	void world_set_light_mode(uint32_t p_layer, ivec2_t* p_pos, int p_mode)
+	{
+		internal::world_of(p_layer).modify_cell({ p_pos->x, p_pos->y }).set_light_mode(ut::enum_cast<light_mode>(p_mode));
+	}
+	
+	void world_set_depth(uint32_t p_layer, ivec2_t* p_pos, uint8_t p_depth)
+	{
+		internal::world_of(p_layer).modify_cell({ p_pos->x, p_pos->y }).set_depth(p_depth);
+	}
+}
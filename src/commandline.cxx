@@ -1,5 +1,6 @@
 #include <log.hxx>
 #include <commandline.hxx>
+#include <log_manager.hxx>
 #include <global_state.hxx>
 
 using namespace std::literals::string_literals;
@@ -57,6 +58,41 @@ cl::handler g_clHandler{
 		cl::short_name('F'),
 		cl::default_value(false),
 		cl::description("Determines if the logger also writes its output to a file")
+	},
+	
+	cl::enum_argument<log_mode>{
+		cl::id(cl_argument::logger_mode),
+		cl::long_name("log-mode"),
+		cl::category("Logger"),
+		cl::description("Sets whether log messages are written by the posting thread or by a background thread"),
+		cl::default_value(log_mode::sync),
+		cl::ignore_case,
+		
+		cl::enum_key_value("sync", 		log_mode::sync),
+		cl::enum_key_value("async", 	log_mode::async)
+	},
+	
+	cl::enum_argument<log_overflow_policy>{
+		cl::id(cl_argument::logger_overflow),
+		cl::long_name("log-overflow"),
+		cl::category("Logger"),
+		cl::description("Sets what happens to log messages when the queue of the background thread is full"),
+		cl::default_value(log_overflow_policy::drop),
+		cl::ignore_case,
+		
+		cl::enum_key_value("drop", 		log_overflow_policy::drop),
+		cl::enum_key_value("block", 	log_overflow_policy::block),
+		cl::enum_key_value("sync", 		log_overflow_policy::write_through)
+	},
+	
+	cl::boolean_argument
+	{
+		cl::id(cl_argument::logger_trace),
+		cl::long_name("trace"),
+		cl::category("Logger"),
+		cl::short_name('T'),
+		cl::default_value(false),
+		cl::description("Records trace events and messages posted through the log manager in a binary trace file, which can be read using trace_decode. Messages logged directly using liblog are not recorded")
 	}
 };
 
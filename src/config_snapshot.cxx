@@ -0,0 +1,359 @@
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <ut/throwf.hxx>
+#include <application_layer/config/config_snapshot.hxx>
+#include <application_layer/config/ptree_merge.hxx>
+
+namespace bip = boost::interprocess;
+
+namespace application_layer::config
+{
+	namespace internal
+	{
+		// Whether given entry value type has min/max values stored with it
+		template< typename T >
+		constexpr bool has_bounds_v = ::std::is_arithmetic_v<T> && !::std::is_same_v<T, bool>;
+	
+		// Sequential reader over a block of memory. Every read is bounds checked,
+		// since the snapshot file could be truncated or corrupted.
+		class snapshot_reader
+		{
+			public:
+				snapshot_reader(const char* p_begin, const char* p_end)
+					: m_Cur{p_begin}, m_End{p_end}
+				{
+				}
+				
+			public:
+				template< typename T >
+				auto read()
+					-> T
+				{
+					static_assert(::std::is_trivially_copyable_v<T>,
+						"snapshot_reader::read: T needs to be trivially copyable");
+				
+					require(sizeof(T));
+				
+					T t_val{ };
+					::std::memcpy(&t_val, m_Cur, sizeof(T));
+					m_Cur += sizeof(T);
+					
+					return t_val;
+				}
+				
+				auto read_string()
+					-> ::std::string
+				{
+					const auto t_len = read<::std::uint32_t>();
+					
+					require(t_len);
+					
+					::std::string t_str{ m_Cur, t_len };
+					m_Cur += t_len;
+					
+					return t_str;
+				}
+				
+				template< typename T >
+				auto read_value()
+					-> T
+				{
+					if constexpr(::std::is_same_v<T, ::std::string>)
+						return read_string();
+					else if constexpr(::std::is_same_v<T, bool>)
+						return read<::std::uint8_t>() != 0U;
+					else
+						return read<T>();
+				}
+				
+				auto read_stamp()
+					-> file_stamp
+				{
+					const auto t_size = read<file_stamp::size_type>();
+					const auto t_time = read<file_stamp::time_type>();
+					const auto t_hash = read<file_stamp::hash_type>();
+					
+					return { t_size, t_time, t_hash };
+				}
+				
+			private:
+				auto require(::std::size_t p_bytes) const
+					-> void
+				{
+					if(static_cast<::std::size_t>(m_End - m_Cur) < p_bytes)
+						throw ::std::runtime_error("unexpected end of data");
+				}
+		
+			private:
+				const char* m_Cur;
+				const char* m_End;
+		};
+		
+		template< typename T >
+		auto write(::std::ostream& p_str, const T& p_val)
+			-> void
+		{
+			static_assert(::std::is_trivially_copyable_v<T>,
+				"write: T needs to be trivially copyable");
+				
+			p_str.write(reinterpret_cast<const char*>(&p_val), sizeof(T));
+		}
+		
+		auto write_string(::std::ostream& p_str, const ::std::string& p_val)
+			-> void
+		{
+			write(p_str, static_cast<::std::uint32_t>(p_val.length()));
+			p_str.write(p_val.data(), p_val.length());
+		}
+		
+		template< typename T >
+		auto write_value(::std::ostream& p_str, const T& p_val)
+			-> void
+		{
+			if constexpr(::std::is_same_v<T, ::std::string>)
+				write_string(p_str, p_val);
+			else if constexpr(::std::is_same_v<T, bool>)
+				write(p_str, static_cast<::std::uint8_t>(p_val));
+			else
+				write(p_str, p_val);
+		}
+		
+		auto write_stamp(::std::ostream& p_str, const file_stamp& p_stamp)
+			-> void
+		{
+			write(p_str, p_stamp.size());
+			write(p_str, p_stamp.modification_time());
+			write(p_str, p_stamp.hash());
+		}
+		
+		// Writes a single scheme entry. The variant index is used as type tag.
+		auto write_entry(::std::ostream& p_str, const entry_variant& p_entry)
+			-> void
+		{
+			write(p_str, static_cast<::std::uint8_t>(p_entry.index()));
+		
+			::std::visit(
+				[&p_str](const auto& t_elem) -> void
+				{
+					using value_type = typename ::std::decay_t<decltype(t_elem)>::value_type;
+					
+					write_string(p_str, t_elem.path());
+					write_string(p_str, t_elem.name());
+					write_string(p_str, t_elem.description());
+					write_value(p_str, t_elem.default_value());
+					
+					if constexpr(has_bounds_v<value_type>)
+					{
+						write_value(p_str, t_elem.min());
+						write_value(p_str, t_elem.max());
+					}
+					
+					write(p_str, static_cast<::std::uint8_t>(t_elem.mapping().has_value()));
+					
+					if(t_elem.mapping())
+					{
+						const auto& t_map = *t_elem.mapping();
+						
+						write_string(p_str, t_map.category());
+						write_string(p_str, t_map.long_name());
+						write(p_str, static_cast<::std::uint8_t>(t_map.short_name().has_value()));
+						write(p_str, t_map.short_name().value_or('\0'));
+					}
+				},
+				p_entry
+			);
+		}
+		
+		template< typename T >
+		auto read_entry(snapshot_reader& p_reader)
+			-> entry_variant
+		{
+			const auto t_path = p_reader.read_string();
+			const auto t_name = p_reader.read_string();
+			const auto t_desc = p_reader.read_string();
+			const auto t_def = p_reader.read_value<T>();
+			
+			T t_min{ }, t_max{ };
+			
+			if constexpr(has_bounds_v<T>)
+			{
+				t_min = p_reader.read_value<T>();
+				t_max = p_reader.read_value<T>();
+			}
+			
+			::std::optional<mapping> t_map{ };
+			
+			if(p_reader.read<::std::uint8_t>())
+			{
+				const auto t_category = p_reader.read_string();
+				const auto t_longName = p_reader.read_string();
+				const auto t_hasShort = p_reader.read<::std::uint8_t>();
+				const auto t_short = p_reader.read<char>();
+				
+				t_map = mapping{
+					t_category,
+					t_longName,
+					t_hasShort ? ::std::optional<char>{ t_short } : ::std::optional<char>{ }
+				};
+			}
+			
+			if constexpr(has_bounds_v<T>)
+			{
+				return t_map ?
+					config_entry<T>{ t_path, t_name, t_desc, t_def, t_min, t_max, *t_map } :
+					config_entry<T>{ t_path, t_name, t_desc, t_def, t_min, t_max };
+			}
+			else
+			{
+				return t_map ?
+					config_entry<T>{ t_path, t_name, t_desc, t_def, *t_map } :
+					config_entry<T>{ t_path, t_name, t_desc, t_def };
+			}
+		}
+		
+		auto read_entry(snapshot_reader& p_reader)
+			-> entry_variant
+		{
+			// The type tag is the index into entry_variant
+			switch(p_reader.read<::std::uint8_t>())
+			{
+				case 0U:
+					return read_entry<bool>(p_reader);
+				case 1U:
+					return read_entry<int>(p_reader);
+				case 2U:
+					return read_entry<float>(p_reader);
+				case 3U:
+					return read_entry<::std::string>(p_reader);
+				default:
+					throw ::std::runtime_error("invalid entry type tag");
+			}
+		}
+	}
+	
+	config_snapshot::config_snapshot(const config_scheme& p_scheme, const tree_type& p_tree,
+			                         const file_stamp& p_schemeStamp, const file_stamp& p_configStamp)
+		: m_Scheme{p_scheme}, m_Tree{p_tree}, m_SchemeStamp{p_schemeStamp}, m_ConfigStamp{p_configStamp}
+	{
+	}
+	
+	config_snapshot::config_snapshot(const path_type& p_path)
+	{
+		if(!boost::filesystem::exists(p_path) || !boost::filesystem::is_regular_file(p_path))
+			throw ::std::runtime_error("config_snapshot: Could not open snapshot file: Does not exist");
+	
+		try
+		{
+			// Map whole file into memory. The mapping only lives as long as this
+			// constructor runs, since all data is decoded into owning containers.
+			bip::file_mapping t_file{ p_path.string().c_str(), bip::read_only };
+			bip::mapped_region t_region{ t_file, bip::read_only };
+			
+			const auto* t_begin = static_cast<const char*>(t_region.get_address());
+			internal::snapshot_reader t_reader{ t_begin, t_begin + t_region.get_size() };
+			
+			// Check header
+			if(t_reader.read<::std::uint64_t>() != magic)
+				throw ::std::runtime_error("invalid magic number");
+				
+			if(t_reader.read<::std::uint32_t>() != version)
+				throw ::std::runtime_error("format version mismatch");
+				
+			m_SchemeStamp = t_reader.read_stamp();
+			m_ConfigStamp = t_reader.read_stamp();
+			
+			// Read scheme entries
+			const auto t_entryCount = t_reader.read<::std::uint32_t>();
+			::std::vector<internal::entry_variant> t_entries{ };
+			t_entries.reserve(t_entryCount);
+			
+			for(::std::uint32_t t_ix = 0; t_ix < t_entryCount; ++t_ix)
+				t_entries.push_back(internal::read_entry(t_reader));
+				
+			m_Scheme = config_scheme{ ut::array_view<internal::entry_variant>{ t_entries.begin(), t_entries.end() } };
+			
+			// Read configuration values
+			const auto t_leafCount = t_reader.read<::std::uint32_t>();
+			
+			for(::std::uint32_t t_ix = 0; t_ix < t_leafCount; ++t_ix)
+			{
+				const auto t_path = t_reader.read_string();
+				m_Tree.put(t_path, t_reader.read_string());
+			}
+		}
+		catch(const ::std::exception& p_ex)
+		{
+			ut::throwf<::std::runtime_error>("config_snapshot: failed to load snapshot file \"%s\": %s",
+				p_path.string(),
+				p_ex.what()
+			);
+		}
+	}
+	
+	auto config_snapshot::save(const path_type& p_path) const
+		-> void
+	{
+		// Write to a temporary file first and then move it in place, to never leave
+		// a partially written snapshot behind
+		auto t_tmpPath = p_path;
+		t_tmpPath += ".tmp";
+	
+		{
+			::std::ofstream t_file{ t_tmpPath.string(), ::std::ios::binary | ::std::ios::trunc };
+			
+			if(!t_file)
+				throw ::std::runtime_error("config_snapshot: Could not create snapshot file");
+				
+			internal::write(t_file, magic);
+			internal::write(t_file, version);
+			internal::write_stamp(t_file, m_SchemeStamp);
+			internal::write_stamp(t_file, m_ConfigStamp);
+			
+			// Scheme entries
+			internal::write(t_file, static_cast<::std::uint32_t>(m_Scheme.view().size()));
+			
+			for(const auto& t_entry: m_Scheme)
+				internal::write_entry(t_file, t_entry);
+				
+			// Configuration values
+			::std::vector<::std::pair<::std::string, ::std::string>> t_leaves{ };
+			internal::flatten(m_Tree, t_leaves);
+			
+			internal::write(t_file, static_cast<::std::uint32_t>(t_leaves.size()));
+			
+			for(const auto& [t_path, t_value]: t_leaves)
+			{
+				internal::write_string(t_file, t_path);
+				internal::write_string(t_file, t_value);
+			}
+			
+			if(!t_file)
+				throw ::std::runtime_error("config_snapshot: Failed to write snapshot file");
+		}
+		
+		boost::filesystem::rename(t_tmpPath, p_path);
+	}
+	
+	auto config_snapshot::is_valid_for(const file_stamp& p_schemeStamp, const file_stamp& p_configStamp) const
+		-> bool
+	{
+		return m_SchemeStamp == p_schemeStamp && m_ConfigStamp == p_configStamp;
+	}
+	
+	auto config_snapshot::scheme() const
+		-> const config_scheme&
+	{
+		return m_Scheme;
+	}
+	
+	auto config_snapshot::tree() const
+		-> const tree_type&
+	{
+		return m_Tree;
+	}
+}
@@ -0,0 +1,114 @@
+#include <stdexcept>
+#include <string>
+#include <log.hxx>
+#include <application_layer/config/config_watcher.hxx>
+
+#if defined(__linux__)
+#	include <unistd.h>
+#	include <poll.h>
+#	include <sys/inotify.h>
+#endif
+
+namespace application_layer::config
+{
+	// Amount of milliseconds the watcher thread waits for events before
+	// checking whether it was requested to stop
+	static constexpr int g_PollTimeout = 250;
+
+	config_watcher::config_watcher(const path_type& p_path, callback_type p_callback)
+		: m_Path{p_path}, m_Callback{::std::move(p_callback)}
+	{
+	#if defined(__linux__)
+		m_Handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		
+		if(m_Handle < 0)
+			throw ::std::runtime_error("config_watcher: Failed to create inotify instance");
+			
+		// Watch containing directory for files being written or moved into place
+		const auto t_dir = m_Path.parent_path().string();
+		
+		if(inotify_add_watch(m_Handle, t_dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+		{
+			::close(m_Handle);
+			m_Handle = -1;
+			throw ::std::runtime_error("config_watcher: Failed to watch configuration directory");
+		}
+		
+		m_Running = true;
+		m_Thread = ::std::thread{ [this]() { run(); } };
+	#else
+		LOG_W_TAG("config_watcher") << "configuration hot-reload is not supported on this platform";
+	#endif
+	}
+	
+	config_watcher::~config_watcher()
+	{
+		stop();
+	}
+	
+	auto config_watcher::stop()
+		-> void
+	{
+		m_Running = false;
+		
+		if(m_Thread.joinable())
+			m_Thread.join();
+			
+	#if defined(__linux__)
+		if(m_Handle >= 0)
+		{
+			::close(m_Handle);
+			m_Handle = -1;
+		}
+	#endif
+	}
+	
+	auto config_watcher::run()
+		-> void
+	{
+	#if defined(__linux__)
+		const auto t_fileName = m_Path.filename().string();
+	
+		// Buffer suitably aligned for inotify_event structures
+		alignas(inotify_event) char t_buf[4096];
+		
+		while(m_Running)
+		{
+			pollfd t_pfd{ m_Handle, POLLIN, 0 };
+			
+			if(::poll(&t_pfd, 1, g_PollTimeout) <= 0)
+				continue;
+				
+			// Drain all pending events. Editors usually cause multiple events for
+			// a single save, so we only fire the callback once per batch.
+			bool t_modified{ false };
+			ssize_t t_len{ };
+			
+			while((t_len = ::read(m_Handle, t_buf, sizeof(t_buf))) > 0)
+			{
+				for(char* t_ptr = t_buf; t_ptr < t_buf + t_len; )
+				{
+					const auto* t_event = reinterpret_cast<const inotify_event*>(t_ptr);
+					
+					if(t_event->len > 0 && t_fileName == t_event->name)
+						t_modified = true;
+					
+					t_ptr += sizeof(inotify_event) + t_event->len;
+				}
+			}
+			
+			if(t_modified)
+			{
+				try
+				{
+					m_Callback();
+				}
+				catch(const ::std::exception& p_ex)
+				{
+					LOG_E_TAG("config_watcher") << "configuration reload failed: " << p_ex.what();
+				}
+			}
+		}
+	#endif
+	}
+}
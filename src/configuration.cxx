@@ -2,7 +2,13 @@
 #include <stdexcept>
 #include <iostream>
 #include <type_traits>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <vector>
+#include <unordered_map>
 #include <boost/filesystem/operations.hpp>
+#include <log.hxx>
 #include <ut/utility.hxx>
 
 #include <configuration.hxx>
@@ -13,6 +19,8 @@
 #include <application_layer/config/cl_source.hxx>
 #include <application_layer/config/default_source.hxx>
 #include <application_layer/config/file_source.hxx>
+#include <application_layer/config/config_snapshot.hxx>
+#include <application_layer/config/ptree_merge.hxx>
 
 using namespace application_layer::config;
 using namespace application_layer::config::internal;
@@ -20,6 +28,10 @@ using namespace application_layer::config::internal;
 auto configuration::tree()
 	-> tree_type&
 {
+	// The caller might modify the data tree through the returned reference,
+	// so all cached handle values have to be considered stale.
+	invalidate_handles();
+
 	return m_DataTree;
 }
 
@@ -35,8 +47,48 @@ auto configuration::scheme() const
 	return m_CfgScheme;
 }
 
+auto configuration::generation() const
+	-> generation_type
+{
+	return m_Generation;
+}
+
+auto configuration::invalidate_handles()
+	-> void
+{
+	++m_Generation;
+}
+
 auto configuration::initialize()
 	-> void
+{
+	const auto& t_paths = global_state<path_manager>();
+	
+	// Stamp both source documents. The binary snapshot is only usable if it was
+	// created from exactly these versions.
+	m_SchemeStamp = file_stamp{ t_paths.data_path() / "config" / "scheme.json" };
+	const file_stamp t_configStamp{ t_paths.config_path() };
+	
+	// Only parse the JSON documents if there is no up-to-date snapshot
+	if(!load_snapshot(m_SchemeStamp, t_configStamp))
+	{
+		load_sources();
+		
+		// The configuration file might have been rewritten, so it needs to be
+		// stamped again
+		write_snapshot(m_DataTree, m_SchemeStamp, file_stamp{ t_paths.config_path() });
+	}
+	
+	// Add all entries to the command line handler in the form of arguments, for which
+	// a mapping was defined
+	populate_cl_arguments();
+	
+	// Values cached before initialization are not valid anymore
+	invalidate_handles();
+}
+
+auto configuration::load_sources()
+	-> void
 {
 	// Retrieve configuration scheme file path
 	const auto t_schemepath = global_state<path_manager>().data_path() / "config" / "scheme.json";
@@ -44,32 +96,205 @@ auto configuration::initialize()
 	// Load scheme
 	m_CfgScheme = scheme_type{ t_schemepath };
 	
+	// Build data tree from defaults and configuration file
+	m_DataTree = resolve(scheme(), global_state<path_manager>().config_path());
+	
+	// Save back the configuration file. This makes sure that missing values
+	// are replaced with their defaults. If nothing changed, the file is left
+	// untouched.
+	save_if_changed();
+}
+
+auto configuration::resolve(const scheme_type& p_scheme, const boost::filesystem::path& p_path)
+	-> tree_type
+{
+	tree_type t_tree{ };
+
 	// Populate data tree with default settings. This way missing entries
 	// in the configuration file will fall back to default values.
-	default_source t_defSrc{ scheme() };
-	t_defSrc.populate(m_DataTree);
-
-	// Retrieve config file path
-	const auto t_path = global_state<path_manager>().config_path();
+	default_source t_defSrc{ p_scheme };
+	t_defSrc.populate(t_tree);
 	
 	// Check if the file exists. We only want to try to load it
 	// if it actually exists.
-	if(boost::filesystem::exists(t_path))
+	if(boost::filesystem::exists(p_path))
 	{
-		file_source t_fileSrc{ t_path };
-		t_fileSrc.populate(m_DataTree);
+		file_source t_fileSrc{ p_path };
+		t_fileSrc.populate(t_tree);
 	}
 	
 	// Perform bounds checking on all configuration entries
-	check_bounds();
+	check_bounds(p_scheme, t_tree);
 	
-	// Save back the configuration file. This makes sure that missing values
-	// are replaced with their defaults.
-	save();
+	return t_tree;
+}
+
+auto configuration::load_snapshot(const file_stamp& p_schemeStamp, const file_stamp& p_configStamp)
+	-> bool
+{
+	const auto& t_path = global_state<path_manager>().config_cache_path();
 	
-	// Add all entries to the command line handler in the form of arguments, for which
-	// a mapping was defined
-	populate_cl_arguments();
+	if(!boost::filesystem::exists(t_path))
+		return false;
+
+	try
+	{
+		config_snapshot t_snapshot{ t_path };
+		
+		if(!t_snapshot.is_valid_for(p_schemeStamp, p_configStamp))
+			return false;
+			
+		m_CfgScheme = t_snapshot.scheme();
+		m_DataTree = t_snapshot.tree();
+		
+		return true;
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		// A broken snapshot is not fatal, it will simply be rebuilt.
+		// The logger is not yet initialized at this point.
+		::std::cout << "configuration: warning: Ignoring configuration snapshot: "
+					<< p_ex.what() << ::std::endl;
+					
+		return false;
+	}
+}
+
+auto configuration::write_snapshot(const tree_type& p_tree, const file_stamp& p_schemeStamp, const file_stamp& p_configStamp) const
+	-> void
+{
+	try
+	{
+		config_snapshot t_snapshot{ scheme(), p_tree, p_schemeStamp, p_configStamp };
+		t_snapshot.save(global_state<path_manager>().config_cache_path());
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		::std::cout << "configuration: warning: Could not write configuration snapshot: "
+					<< p_ex.what() << ::std::endl;
+	}
+}
+
+auto configuration::shutdown()
+	-> void
+{
+	disable_hot_reload();
+}
+
+auto configuration::enable_hot_reload()
+	-> void
+{
+	if(m_Watcher)
+		return;
+		
+	const auto t_path = global_state<path_manager>().config_path();
+		
+	// The callback runs on the watcher thread. It only accesses the scheme and
+	// the scheme stamp, which are never modified after initialization, and
+	// publishes its result through an atomic pointer swap.
+	m_Watcher = ::std::make_unique<config_watcher>(t_path,
+		[this, t_path]() -> void
+		{
+			// Stamp first, so that concurrent modifications during the reload
+			// result in a stale snapshot rather than a wrong one
+			const file_stamp t_stamp{ t_path };
+			
+			const auto t_tree = ::std::make_shared<const tree_type>(resolve(scheme(), t_path));
+			
+			// Keep the snapshot up-to-date for the next start
+			write_snapshot(*t_tree, m_SchemeStamp, t_stamp);
+			
+			::std::atomic_store(&m_PendingTree, t_tree);
+		}
+	);
+	
+	LOG_I_TAG("configuration") << "hot-reload enabled for " << t_path;
+}
+
+auto configuration::disable_hot_reload()
+	-> void
+{
+	m_Watcher.reset();
+}
+
+auto configuration::apply_changes()
+	-> bool
+{
+	// Take ownership of pending tree, if any
+	const auto t_tree = ::std::atomic_exchange(&m_PendingTree, ::std::shared_ptr<const tree_type>{ });
+	
+	if(!t_tree)
+		return false;
+		
+	// Determine all entries whose value changed
+	::std::vector<::std::pair<::std::string, ::std::string>> t_oldLeaves{ }, t_newLeaves{ };
+	flatten(m_DataTree, t_oldLeaves);
+	flatten(*t_tree, t_newLeaves);
+	
+	::std::unordered_map<::std::string, ::std::string> t_oldValues{ t_oldLeaves.begin(), t_oldLeaves.end() };
+	::std::vector<::std::string> t_changed{ };
+	
+	for(const auto& [t_path, t_value]: t_newLeaves)
+	{
+		const auto t_it = t_oldValues.find(t_path);
+		
+		if(t_it == t_oldValues.end() || t_it->second != t_value)
+			t_changed.push_back(t_path);
+			
+		if(t_it != t_oldValues.end())
+			t_oldValues.erase(t_it);
+	}
+	
+	// Entries that were removed changed aswell
+	for(const auto& t_entry: t_oldValues)
+		t_changed.push_back(t_entry.first);
+		
+	// Swap in new data
+	m_DataTree = *t_tree;
+	invalidate_handles();
+	
+	LOG_I_TAG("configuration") << "configuration reloaded, " << t_changed.size() << " entries changed";
+	
+	// Notify listeners. A copy of the listener list is used, since listeners
+	// are allowed to unregister themselves.
+	const auto t_listeners = m_Listeners;
+	
+	for(const auto& t_path: t_changed)
+	{
+		// Overridden entries did not change their effective value
+		if(m_OverrideTree.get_child_optional(t_path))
+			continue;
+	
+		for(const auto& [t_id, t_listener]: t_listeners)
+		{
+			const auto& t_prefix = t_listener.first;
+			
+			const bool t_matches = t_prefix.empty() || t_path == t_prefix ||
+				(t_path.compare(0, t_prefix.length(), t_prefix) == 0 && t_path.length() > t_prefix.length()
+					&& t_path[t_prefix.length()] == '.');
+					
+			if(t_matches)
+				t_listener.second(t_path);
+		}
+	}
+	
+	return true;
+}
+
+auto configuration::add_listener(const ::std::string& p_prefix, listener_type p_listener)
+	-> listener_id
+{
+	const auto t_id = m_NextListener++;
+	
+	m_Listeners.emplace(t_id, ::std::make_pair(p_prefix, ::std::move(p_listener)));
+	
+	return t_id;
+}
+
+auto configuration::remove_listener(listener_id p_id)
+	-> void
+{
+	m_Listeners.erase(p_id);
 }
 
 auto configuration::populate_overrides()
@@ -80,6 +305,9 @@ auto configuration::populate_overrides()
 	// overwrite.
 	cl_source t_clSrc{ scheme(), g_clHandler };
 	t_clSrc.populate(m_OverrideTree);
+	
+	// Overrides take precedence, so cached values might be outdated now
+	invalidate_handles();
 }
 
 auto configuration::save() const
@@ -90,6 +318,31 @@ auto configuration::save() const
 	pt::write_json(t_path.string(), m_DataTree);
 }
 
+auto configuration::save_if_changed() const
+	-> bool
+{
+	const auto t_path = global_state<path_manager>().config_path();
+	
+	// Serialize data tree to memory first
+	::std::ostringstream t_newStr{ };
+	pt::write_json(t_newStr, m_DataTree);
+	
+	// Compare with current file contents, if any
+	if(boost::filesystem::exists(t_path))
+	{
+		::std::ifstream t_file{ t_path.string(), ::std::ios::binary };
+		const ::std::string t_oldStr{ ::std::istreambuf_iterator<char>{ t_file }, ::std::istreambuf_iterator<char>{ } };
+		
+		if(t_oldStr == t_newStr.str())
+			return false;
+	}
+	
+	::std::ofstream t_file{ t_path.string(), ::std::ios::binary | ::std::ios::trunc };
+	t_file << t_newStr.str();
+	
+	return true;
+}
+
 auto configuration::populate_cl_arguments()
 	-> void
 {
@@ -166,16 +419,16 @@ auto configuration::populate_cl_arguments()
 	}
 }
 
-auto configuration::check_bounds()
+auto configuration::check_bounds(const scheme_type& p_scheme, tree_type& p_tree)
 	-> void
 {
 	// Check all config entries described by the scheme
-	for(const auto& t_entry: scheme())
+	for(const auto& t_entry: p_scheme)
 	{
 		// The stored value is always of type `config_entry<T>`, where `T` is unknown to
 		// us at this point.
 		::std::visit(
-			[this](auto t_elem) -> void
+			[&p_tree](auto t_elem) -> void
 			{
 				using elem_type = ::std::decay_t<decltype(t_elem)>;
 				using value_type = typename elem_type::value_type;
@@ -185,7 +438,7 @@ auto configuration::check_bounds()
 				{
 					// Retrieve actual value from the tree.
 					// This operation is guarantueed to succeed.
-					const auto t_val = *tree().get_optional<value_type>(t_elem.path());
+					const auto t_val = *p_tree.get_optional<value_type>(t_elem.path());
 				
 					// Check if given value is in range given by configuration scheme
 					if(!ut::in_range<value_type>(t_val, t_elem.min(), t_elem.max()))
@@ -196,7 +449,7 @@ auto configuration::check_bounds()
 								  	<< t_elem.min() << ", " << t_elem.max() << "]. Using default value instead"
 								  	<< ::std::endl;
 								  	
-						tree().put(t_elem.path(), t_elem.default_value());
+						p_tree.put(t_elem.path(), t_elem.default_value());
 					}
 				}
 			},
@@ -0,0 +1,76 @@
+#include <fstream>
+#include <vector>
+#include <iterator>
+#include <boost/filesystem/operations.hpp>
+#include <file_stamp.hxx>
+
+auto fnv1a_hash(const void* p_data, ::std::size_t p_length, ::std::uint64_t p_seed)
+	-> ::std::uint64_t
+{
+	const auto* t_bytes = static_cast<const unsigned char*>(p_data);
+	auto t_hash = p_seed;
+	
+	for(::std::size_t t_ix = 0; t_ix < p_length; ++t_ix)
+	{
+		t_hash ^= t_bytes[t_ix];
+		t_hash *= 1099511628211ULL;
+	}
+	
+	return t_hash;
+}
+
+file_stamp::file_stamp(const path_type& p_path)
+{
+	// Missing files result in an absent stamp
+	if(!boost::filesystem::exists(p_path) || !boost::filesystem::is_regular_file(p_path))
+		return;
+		
+	m_Size = boost::filesystem::file_size(p_path);
+	m_ModTime = boost::filesystem::last_write_time(p_path);
+	
+	// Read whole file to calculate content hash
+	::std::ifstream t_file{ p_path.string(), ::std::ios::binary };
+	
+	::std::vector<char> t_buf(m_Size);
+	t_file.read(t_buf.data(), t_buf.size());
+	
+	m_Hash = fnv1a_hash(t_buf.data(), t_file.gcount());
+}
+
+auto file_stamp::size() const
+	-> size_type
+{
+	return m_Size;
+}
+
+auto file_stamp::modification_time() const
+	-> time_type
+{
+	return m_ModTime;
+}
+
+auto file_stamp::hash() const
+	-> hash_type
+{
+	return m_Hash;
+}
+
+auto file_stamp::exists() const
+	-> bool
+{
+	return m_Size != 0U || m_ModTime != 0 || m_Hash != 0U;
+}
+
+auto file_stamp::operator==(const file_stamp& p_other) const
+	-> bool
+{
+	return m_Size == p_other.m_Size
+		&& m_ModTime == p_other.m_ModTime
+		&& m_Hash == p_other.m_Hash;
+}
+
+auto file_stamp::operator!=(const file_stamp& p_other) const
+	-> bool
+{
+	return !(*this == p_other);
+}
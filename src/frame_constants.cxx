@@ -0,0 +1,56 @@
+#include <frame_constants.hxx>
+#include <gpu_stats.hxx>
+
+frame_constants_buffer::~frame_constants_buffer()
+{
+	if(m_GPUBuffer)
+		glDeleteBuffers(1, &m_GPUBuffer);
+}
+
+auto frame_constants_buffer::initialize()
+	-> void
+{
+	glGenBuffers(1, &m_GPUBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_GPUBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, buffer_size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_GPUBuffer);
+	
+	m_Dirty = true;
+}
+
+auto frame_constants_buffer::sync()
+	-> void
+{
+	if(!m_Dirty)
+		return;
+		
+	upload(m_Constants);
+	
+	m_Dirty = false;
+}
+
+auto frame_constants_buffer::upload(const frame_constants& p_constants) const
+	-> void
+{
+	// The whole block is small enough to always be written at once
+	glBindBuffer(GL_UNIFORM_BUFFER, m_GPUBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, buffer_size, static_cast<const void*>(&p_constants));
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	
+	gpu_stats::record_upload(buffer_size);
+}
+
+auto frame_constants_buffer::modify()
+	-> frame_constants&
+{
+	m_Dirty = true;
+	return m_Constants;
+}
+
+auto frame_constants_buffer::constants() const
+	-> const frame_constants&
+{
+	return m_Constants;
+}
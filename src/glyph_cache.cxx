@@ -0,0 +1,135 @@
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <ut/format.hxx>
+#include <ut/throwf.hxx>
+#include <glyph_cache.hxx>
+
+namespace bip = boost::interprocess;
+
+static_assert(::std::is_trivially_copyable_v<internal::glyph_cache_header>,
+	"glyph_cache_header needs to be trivially copyable");
+
+glyph_cache_entry::glyph_cache_entry(::std::unique_ptr<region_type> p_region)
+	: m_Region{::std::move(p_region)}
+{
+}
+
+glyph_cache_entry::~glyph_cache_entry() = default;
+
+auto glyph_cache_entry::header() const
+	-> const internal::glyph_cache_header&
+{
+	return *static_cast<const internal::glyph_cache_header*>(m_Region->get_address());
+}
+
+auto glyph_cache_entry::width() const
+	-> int
+{
+	return static_cast<int>(header().m_Width);
+}
+
+auto glyph_cache_entry::height() const
+	-> int
+{
+	return static_cast<int>(header().m_Height);
+}
+
+auto glyph_cache_entry::pixels() const
+	-> const void*
+{
+	return static_cast<const char*>(m_Region->get_address()) + sizeof(internal::glyph_cache_header);
+}
+
+glyph_cache::glyph_cache(const path_type& p_directory)
+	: m_Directory{p_directory}
+{
+}
+
+auto glyph_cache::entry_path(const path_type& p_source) const
+	-> path_type
+{
+	// Entries are named after the hash of the absolute source path
+	const auto t_src = boost::filesystem::absolute(p_source).string();
+	const auto t_hash = fnv1a_hash(t_src.data(), t_src.size());
+	
+	return m_Directory / ut::sprintf("%016llx.bin", static_cast<unsigned long long>(t_hash));
+}
+
+auto glyph_cache::load(const path_type& p_source, const file_stamp& p_stamp) const
+	-> ::std::unique_ptr<glyph_cache_entry>
+{
+	const auto t_path = entry_path(p_source);
+	
+	if(!p_stamp.exists() || !boost::filesystem::exists(t_path))
+		return nullptr;
+		
+	bip::file_mapping t_file{ t_path.string().c_str(), bip::read_only };
+	auto t_region = ::std::make_unique<bip::mapped_region>(t_file, bip::read_only);
+	
+	if(t_region->get_size() < sizeof(internal::glyph_cache_header))
+		return nullptr;
+		
+	internal::glyph_cache_header t_header{ };
+	::std::memcpy(&t_header, t_region->get_address(), sizeof(t_header));
+	
+	if(t_header.m_Magic != magic || t_header.m_Version != version)
+		return nullptr;
+		
+	if(file_stamp{ t_header.m_SourceSize, t_header.m_SourceTime, t_header.m_SourceHash } != p_stamp)
+		return nullptr;
+		
+	const auto t_expected = sizeof(internal::glyph_cache_header)
+		+ static_cast<::std::size_t>(t_header.m_Width) * t_header.m_Height * 4U;
+		
+	if(t_region->get_size() != t_expected)
+		return nullptr;
+		
+	return ::std::make_unique<glyph_cache_entry>(::std::move(t_region));
+}
+
+auto glyph_cache::store(const path_type& p_source, const file_stamp& p_stamp, int p_width, int p_height, int p_pitch, const void* p_pixels) const
+	-> void
+{
+	if(!boost::filesystem::exists(m_Directory))
+		boost::filesystem::create_directories(m_Directory);
+
+	// Every writer uses its own temporary file, since other threads or processes
+	// might store the same entry concurrently
+	const auto t_path = entry_path(p_source);
+	auto t_tmpPath = t_path;
+	t_tmpPath += boost::filesystem::unique_path(".%%%%-%%%%-%%%%-%%%%.tmp");
+	
+	{
+		::std::ofstream t_file{ t_tmpPath.string(), ::std::ios::binary | ::std::ios::trunc };
+		
+		if(!t_file)
+			ut::throwf<::std::runtime_error>("glyph_cache: could not open \"%s\" for writing", t_tmpPath.string());
+		
+		internal::glyph_cache_header t_header{ };
+		t_header.m_Magic = magic;
+		t_header.m_Version = version;
+		t_header.m_Width = static_cast<::std::uint32_t>(p_width);
+		t_header.m_Height = static_cast<::std::uint32_t>(p_height);
+		t_header.m_SourceSize = p_stamp.size();
+		t_header.m_SourceTime = p_stamp.modification_time();
+		t_header.m_SourceHash = p_stamp.hash();
+		
+		t_file.write(reinterpret_cast<const char*>(&t_header), sizeof(t_header));
+		
+		// Rows are stored tightly packed, regardless of the source pitch
+		const auto* t_row = static_cast<const char*>(p_pixels);
+		
+		for(int t_y = 0; t_y < p_height; ++t_y, t_row += p_pitch)
+			t_file.write(t_row, static_cast<::std::streamsize>(p_width) * 4);
+			
+		if(!t_file)
+			ut::throwf<::std::runtime_error>("glyph_cache: failed to write \"%s\"", t_tmpPath.string());
+	}
+	
+	// Replace old entry atomically, so concurrent readers never see partial files
+	boost::filesystem::rename(t_tmpPath, t_path);
+}
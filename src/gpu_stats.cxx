@@ -0,0 +1,30 @@
+#include <atomic>
+#include <gpu_stats.hxx>
+
+namespace gpu_stats
+{
+	namespace
+	{
+		::std::atomic<counter_type> g_Bytes{0U};
+		::std::atomic<counter_type> g_Uploads{0U};
+	}
+	
+	auto record_upload(::std::size_t p_bytes)
+		-> void
+	{
+		g_Bytes.fetch_add(p_bytes, ::std::memory_order_relaxed);
+		g_Uploads.fetch_add(1U, ::std::memory_order_relaxed);
+	}
+	
+	auto uploaded_bytes()
+		-> counter_type
+	{
+		return g_Bytes.load(::std::memory_order_relaxed);
+	}
+	
+	auto upload_count()
+		-> counter_type
+	{
+		return g_Uploads.load(::std::memory_order_relaxed);
+	}
+}
@@ -1,3 +1,5 @@
+#include <cmath>
+#include <algorithm>
 #include <GLXW/glxw.h>
 #include <input_manager.hxx>
 #include <global_state.hxx>
@@ -14,8 +16,11 @@ auto input_manager::initialize()
 	// but this saves the calls and is a commonly used idiom.
 	glfwSetWindowUserPointer(t_window, this);
 	
-	// Set key press callback function
+	// Set input callback functions
 	glfwSetKeyCallback(t_window, key_callback);
+	glfwSetCharCallback(t_window, char_callback);
+	glfwSetCursorPosCallback(t_window, cursor_callback);
+	glfwSetScrollCallback(t_window, scroll_callback);
 }
 
 auto input_manager::begin_input()
@@ -30,18 +35,28 @@ auto input_manager::end_input()
 {
 	// Clear key pressed that were only meant as one distinct press.
 	// Keys that are in REPEAT state are not affected.
-	this->keyDown.clear();
+	m_KeyDown.reset();
 }
 
-auto input_manager::process_key(key_type p_key, action_type p_action)
+auto input_manager::process_key(key_type p_key, action_type p_action, int p_mods)
 	-> void
 {
+	auto t_event = make_event(INPUT_EVENT_KEY);
+	t_event.key = p_key;
+	t_event.action = p_action;
+	t_event.mods = p_mods;
+	push_event(t_event);
+	
+	// Key codes outside of the range GLFW defines are only reported as events
+	if(p_key < 0 || p_key > GLFW_KEY_LAST)
+		return;
+	
 	switch(p_action)
 	{
 		case GLFW_PRESS:
 		{
 			// Insert given key into the key down set.
-			this->keyDown.insert(p_key);
+			m_KeyDown.set(p_key);
 			break;
 		}
 		case GLFW_REPEAT:
@@ -49,7 +64,7 @@ auto input_manager::process_key(key_type p_key, action_type p_action)
 			// Key is now considered as being repeatedly pressed, which means that it will
 			// fire each frame. This state is only left when a button release event is
 			// received.
-			this->keyRepeated.insert(p_key);
+			m_KeyRepeated.set(p_key);
 			break;
 		}
 		case GLFW_RELEASE:
@@ -57,17 +72,119 @@ auto input_manager::process_key(key_type p_key, action_type p_action)
 		{
 			// Remove the key from both key down aswell as key repeated set,
 			// since both states are canceled by this action.
-			this->keyDown.erase(p_key);
-			this->keyRepeated.erase(p_key);
+			m_KeyDown.reset(p_key);
+			m_KeyRepeated.reset(p_key);
 			break;
 		}
 	}
 }
 
-auto input_manager::has_key(key_type p_key)
+auto input_manager::process_text(unsigned p_codepoint)
+	-> void
+{
+	auto t_event = make_event(INPUT_EVENT_TEXT);
+	t_event.codepoint = p_codepoint;
+	push_event(t_event);
+}
+
+auto input_manager::process_cursor(double p_x, double p_y)
+	-> void
+{
+	// Cursor positions are reported in window coordinates, which depend on the
+	// output scale. Accessing the render manager is fine here, since events are
+	// only processed in begin_input.
+	const auto& t_window = global_state<render_context>().dimensions();
+	const auto t_screen = global_state<render_manager>().screen().screen_size();
+	
+	if(t_window.x == 0U || t_window.y == 0U)
+		return;
+	
+	const glm::ivec2 t_cell{
+		static_cast<int>(::std::floor(p_x * t_screen.x / t_window.x)),
+		static_cast<int>(::std::floor(p_y * t_screen.y / t_window.y))
+	};
+	
+	// Movement inside of a cell is not of interest
+	if(m_Cursor && *m_Cursor == t_cell)
+		return;
+	
+	m_Cursor = t_cell;
+	
+	auto t_event = make_event(INPUT_EVENT_MOUSE_MOVE);
+	t_event.cell = ivec2_t{ t_cell.x, t_cell.y };
+	push_event(t_event);
+}
+
+auto input_manager::process_wheel(double p_x, double p_y)
+	-> void
+{
+	auto t_event = make_event(INPUT_EVENT_WHEEL);
+	t_event.wheel_x = static_cast<float>(p_x);
+	t_event.wheel_y = static_cast<float>(p_y);
+	push_event(t_event);
+}
+
+auto input_manager::make_event(::std::uint32_t p_type) const
+	-> input_event
+{
+	input_event t_event{ };
+	t_event.type = p_type;
+	t_event.timestamp = static_cast<::std::uint64_t>(glfwGetTime() * 1000000.0);
+	
+	return t_event;
+}
+
+auto input_manager::push_event(const input_event& p_event)
+	-> void
+{
+	if(m_Count == event_capacity)
+	{
+		// Discard oldest event
+		m_First = (m_First + 1U) % event_capacity;
+		--m_Count;
+		++m_Dropped;
+	}
+	
+	m_Events[(m_First + m_Count) % event_capacity] = p_event;
+	++m_Count;
+}
+
+auto input_manager::drain_events(input_event* p_events, size_type p_capacity)
+	-> size_type
+{
+	const auto t_count = ::std::min(p_capacity, m_Count);
+	
+	// Copy in at most two contiguous blocks, since the pending events may wrap
+	// around the end of the ring buffer
+	const auto t_first = ::std::min(t_count, event_capacity - m_First);
+	::std::copy_n(m_Events.begin() + m_First, t_first, p_events);
+	::std::copy_n(m_Events.begin(), t_count - t_first, p_events + t_first);
+	
+	m_First = (m_First + t_count) % event_capacity;
+	m_Count -= t_count;
+	
+	return t_count;
+}
+
+auto input_manager::pending_events() const
+	-> size_type
+{
+	return m_Count;
+}
+
+auto input_manager::dropped_events() const
+	-> ::std::uint64_t
+{
+	return m_Dropped;
+}
+
+auto input_manager::has_key(key_type p_key) const
 	-> bool
 {
-	return this->keyDown.count(p_key) || this->keyRepeated.count(p_key);
+	if(p_key < 0 || p_key > GLFW_KEY_LAST)
+		return false;
+	
+	return m_KeyDown.test(p_key) || m_KeyRepeated.test(p_key);
 }
 
 auto key_callback(GLFWwindow* p_window, int p_key, int p_scancode, int p_action, int p_mods)
@@ -78,5 +195,23 @@ auto key_callback(GLFWwindow* p_window, int p_key, int p_scancode, int p_action,
 	
 	// Process key action
 	if(p_key != GLFW_KEY_UNKNOWN)
-		t_mgr.process_key(p_key, p_action);
+		t_mgr.process_key(p_key, p_action, p_mods);
+}
+
+auto char_callback(GLFWwindow* p_window, unsigned int p_codepoint)
+	-> void
+{
+	reinterpret_cast<input_manager*>(glfwGetWindowUserPointer(p_window))->process_text(p_codepoint);
+}
+
+auto cursor_callback(GLFWwindow* p_window, double p_x, double p_y)
+	-> void
+{
+	reinterpret_cast<input_manager*>(glfwGetWindowUserPointer(p_window))->process_cursor(p_x, p_y);
+}
+
+auto scroll_callback(GLFWwindow* p_window, double p_x, double p_y)
+	-> void
+{
+	reinterpret_cast<input_manager*>(glfwGetWindowUserPointer(p_window))->process_wheel(p_x, p_y);
 }
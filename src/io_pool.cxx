@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <stdexcept>
+#include <log.hxx>
+#include <io_pool.hxx>
+#include <log_manager.hxx>
+
+io_pool::~io_pool()
+{
+	stop();
+}
+
+auto io_pool::start(::std::size_t p_count)
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	if(m_Running)
+		return;
+		
+	if(p_count == 0U)
+	{
+		// Leave one core for the main thread
+		const ::std::size_t t_hw = ::std::thread::hardware_concurrency();
+		p_count = ::std::clamp<::std::size_t>(t_hw > 1U ? t_hw - 1U : 1U, 1U, 4U);
+	}
+	
+	m_Running = true;
+	
+	for(::std::size_t t_ix = 0; t_ix < p_count; ++t_ix)
+		m_Workers.emplace_back(&io_pool::run, this);
+}
+
+auto io_pool::stop()
+	-> void
+{
+	{
+		::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+		
+		if(!m_Running)
+			return;
+		
+		m_Running = false;
+		m_Tasks.clear();
+	}
+	
+	m_Condition.notify_all();
+	
+	for(auto& t_worker: m_Workers)
+		t_worker.join();
+		
+	m_Workers.clear();
+}
+
+auto io_pool::post(task_type p_task)
+	-> void
+{
+	{
+		::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+		
+		if(!m_Running)
+			throw ::std::runtime_error("io_pool: tried to post task to stopped pool");
+		
+		m_Tasks.push_back(::std::move(p_task));
+	}
+	
+	m_Condition.notify_one();
+}
+
+auto io_pool::is_running() const
+	-> bool
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	return m_Running;
+}
+
+auto io_pool::run()
+	-> void
+{
+	while(true)
+	{
+		task_type t_task{ };
+		
+		{
+			::std::unique_lock<::std::mutex> t_lock{ m_Mutex };
+			
+			m_Condition.wait(t_lock, [this]() { return !m_Running || !m_Tasks.empty(); });
+			
+			if(!m_Running)
+				return;
+				
+			t_task = ::std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+		
+		// Tasks are expected to report their own errors, this is only a safety net
+		try
+		{
+			t_task();
+		}
+		catch(const ::std::exception& p_ex)
+		{
+			LOG_POST_E_TAG("io_pool") << "uncaught exception in worker task: " << p_ex.what();
+		}
+	}
+}
@@ -2,9 +2,11 @@
 #include <iterator>
 #include <algorithm>
 #include <sstream>
+#include <cstring>
 #include <ut/cast.hxx>
 
 #include <lighting.hxx>
+#include <gpu_stats.hxx>
 
 
 /*light_manager::light_manager()
@@ -33,6 +35,32 @@ void light_manager::initialize()
 	glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_GPUBuffer);
 }
 
+void light_manager::pack(buffer_type& p_buffer) const
+{
+	// Same layout as written by sync()
+	::std::memcpy(p_buffer.data(), &m_State, state_size);
+	
+	for(::std::size_t t_index = 0, t_count = 0; t_index < m_Lights.size() && t_count < m_LightCount; ++t_index)
+	{
+		if(!m_Used[t_index])
+			continue;
+		
+		::std::memcpy(p_buffer.data() + state_size + (t_count * light_size), &m_Lights[t_index], light_size);
+		++t_count;
+	}
+	
+	::std::memcpy(p_buffer.data() + state_size + (max_lights * light_size), &m_LightCount, count_size);
+}
+
+void light_manager::upload(const buffer_type& p_buffer) const
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, m_GPUBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, buffer_size, static_cast<const void*>(p_buffer.data()));
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	
+	gpu_stats::record_upload(buffer_size);
+}
+
 void light_manager::sync()
 {
 	if(m_Dirty)
@@ -44,6 +72,7 @@ void light_manager::sync()
 		
 		// Copy state
 		glBufferSubData(GL_UNIFORM_BUFFER, 0, state_size, static_cast<const void*>(&m_State));
+		gpu_stats::record_upload(state_size);
 	
 		// Copy all active lights
 		if(m_LightCount > 0)
@@ -60,6 +89,7 @@ void light_manager::sync()
 								light_size,
 								static_cast<const void*>(&m_Lights[t_index])
 				);
+				gpu_stats::record_upload(light_size);
 			
 				++t_count;
 			}
@@ -67,6 +97,7 @@ void light_manager::sync()
 		
 		// Write light count	 
 		glBufferSubData(GL_UNIFORM_BUFFER, state_size + (max_lights * light_size), 4, &m_LightCount);
+		gpu_stats::record_upload(4U);
 	
 		// Unbind buffer
 		glBindBuffer(GL_UNIFORM_BUFFER, 0);
@@ -122,6 +153,16 @@ light& light_manager::modify_light(handle_type p_handle)
 }
 
 
+const lighting_state& light_manager::state() const
+{
+	return m_State;
+}
+
+light_manager::size_type light_manager::light_count() const
+{
+	return m_LightCount;
+}
+
 lighting_state& light_manager::modify_state()
 {
 	m_Dirty = true;
@@ -1,8 +1,45 @@
+#include <chrono>
+#include <algorithm>
+#include <ut/cast.hxx>
+#include <ut/console_color.hxx>
 #include <log_manager.hxx>
 #include <commandline.hxx>
 #include <global_state.hxx>
 #include <path_manager.hxx>
 
+namespace internal
+{
+	// How long the worker sleeps when the queue is empty. Producers do not
+	// signal the worker, since that would require taking a lock.
+	constexpr const auto log_poll_interval = ::std::chrono::milliseconds{ 2 };
+	
+	auto level_color(lg::severity_level p_lvl)
+		-> ut::console_color
+	{
+		switch(p_lvl)
+		{
+			case lg::severity_level::fatal:
+				return ut::console_color::bright_red;
+				break;
+			case lg::severity_level::error:
+				return ut::console_color::bright_red;
+				break;
+			case lg::severity_level::warning:
+				return ut::console_color::bright_yellow;
+				break;
+			case lg::severity_level::info:
+				return ut::console_color::bright_white;
+				break;
+			case lg::severity_level::debug:
+				return ut::console_color::bright_cyan;
+				break;
+			default:
+				LOG_F_TAG("libascii") << "Invalid log message severity supplied: " << ut::enum_cast(p_lvl);
+				::std::exit(EXIT_FAILURE);
+		}
+	}
+}
+
 auto log_manager::initialize()
 	-> void
 {
@@ -11,11 +48,11 @@ auto log_manager::initialize()
 	
 	// Retrieve console severity level threshold
 	auto t_level = g_clHandler.value<lg::severity_level>(cl_argument::logger_verbosity);
-
+	
 	// If verbose mode is activated, set level to debug
 	if(g_clHandler.value<bool>(cl_argument::logger_verbose))
 		t_level = lg::severity_level::debug;
-
+	
 	// Create and add console target
 	m_Console = ::std::make_unique<console_target>(t_level);
 	lg::logger::add_target(m_Console.get());
@@ -27,18 +64,261 @@ auto log_manager::initialize()
 		// Note that the path manager is initialized before the log manager,
 		// so accessing it is fine here.
 		const auto t_path = global_state<path_manager>().user_path() / "app.log";
-	
+		
 		// Retrieve flag telling us whether to truncate the log file or not
 		const auto t_append = g_clHandler.value<bool>(cl_argument::logger_append_file);
-	
+		
 		// Always use debug severity level when outputting to the log file
 		m_File = ::std::make_unique<file_target>(lg::severity_level::debug, t_path.string(), t_append);
 		lg::logger::add_target(m_File.get());
 	}
+	
+	// Add binary trace log, if requested. This receives all posted messages,
+	// regardless of their severity. It is not a liblog target, so messages
+	// logged using the LOG_*_TAG macros are not recorded.
+	if(g_clHandler.value<bool>(cl_argument::logger_trace))
+	{
+		m_Trace = ::std::make_unique<trace_log>(global_state<path_manager>().user_path() / "trace.bin");
+		trace_log::set_active(m_Trace.get());
+	}
+	
+	m_Policy = g_clHandler.value<log_overflow_policy>(cl_argument::logger_overflow);
+	m_Mode = g_clHandler.value<log_mode>(cl_argument::logger_mode);
+	
+	if(m_Mode == log_mode::async)
+		start_worker();
 }
 
 auto log_manager::shutdown()
 	-> void
 {
+	// All queued messages are written before the targets go away
+	stop_worker();
+	
+	const auto t_dropped = dropped();
+	
+	if(t_dropped > 0U)
+		LOG_W_TAG("log_manager") << "dropped " << t_dropped << " log messages due to queue overflow";
+	
+	if(m_Trace)
+	{
+		trace_log::set_active(nullptr);
+		m_Trace.reset();
+	}
+	
 	lg::logger::shutdown();
 }
+
+auto log_manager::start_worker()
+	-> void
+{
+	m_Queue = ::std::make_unique<queue_type>(queue_capacity);
+	m_Running = true;
+	m_Worker = ::std::thread{ &log_manager::run, this };
+}
+
+auto log_manager::stop_worker()
+	-> void
+{
+	if(!m_Running.exchange(false))
+		return;
+	
+	m_Wakeup.notify_all();
+	m_Worker.join();
+	
+	// Producers might have enqueued records after the worker did its last pass.
+	// Drain until no producer that saw the worker running is left, since every
+	// producer arriving later writes synchronously. Blocking producers rely on
+	// this to make room in the queue.
+	log_record t_record{ };
+	
+	while(true)
+	{
+		const auto t_producers = m_Producers.load();
+		
+		while(m_Queue->try_pop(t_record))
+			write(t_record);
+		
+		if(t_producers == 0U)
+			break;
+		
+		::std::this_thread::yield();
+	}
+}
+
+auto log_manager::post(log_record p_record)
+	-> void
+{
+	// Producers register before checking whether the worker is running. Both
+	// this and stop_worker use sequentially consistent operations, so either
+	// stop_worker waits for this producer, or the producer sees the worker
+	// stopped and writes synchronously.
+	m_Producers.fetch_add(1U);
+	
+	if(!m_Running.load())
+	{
+		m_Producers.fetch_sub(1U);
+		write(p_record);
+		return;
+	}
+	
+	try
+	{
+		enqueue(p_record);
+	}
+	catch(...)
+	{
+		m_Producers.fetch_sub(1U);
+		throw;
+	}
+	
+	m_Producers.fetch_sub(1U);
+}
+
+auto log_manager::enqueue(log_record& p_record)
+	-> void
+{
+	if(p_record.level() == lg::severity_level::fatal)
+	{
+		flush();
+		write(p_record);
+		return;
+	}
+	
+	// Count record before it becomes visible to the worker, so flush never
+	// misses a record that is about to be written
+	m_Posted.fetch_add(1U, ::std::memory_order_acq_rel);
+	
+	if(m_Queue->try_push(p_record))
+		return;
+	
+	switch(m_Policy.load(::std::memory_order_relaxed))
+	{
+		case log_overflow_policy::block:
+		{
+			do
+			{
+				m_Wakeup.notify_one();
+				::std::this_thread::yield();
+			}
+			while(!m_Queue->try_push(p_record));
+			
+			return;
+		}
+		case log_overflow_policy::write_through:
+		{
+			m_Posted.fetch_sub(1U, ::std::memory_order_acq_rel);
+			write(p_record);
+			return;
+		}
+		case log_overflow_policy::drop:
+		default:
+		{
+			m_Posted.fetch_sub(1U, ::std::memory_order_acq_rel);
+			m_Dropped.fetch_add(1U, ::std::memory_order_relaxed);
+			return;
+		}
+	}
+}
+
+auto log_manager::flush()
+	-> void
+{
+	if(!m_Running.load(::std::memory_order_acquire))
+		return;
+	
+	const auto t_target = m_Posted.load(::std::memory_order_acquire);
+	
+	m_Wakeup.notify_one();
+	
+	::std::unique_lock<::std::mutex> t_lock{ m_WaitMutex };
+	
+	// Records that failed to be enqueued are subtracted from the posted count
+	// again, so the target has to be re-evaluated. The worker notifies without
+	// holding the mutex, which is why this waits with a timeout.
+	while(m_Written.load(::std::memory_order_acquire) < ::std::min(t_target, m_Posted.load(::std::memory_order_acquire)))
+		m_Drained.wait_for(t_lock, internal::log_poll_interval);
+}
+
+auto log_manager::run()
+	-> void
+{
+	log_record t_record{ };
+	
+	while(true)
+	{
+		const auto t_running = m_Running.load(::std::memory_order_acquire);
+		bool t_any{ false };
+		
+		while(m_Queue->try_pop(t_record))
+		{
+			write(t_record);
+			m_Written.fetch_add(1U, ::std::memory_order_release);
+			t_any = true;
+		}
+		
+		if(t_any)
+			m_Drained.notify_all();
+		
+		if(!t_running)
+			break;
+		
+		::std::unique_lock<::std::mutex> t_lock{ m_WaitMutex };
+		m_Wakeup.wait_for(t_lock, internal::log_poll_interval);
+	}
+}
+
+auto log_manager::write(log_record& p_record)
+	-> void
+{
+	const auto t_lvl = p_record.level();
+	const auto t_clr = internal::level_color(t_lvl);
+	const auto& t_msg = p_record.message();
+	
+	// Tags of log messages are only known at runtime, so they can't be cached
+	// like the ids of TRACE_* events. Nothing is interned unless a trace log
+	// is receiving events.
+	if(auto* t_trace = trace_log::active())
+		t_trace->write(t_lvl, t_trace->intern(p_record.tag(), "{}"), t_msg);
+	
+	if(p_record.tag().empty())
+		LOGGER() += lg::log_entry("libascii", 0, p_record.is_bare()) << t_lvl << t_clr << t_msg;
+	else
+		LOGGER() += lg::log_entry("libascii", 0, p_record.is_bare()) << t_lvl << t_clr << lg::tag(p_record.tag()) << t_msg;
+}
+
+log_stream::~log_stream()
+{
+	// Destructors must not throw, failing to post only loses this message
+	try
+	{
+		global_state<log_manager>().post(log_record{ m_Level, m_Tag, m_Stream.str() });
+	}
+	catch(...)
+	{
+	}
+}
+
+auto log_manager::mode() const
+	-> log_mode
+{
+	return m_Mode;
+}
+
+auto log_manager::overflow_policy() const
+	-> log_overflow_policy
+{
+	return m_Policy.load(::std::memory_order_relaxed);
+}
+
+auto log_manager::set_overflow_policy(log_overflow_policy p_policy)
+	-> void
+{
+	m_Policy.store(p_policy, ::std::memory_order_relaxed);
+}
+
+auto log_manager::dropped() const
+	-> counter_type
+{
+	return m_Dropped.load(::std::memory_order_relaxed);
+}
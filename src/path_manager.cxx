@@ -132,6 +132,10 @@ auto path_manager::init_config_path()
 	-> void
 {
 	m_ConfigPath = user_path() / "config.json";
+	m_ConfigCachePath = user_path() / "config.cache";
+	m_GlyphCachePath = user_path() / "cache" / "glyphs";
+	m_ShaderCachePath = user_path() / "cache" / "shaders";
+	m_WorldPath = user_path() / "worlds";
 }
 
 auto path_manager::initialize()
@@ -160,4 +164,28 @@ auto path_manager::config_path() const
 	return m_ConfigPath;
 }
 
+auto path_manager::config_cache_path() const
+	-> const path_type&
+{
+	return m_ConfigCachePath;
+}
+
+
+
+auto path_manager::glyph_cache_path() const
+	-> const path_type&
+{
+	return m_GlyphCachePath;
+}
+
+auto path_manager::shader_cache_path() const
+	-> const path_type&
+{
+	return m_ShaderCachePath;
+}
 
+auto path_manager::world_path() const
+	-> const path_type&
+{
+	return m_WorldPath;
+}
@@ -0,0 +1,211 @@
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <log.hxx>
+#include <ut/format.hxx>
+#include <ut/throwf.hxx>
+#include <file_stamp.hxx>
+#include <program_cache.hxx>
+#include <log_manager.hxx>
+
+static_assert(::std::is_trivially_copyable_v<internal::program_cache_header>,
+	"program_cache_header needs to be trivially copyable");
+
+// Helpers only used in this file
+namespace
+{
+	// Read whole text file into string
+	auto read_source(const boost::filesystem::path& p_path)
+		-> ::std::string
+	{
+		::std::ifstream t_file{ p_path.string() };
+	
+		if(!t_file)
+			ut::throwf<gl::shader_exception>("Failed to open shader file \"%s\"", p_path.string());
+		
+		return { ::std::istreambuf_iterator<char>{ t_file }, ::std::istreambuf_iterator<char>{ } };
+	}
+	
+	// Insert define directives for given symbols after the version directive
+	auto inject_defines(const ::std::string& p_source, const ::std::vector<::std::string>& p_defines)
+		-> ::std::string
+	{
+		if(p_defines.empty())
+			return p_source;
+	
+		// The version directive has to stay the first statement of the shader
+		::std::size_t t_pos{ 0U };
+		::std::size_t t_line{ 1U };
+		
+		if(const auto t_version = p_source.find("#version"); t_version != ::std::string::npos)
+		{
+			const auto t_eol = p_source.find('\n', t_version);
+			t_pos = (t_eol == ::std::string::npos) ? p_source.size() : t_eol + 1U;
+			t_line = ::std::count(p_source.begin(), p_source.begin() + t_pos, '\n') + 1U;
+		}
+		
+		::std::string t_defines{ };
+	
+		for(const auto& t_define: p_defines)
+			t_defines += "#define " + t_define + "\n";
+
+		// Keep line numbers in compiler messages pointing at the original source
+		t_defines += "#line " + ::std::to_string(t_line) + "\n";
+	
+		auto t_result = p_source;
+		t_result.insert(t_pos, t_defines);
+	
+		return t_result;
+	}
+	
+	// Retrieve GL string, which might be null on broken drivers
+	auto gl_string(GLenum p_name)
+		-> ::std::string
+	{
+		const auto* t_str = reinterpret_cast<const char*>(glGetString(p_name));
+	
+		return t_str ? ::std::string{ t_str } : ::std::string{ };
+	}
+}
+
+program_cache::program_cache(const path_type& p_directory)
+	: m_Directory{p_directory}
+{
+	const auto t_driver = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION);
+	m_DriverHash = fnv1a_hash(t_driver.data(), t_driver.size());
+	
+	GLint t_formats{ };
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &t_formats);
+	m_Supported = (t_formats > 0);
+}
+
+auto program_cache::load(const path_type& p_vertex, const path_type& p_fragment, const ::std::vector<::std::string>& p_defines) const
+	-> gl::program
+{
+	const auto t_vsSource = inject_defines(read_source(p_vertex), p_defines);
+	const auto t_fsSource = inject_defines(read_source(p_fragment), p_defines);
+	
+	// Hash both sources in sequence. The separator avoids collisions between
+	// different splits of the same text.
+	auto t_hash = fnv1a_hash(t_vsSource.data(), t_vsSource.size());
+	t_hash = fnv1a_hash("\0", 1U, t_hash);
+	t_hash = fnv1a_hash(t_fsSource.data(), t_fsSource.size(), t_hash);
+	
+	if(m_Supported)
+	{
+		if(const auto t_binary = load_binary(t_hash))
+		{
+			try
+			{
+				gl::program t_program{ gl::from_binary, *t_binary };
+				
+				LOG_POST_D_TAG("program_cache") << "using cached program binary for \"" << p_vertex.filename().string() << "\"";
+				
+				return t_program;
+			}
+			catch(const gl::shader_exception& p_ex)
+			{
+				// The driver is free to reject binaries at any time
+				LOG_POST_I_TAG("program_cache") << "cached program binary was rejected, recompiling: " << p_ex.what();
+			}
+		}
+	}
+	
+	gl::program t_program{
+		gl::vertex_shader{ gl::from_text, t_vsSource },
+		gl::fragment_shader{ gl::from_text, t_fsSource }
+	};
+	
+	if(m_Supported)
+	{
+		try
+		{
+			store_binary(t_hash, t_program.binary());
+		}
+		catch(const ::std::exception& p_ex)
+		{
+			LOG_POST_W_TAG("program_cache") << "could not cache program binary: " << p_ex.what();
+		}
+	}
+	
+	return t_program;
+}
+
+auto program_cache::entry_path(::std::uint64_t p_sourceHash) const
+	-> path_type
+{
+	return m_Directory / ut::sprintf("%016llx.bin", static_cast<unsigned long long>(p_sourceHash));
+}
+
+auto program_cache::load_binary(::std::uint64_t p_sourceHash) const
+	-> ::std::optional<gl::program_binary>
+{
+	const auto t_path = entry_path(p_sourceHash);
+	
+	if(!boost::filesystem::exists(t_path))
+		return ::std::nullopt;
+		
+	::std::ifstream t_file{ t_path.string(), ::std::ios::binary };
+	
+	internal::program_cache_header t_header{ };
+	
+	if(!t_file.read(reinterpret_cast<char*>(&t_header), sizeof(t_header)))
+		return ::std::nullopt;
+		
+	if(t_header.m_Magic != magic || t_header.m_Version != version
+		|| t_header.m_SourceHash != p_sourceHash || t_header.m_DriverHash != m_DriverHash)
+	{
+		return ::std::nullopt;
+	}
+	
+	gl::program_binary t_binary{ };
+	t_binary.m_Format = static_cast<GLenum>(t_header.m_Format);
+	t_binary.m_Data.resize(t_header.m_Length);
+	
+	if(!t_file.read(t_binary.m_Data.data(), t_binary.m_Data.size()))
+		return ::std::nullopt;
+		
+	return t_binary;
+}
+
+auto program_cache::store_binary(::std::uint64_t p_sourceHash, const gl::program_binary& p_binary) const
+	-> void
+{
+	if(p_binary.m_Data.empty())
+		return;
+
+	if(!boost::filesystem::exists(m_Directory))
+		boost::filesystem::create_directories(m_Directory);
+		
+	// Every writer uses its own temporary file, since other threads or processes
+	// might store the same entry concurrently
+	const auto t_path = entry_path(p_sourceHash);
+	auto t_tmpPath = t_path;
+	t_tmpPath += boost::filesystem::unique_path(".%%%%-%%%%-%%%%-%%%%.tmp");
+	
+	{
+		::std::ofstream t_file{ t_tmpPath.string(), ::std::ios::binary | ::std::ios::trunc };
+		
+		if(!t_file)
+			ut::throwf<::std::runtime_error>("program_cache: could not open \"%s\" for writing", t_tmpPath.string());
+	
+		internal::program_cache_header t_header{ };
+		t_header.m_Magic = magic;
+		t_header.m_Version = version;
+		t_header.m_Format = static_cast<::std::uint32_t>(p_binary.m_Format);
+		t_header.m_SourceHash = p_sourceHash;
+		t_header.m_DriverHash = m_DriverHash;
+		t_header.m_Length = p_binary.m_Data.size();
+		
+		t_file.write(reinterpret_cast<const char*>(&t_header), sizeof(t_header));
+		t_file.write(p_binary.m_Data.data(), p_binary.m_Data.size());
+		
+		if(!t_file)
+			ut::throwf<::std::runtime_error>("program_cache: failed to write \"%s\"", t_tmpPath.string());
+	}
+	
+	// Replace old entry atomically, so concurrent readers never see partial files
+	boost::filesystem::rename(t_tmpPath, t_path);
+}
@@ -69,4 +69,35 @@ namespace application_layer::config::internal
 		
 		return t_dest;
 	}
+	
+	// Collects all leaf nodes of given tree together with their absolute paths
+	// and appends them to given vector.
+	auto flatten(const boost::property_tree::ptree& p_tree, ::std::vector<::std::pair<::std::string, ::std::string>>& p_out)
+		-> void
+	{
+		using ref_type = ::std::reference_wrapper<const boost::property_tree::ptree>;
+		using pair_type = ::std::pair<::std::string, ref_type>;
+		
+		// This uses the same breadth-first traversal as merge()
+		::std::queue<pair_type> t_trees{ };
+		t_trees.push(pair_type{ "", ::std::ref(p_tree) });
+		
+		while(!t_trees.empty())
+		{
+			auto [t_path, t_subtree] = t_trees.front();
+			t_trees.pop();
+			
+			for(const auto& t_child: t_subtree.get())
+			{
+				const auto t_childPath = (t_path.empty() ?
+						t_child.first.data() :
+						t_path + '.' + t_child.first.data());
+			
+				if(t_child.second.size() == 0)
+					p_out.emplace_back(t_childPath, t_child.second.data());
+				else
+					t_trees.push(pair_type{ t_childPath, ::std::ref(t_child.second) });
+			}
+		}
+	}
 }
@@ -111,8 +111,10 @@ auto render_context::init_glfw()
 	
 	glfwSetErrorCallback(glfw_error_callback);
 
+	// The shaders are written against GLSL 4.50, and texture storage (4.2) as
+	// well as debug output (4.3) are used unconditionally
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
 	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 	
@@ -165,7 +167,8 @@ auto render_context::resize(const dimension_type& p_dim)
 	
 	// Reset viewport
 	// const auto t_ratio = p_dim.x / static_cast<float>(p_dim.y);
-	glViewport(0, 0, p_dim.x, p_dim.y);
+	if(!m_Detached)
+		glViewport(0, 0, p_dim.x, p_dim.y);
 	
 	m_WindowSize = p_dim;
 }
@@ -179,6 +182,9 @@ auto render_context::dimensions() const
 auto render_context::end_frame()
 	-> void
 {
+	if(m_Detached)
+		return;
+
 	// TODO maybe this should be done in context.
 	glfwSwapBuffers(handle());
 }
@@ -186,9 +192,32 @@ auto render_context::end_frame()
 auto render_context::begin_frame()
 	-> void
 {
+	if(m_Detached)
+		return;
+
 	glClear(GL_COLOR_BUFFER_BIT);
 }
 
+auto render_context::detach_context()
+	-> void
+{
+	glfwMakeContextCurrent(nullptr);
+	m_Detached = true;
+}
+
+auto render_context::attach_context()
+	-> void
+{
+	glfwMakeContextCurrent(m_WindowHandle);
+	m_Detached = false;
+}
+
+auto render_context::is_detached() const
+	-> bool
+{
+	return m_Detached;
+}
+
 auto render_context::should_close() const
 	-> bool
 {
@@ -1,4 +1,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
+#include <cmath>
+#include <chrono>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -6,6 +9,9 @@
 #include <ut/format.hxx>
 #include <log.hxx>
 #include <renderer.hxx>
+#include <gpu_stats.hxx>
+#include <trace_log.hxx>
+#include <program_cache.hxx>
 #include <global_state.hxx>
 
 /*render_manager::render_manager(	render_context& p_context,
@@ -32,73 +38,708 @@ auto render_manager::initialize()
 {
 	LOG_D_TAG("render_manager") << "initialization started";
 
-	// Retrieve asset path
-	const auto& t_assetPath = global_state<path_manager>().data_path();
+	// Uploads have to happen on the thread owning the GL context. The asset
+	// manager might have been initialized on a worker thread.
+	auto& t_assets = global_state<asset_manager>();
+	t_assets.set_render_thread(::std::this_thread::get_id());
 
-	// TODO texture_set_loader
-	m_Tex = texture_set{
-		shadow_texture((t_assetPath / "textures" / "default" / "shadows.png").string()),
-		text_texture((t_assetPath / "textures" / "default" / "text.png").string()),
-		graphics_texture((t_assetPath / "textures" / "default" / "graphics.png").string())
-	};
-	
-	LOG_D_TAG("render_manager") << "texture glyph size is (" << m_Tex.glyph_size().x << ", " << m_Tex.glyph_size().y << ")";
+	// Decode glyph sheets in the background while the shader program is loaded
+	const auto t_texFuture = t_assets.acquire_asset_async<texture_set>("default");
 
-	// TODO program_loader
-	m_Program = gl::program{
-		gl::vertex_shader{ gl::from_file, (t_assetPath / "shaders" / "ascii.vs.glsl").string() },
-		gl::fragment_shader{ gl::from_file, (t_assetPath / "shaders" / "ascii.fs.glsl").string() }
-	};
+	// Create the full variant up front, which also validates the shader sources.
+	// All other variants are created on demand.
+	program_for(shader_variant::full);
 	
-	m_Screen.initialize();
-	m_GlyphCount = m_Screen.screen_size();
+	m_Tex = t_assets.await_asset(t_texFuture);
+	
+	LOG_D_TAG("render_manager") << "texture glyph size is (" << m_Tex->glyph_size().x << ", " << m_Tex->glyph_size().y << ")";
+	
+	// The base layer determines the size of the screen
+	auto t_base = ::std::make_unique<screen_layer>();
+	t_base->m_Screen.initialize();
+	m_GlyphCount = t_base->m_Screen.screen_size();
+	m_Layers.emplace(base_layer, ::std::move(t_base));
 
-	global_state<render_context>().resize({m_Tex.glyph_size().x * m_GlyphCount.x, m_Tex.glyph_size().y * m_GlyphCount.y});
+	// Output scale is optional, since older configuration schemes don't contain it
+	if(const auto t_scale = global_state<configuration>().get<float>("graphics.scale"))
+		m_Scale = *t_scale;
+		
+	glGenSamplers(1, &m_Sampler);
+	set_scale(m_Scale);
 
 	m_Vbo.initialize();
+	m_Constants.initialize();
 
-	m_Program.use();
 	set_uniforms();
+	
+	// The render thread is only started on the first frame, since other global
+	// systems still create GPU resources on this thread during initialization
+	auto& t_config = global_state<configuration>();
+	m_Threaded = t_config.get<bool>("graphics.render_thread").value_or(false);
+	
+	if(const auto t_buffers = t_config.get<unsigned int>("graphics.frame_buffers"))
+	{
+		if(*t_buffers == 2U)
+			m_HandoffMode = handoff_mode::double_buffered;
+		else if(*t_buffers == 3U)
+			m_HandoffMode = handoff_mode::triple_buffered;
+		else
+			LOG_W_TAG("render_manager") << "ignoring invalid number of frame buffers " << *t_buffers << ", expected 2 or 3";
+	}
+}
+
+auto render_manager::shutdown()
+	-> void
+{
+	stop_render_thread();
+
+	if(m_Sampler)
+	{
+		glDeleteSamplers(1, &m_Sampler);
+		m_Sampler = 0;
+	}
+	
+	m_Layers.clear();
+}
+
+auto render_manager::logical_size() const
+	-> dimension_type
+{
+	return dimension_type{ m_Tex->glyph_size() } * m_GlyphCount;
+}
+
+auto render_manager::set_scale(float p_scale)
+	-> void
+{
+	if(!::std::isfinite(p_scale) || p_scale <= 0.f)
+		ut::throwf<::std::runtime_error>("render_manager: invalid output scale %f", p_scale);
+
+	m_Scale = ::std::clamp(p_scale, 0.25f, 8.f);
+	apply_scale();
+}
+
+auto render_manager::scale() const
+	-> float
+{
+	return m_Scale;
+}
+
+auto render_manager::apply_scale()
+	-> void
+{
+	const auto t_logical = logical_size();
+	const dimension_type t_window{
+		static_cast<unsigned>(::std::lround(t_logical.x * m_Scale)),
+		static_cast<unsigned>(::std::lround(t_logical.y * m_Scale))
+	};
+	
+	LOG_D_TAG("render_manager") << "output scale is " << m_Scale;
+	
+	auto& t_context = global_state<render_context>();
+	t_context.resize(t_window);
+	
+	// The render thread picks up scale changes with the next frame
+	if(!t_context.is_detached())
+		apply_filtering(m_Scale);
+}
+
+auto render_manager::apply_filtering(float p_scale)
+	-> void
+{
+	// Integral upscaling maps every texel to a block of pixels, so nearest
+	// filtering is exact. Everything else needs filtering, and downscaling
+	// additionally uses the mipmap chain.
+	const bool t_integral = (p_scale >= 1.f) && (::std::floor(p_scale) == p_scale);
+	
+	glSamplerParameteri(m_Sampler, GL_TEXTURE_MAG_FILTER, t_integral ? GL_NEAREST : GL_LINEAR);
+	glSamplerParameteri(m_Sampler, GL_TEXTURE_MIN_FILTER, (p_scale < 1.f) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glSamplerParameteri(m_Sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glSamplerParameteri(m_Sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+auto render_manager::modify_frame_constants()
+	-> frame_constants&
+{
+	return m_Constants.modify();
 }
 
 auto render_manager::screen()
 	-> screen_manager&
 {
-	return m_Screen;
+	return layer(base_layer);
+}
+
+auto render_manager::find_layer(layer_id p_id)
+	-> screen_layer&
+{
+	const auto t_it = m_Layers.find(p_id);
+	
+	if(t_it == m_Layers.end())
+		ut::throwf<::std::runtime_error>("render_manager: unknown screen layer %u", p_id);
+		
+	return *t_it->second;
+}
+
+auto render_manager::create_layer(const dimension_type& p_dims, const offset_type& p_offset, int p_zOrder)
+	-> layer_id
+{
+	auto t_layer = ::std::make_unique<screen_layer>();
+	t_layer->m_Screen.initialize(p_dims);
+	t_layer->m_Offset = p_offset;
+	t_layer->m_ZOrder = p_zOrder;
+	
+	const auto t_id = m_NextLayer++;
+	m_Layers.emplace(t_id, ::std::move(t_layer));
+	
+	LOG_D_TAG("render_manager") << "created screen layer " << t_id;
+	
+	return t_id;
+}
+
+auto render_manager::create_world_layer(::std::shared_ptr<world_grid> p_world, const dimension_type& p_dims, const offset_type& p_offset, int p_zOrder)
+	-> layer_id
+{
+	auto t_layer = ::std::make_unique<screen_layer>();
+	t_layer->m_Viewport = ::std::make_unique<world_viewport>(::std::move(p_world), p_dims);
+	t_layer->m_Offset = p_offset;
+	t_layer->m_ZOrder = p_zOrder;
+	
+	const auto t_id = m_NextLayer++;
+	m_Layers.emplace(t_id, ::std::move(t_layer));
+	
+	LOG_D_TAG("render_manager") << "created world layer " << t_id;
+	
+	return t_id;
+}
+
+auto render_manager::destroy_layer(layer_id p_id)
+	-> void
+{
+	if(p_id == base_layer)
+		throw ::std::runtime_error("render_manager: the base layer can not be destroyed");
+		
+	find_layer(p_id);
+	m_Layers.erase(p_id);
+}
+
+auto render_manager::layer(layer_id p_id)
+	-> screen_manager&
+{
+	auto& t_layer = find_layer(p_id);
+	
+	if(t_layer.m_Viewport)
+		ut::throwf<::std::runtime_error>("render_manager: screen layer %u is a world layer", p_id);
+	
+	return t_layer.m_Screen;
+}
+
+auto render_manager::viewport(layer_id p_id)
+	-> world_viewport&
+{
+	auto& t_layer = find_layer(p_id);
+	
+	if(!t_layer.m_Viewport)
+		ut::throwf<::std::runtime_error>("render_manager: screen layer %u is not a world layer", p_id);
+	
+	return *t_layer.m_Viewport;
+}
+
+auto render_manager::set_layer_offset(layer_id p_id, const offset_type& p_offset)
+	-> void
+{
+	find_layer(p_id).m_Offset = p_offset;
+}
+
+auto render_manager::set_layer_z_order(layer_id p_id, int p_zOrder)
+	-> void
+{
+	find_layer(p_id).m_ZOrder = p_zOrder;
+}
+
+auto render_manager::set_layer_visible(layer_id p_id, bool p_visible)
+	-> void
+{
+	find_layer(p_id).m_Visible = p_visible;
 }
 
 auto render_manager::set_uniforms()
 	-> void
 {
-	auto& t_context = global_state<render_context>();
+	// The projection works in unscaled pixels. Scaling is done by the viewport.
+	const auto t_logical = logical_size();
+
+	// Everything except the samplers lives in the frame constants block
+	auto& t_constants = m_Constants.modify();
+	t_constants.m_Projection = glm::ortho(0.f, static_cast<float>(t_logical.x), static_cast<float>(t_logical.y), 0.f, -1.f, 1.f);
+	t_constants.m_SheetDimensions = glm::ivec2{ texture_set::sheet_width, texture_set::sheet_height };
+	t_constants.m_GlyphDimensions = m_Tex->glyph_size();
+	t_constants.m_GlyphCount = glm::ivec2{ m_GlyphCount };
+	t_constants.m_ShadowLayer = static_cast<::std::uint32_t>(m_Tex->shadow_layer());
+	
+}
+
+auto render_manager::select_variant(const screen_contents& p_contents) const
+	-> shader_variant::mask_type
+{
+	const auto& t_lights = global_state<light_manager>();
+	const auto& t_contents = p_contents;
+	
+	shader_variant::mask_type t_variant{ shader_variant::full };
+	
+	// Lighting only has an effect if there are cells that react to it
+	if(!t_lights.state().m_UseLighting || !t_contents.m_HasLitCells)
+		t_variant |= shader_variant::no_lighting;
+	else if(!t_lights.state().m_UseDynamic || t_lights.light_count() == 0U)
+		t_variant |= shader_variant::no_dynamic_lighting;
+		
+	if(!t_contents.m_HasShadows)
+		t_variant |= shader_variant::no_shadows;
+		
+	if(!t_contents.m_HasFog)
+		t_variant |= shader_variant::no_fog;
+		
+	return t_variant;
+}
+
+render_manager::variant_program::variant_program(gl::program&& p_program)
+	:	m_Program{ ::std::move(p_program) },
+		m_LayerOffset{ m_Program.uniform_location("layer_offset") },
+		m_LayerSize{ m_Program.uniform_location("layer_size") },
+		m_LayerTransparent{ m_Program.uniform_location("layer_transparent") },
+		m_LayerScroll{ m_Program.uniform_location("layer_scroll") },
+		m_LayerRing{ m_Program.uniform_location("layer_ring") }
+{
+}
 
-	// Set uniforms		
-	gl::set_uniform(m_Program, "fog_color", glm::vec4{ 0.1f, 0.1f, 0.3f, 1.f });
-	gl::set_uniform(m_Program, "fog_density", .15f);
-	gl::set_uniform(m_Program, "projection_mat", glm::ortho(0.f, static_cast<float>(t_context.dimensions().x), static_cast<float>(t_context.dimensions().y), 0.f, -1.f, 1.f));		
-	gl::set_uniform(m_Program, "sheet_dimensions", glm::ivec2{ texture_set::sheet_width, texture_set::sheet_height });
-	gl::set_uniform(m_Program, "glyph_dimensions", m_Tex.glyph_size());
-	gl::set_uniform(m_Program, "glyph_count", glm::ivec2{m_GlyphCount});
+auto render_manager::program_for(shader_variant::mask_type p_variant)
+	-> variant_program&
+{
+	if(const auto t_it = m_Programs.find(p_variant); t_it != m_Programs.end())
+		return t_it->second;
+		
+	// Build list of defines for this variant
+	::std::vector<::std::string> t_defines{ };
+	
+	if(p_variant & shader_variant::no_lighting)
+		t_defines.push_back("NO_LIGHTING");
+		
+	if(p_variant & shader_variant::no_dynamic_lighting)
+		t_defines.push_back("NO_DYNAMIC_LIGHTING");
+		
+	if(p_variant & shader_variant::no_shadows)
+		t_defines.push_back("NO_SHADOWS");
+		
+	if(p_variant & shader_variant::no_fog)
+		t_defines.push_back("NO_FOG");
+	
+	LOG_POST_D_TAG("render_manager") << "creating shader variant " << p_variant;
+	
+	// Compiling the shaders is only required if there is no cached binary for them
+	const auto& t_paths = global_state<path_manager>();
+	const program_cache t_programs{ t_paths.shader_cache_path() };
+	
+	auto t_program = t_programs.load(
+		t_paths.data_path() / "shaders" / "ascii.vs.glsl",
+		t_paths.data_path() / "shaders" / "ascii.fs.glsl",
+		t_defines
+	);
 	
 	// Samplers are just integers
-	gl::set_uniform(m_Program, "text_texture", 0);
-	gl::set_uniform(m_Program, "graphics_texture", 1);	
-	gl::set_uniform(m_Program, "shadow_texture", 2);
-	gl::set_uniform(m_Program, "input_buffer", 3);
+	t_program.use();
+	gl::set_uniform(t_program, "glyph_atlas", 0);
+	gl::set_uniform(t_program, "input_buffer", 3);
+	
+	return m_Programs.emplace(p_variant, ::std::move(t_program)).first->second;
+}
+
+auto render_manager::prepare_frame()
+	-> visible_list
+{
+	// Collect visible layers. Layers are stored ordered by identifier, so a
+	// stable sort keeps newer layers on top of older ones with the same z order.
+	visible_list t_visible{ };
+	
+	for(auto& t_entry: m_Layers)
+	{
+		if(t_entry.second->m_Visible)
+			t_visible.emplace_back(t_entry.first, t_entry.second.get());
+	}
+	
+	::std::stable_sort(t_visible.begin(), t_visible.end(),
+		[](const auto& p_a, const auto& p_b)
+		{
+			return p_a.second->m_ZOrder < p_b.second->m_ZOrder;
+		}
+	);
+	
+	// Light positions are given in world coordinates, so the lowest world layer
+	// determines the world position of the top left corner of the screen
+	const auto t_world = ::std::find_if(t_visible.begin(), t_visible.end(),
+		[](const auto& p_layer) { return static_cast<bool>(p_layer.second->m_Viewport); });
+	
+	if(t_world != t_visible.end())
+	{
+		auto& t_lights = global_state<light_manager>();
+		const auto* t_layer = t_world->second;
+		const glm::vec2 t_tl{ t_layer->m_Viewport->position() - t_layer->m_Offset };
+		
+		if(t_lights.state().m_TlPositon != t_tl)
+			t_lights.modify_state().m_TlPositon = t_tl;
+	}
+	
+	return t_visible;
+}
+
+auto render_manager::draw_layer(shader_variant::mask_type p_variant, const offset_type& p_offset, const dimension_type& p_dims,
+	bool p_transparent, const glm::ivec2& p_scroll, const glm::ivec2& p_ring)
+	-> void
+{
+	const auto& t_program = program_for(p_variant);
+	
+	// Locations were resolved when the variant was created. GL silently ignores
+	// location -1, which is used for uniforms a variant optimized out.
+	t_program.m_Program.use();
+	gl::set_uniform(t_program.m_LayerOffset, p_offset);
+	gl::set_uniform(t_program.m_LayerSize, glm::ivec2{ p_dims });
+	gl::set_uniform(t_program.m_LayerTransparent, p_transparent);
+	gl::set_uniform(t_program.m_LayerScroll, p_scroll);
+	gl::set_uniform(t_program.m_LayerRing, p_ring);
+	
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, p_dims.x * p_dims.y);
 }
 
 auto render_manager::render()
 	-> void
 {
-	// Sync state with gpu
+	if(m_Threaded)
+	{
+		publish_frame();
+		return;
+	}
+
+	// Finish assets that were loaded in the background
+	global_state<asset_manager>().process_uploads();
+
+	const auto t_visible = prepare_frame();
+	
+	// Sync state with gpu. Layers that were not modified are not uploaded again,
+	// and world layers only upload newly exposed or modified chunks.
 	global_state<light_manager>().sync();
-	m_Screen.sync();
+	m_Constants.sync();
+	
+	for(const auto& t_entry: t_visible)
+	{
+		auto* t_layer = t_entry.second;
+	
+		if(t_layer->m_Viewport)
+			t_layer->m_Viewport->sync();
+		else
+			t_layer->m_Screen.sync();
+	}
 	
 	// Reset openGl state
-	m_Program.use();
 	m_Vbo.use();
-	m_Tex.use();
+	m_Tex->use();
+	glBindSampler(0, m_Sampler);
+	
+	// Render every layer with a single instanced draw call, using the cheapest
+	// program variant that can render its contents
+	for(const auto& t_entry: t_visible)
+	{
+		const auto* t_layer = t_entry.second;
+		const auto* t_viewport = t_layer->m_Viewport.get();
+		
+		const auto& t_contents = t_viewport ? t_viewport->contents() : t_layer->m_Screen.contents();
+		const auto t_dims = t_viewport ? t_viewport->size() : t_layer->m_Screen.screen_size();
+		
+		if(t_viewport)
+			t_viewport->use();
+		else
+			t_layer->m_Screen.use();
+		
+		// Normal layers are stored in row-major order, signaled by an empty ring
+		draw_layer(select_variant(t_contents), t_layer->m_Offset, t_dims, t_entry.first != base_layer,
+			t_viewport ? t_viewport->position() : glm::ivec2{ },
+			t_viewport ? t_viewport->ring_size() : glm::ivec2{ });
+	}
+	
+	TRACE_D("render_manager", "rendered {} layers, {} bytes uploaded in total", t_visible.size(), gpu_stats::uploaded_bytes());
+}
+
+auto render_manager::is_threaded() const
+	-> bool
+{
+	return m_Threaded;
+}
+
+auto render_manager::skipped_frames() const
+	-> ::std::uint64_t
+{
+	return m_Handoff ? m_Handoff->skipped() : 0U;
+}
+
+auto render_manager::publish_frame()
+	-> void
+{
+	// Errors on the render thread are reported on the game thread
+	::std::exception_ptr t_error{ };
+	
+	{
+		::std::lock_guard<::std::mutex> t_lock{ m_ErrorMutex };
+		::std::swap(t_error, m_RenderError);
+	}
+	
+	if(t_error)
+	{
+		stop_render_thread();
+		::std::rethrow_exception(t_error);
+	}
+
+	if(!m_RenderThread.joinable())
+		start_render_thread();
+		
+	const auto t_visible = prepare_frame();
+	auto& t_lights = global_state<light_manager>();
+	auto& t_frame = m_Handoff->back();
+	
+	t_lights.pack(t_frame.m_Lights);
+	t_frame.m_Constants = m_Constants.constants();
+	t_frame.m_Scale = m_Scale;
+	t_frame.m_Window = global_state<render_context>().dimensions();
+	t_frame.m_Draws.clear();
+	
+	// Forget about layers that were destroyed
+	for(auto t_it = t_frame.m_Cells.begin(); t_it != t_frame.m_Cells.end(); )
+	{
+		if(m_Layers.count(t_it->first) == 0U)
+			t_it = t_frame.m_Cells.erase(t_it);
+		else
+			++t_it;
+	}
 	
-	// Render
-	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, m_GlyphCount.x * m_GlyphCount.y);
+	// Only layers that were modified since this snapshot was last filled are
+	// copied. World layers are flattened into row-major order.
+	for(const auto& t_entry: t_visible)
+	{
+		auto* t_layer = t_entry.second;
+		auto& t_cells = t_frame.m_Cells[t_entry.first];
+		
+		if(auto* t_viewport = t_layer->m_Viewport.get())
+		{
+			const auto t_revision = t_viewport->content_revision();
+			
+			if(t_cells.m_Revision != t_revision)
+			{
+				t_cells.m_Dims = t_viewport->size();
+				t_cells.m_Cells.resize(static_cast<::std::size_t>(t_cells.m_Dims.x) * t_cells.m_Dims.y);
+				t_cells.m_Contents = screen_contents{ false, false, false };
+				t_viewport->copy_cells(t_cells.m_Cells.data(), t_cells.m_Contents);
+				t_cells.m_Revision = t_revision;
+			}
+		}
+		else if(t_cells.m_Revision != t_layer->m_Screen.revision())
+		{
+			t_layer->m_Screen.update_contents();
+			
+			t_cells.m_Dims = t_layer->m_Screen.screen_size();
+			t_cells.m_Cells = t_layer->m_Screen.cells();
+			t_cells.m_Contents = t_layer->m_Screen.contents();
+			
+			t_cells.m_Revision = t_layer->m_Screen.revision();
+		}
+		
+		t_frame.m_Draws.push_back(render_frame::layer_draw{
+			t_entry.first,
+			t_layer->m_Offset,
+			t_entry.first != base_layer,
+			select_variant(t_cells.m_Contents)
+		});
+	}
+	
+	// Only fails if the render thread terminated, which is reported on the next frame
+	m_Handoff->publish();
+}
+
+auto render_manager::start_render_thread()
+	-> void
+{
+	LOG_I_TAG("render_manager") << "starting render thread with "
+		<< ((m_HandoffMode == handoff_mode::double_buffered) ? 2 : 3) << " frame buffers";
+
+	m_Handoff = ::std::make_unique<frame_handoff<render_frame>>(m_HandoffMode);
+	m_AppliedScale = 0.f;
+	m_AppliedWindow = dimension_type{ };
+	
+	// The context can only be current on one thread at a time
+	global_state<render_context>().detach_context();
+	
+	m_RenderRunning.store(true);
+	m_RenderThread = ::std::thread{ [this]() { run_render_thread(); } };
+}
+
+auto render_manager::stop_render_thread()
+	-> void
+{
+	if(!m_RenderThread.joinable())
+		return;
+		
+	LOG_D_TAG("render_manager") << "stopping render thread";
+		
+	m_RenderRunning.store(false);
+	m_Handoff->close();
+	m_RenderThread.join();
+	
+	global_state<render_context>().attach_context();
+	global_state<asset_manager>().set_render_thread(::std::this_thread::get_id());
+	
+	// Screens and viewports upload their current state on the next sync,
+	// since it was never synced while the render thread was running
+	m_Threaded = false;
+}
+
+auto render_manager::run_render_thread()
+	-> void
+{
+	auto& t_context = global_state<render_context>();
+	auto& t_assets = global_state<asset_manager>();
+
+	glfwMakeContextCurrent(t_context.handle());
+	t_assets.set_render_thread(::std::this_thread::get_id());
+	
+	try
+	{
+		while(m_RenderRunning.load())
+		{
+			// Finish assets that were loaded in the background
+			t_assets.process_uploads();
+		
+			// Wake up regularly to process uploads while no frames arrive
+			if(const auto* t_frame = m_Handoff->acquire(::std::chrono::milliseconds{ 2 }))
+			{
+				draw_frame(*t_frame);
+				glfwSwapBuffers(t_context.handle());
+				
+				TRACE_D("render_manager", "drew {} layers, {} frames skipped", t_frame->m_Draws.size(), m_Handoff->skipped());
+			}
+		}
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		LOG_POST_E_TAG("render_manager") << "render thread terminated: " << p_ex.what();
+		
+		::std::lock_guard<::std::mutex> t_lock{ m_ErrorMutex };
+		m_RenderError = ::std::current_exception();
+	}
+	catch(...)
+	{
+		LOG_POST_E_TAG("render_manager") << "render thread terminated by unknown exception";
+		
+		::std::lock_guard<::std::mutex> t_lock{ m_ErrorMutex };
+		m_RenderError = ::std::current_exception();
+	}
+	
+	// Make sure the game thread does not wait for frames to be consumed
+	m_Handoff->close();
+	
+	for(auto& t_entry: m_GPULayers)
+		release_gpu_layer(t_entry.second);
+		
+	m_GPULayers.clear();
+	
+	// Uploads can't be processed until another thread takes over the context
+	t_assets.set_render_thread(::std::thread::id{ });
+	glfwMakeContextCurrent(nullptr);
+}
+
+auto render_manager::draw_frame(const render_frame& p_frame)
+	-> void
+{
+	if(p_frame.m_Scale != m_AppliedScale || p_frame.m_Window != m_AppliedWindow)
+	{
+		glViewport(0, 0, p_frame.m_Window.x, p_frame.m_Window.y);
+		apply_filtering(p_frame.m_Scale);
+		
+		m_AppliedScale = p_frame.m_Scale;
+		m_AppliedWindow = p_frame.m_Window;
+	}
+
+	m_Constants.upload(p_frame.m_Constants);
+	global_state<light_manager>().upload(p_frame.m_Lights);
+	
+	// Release GPU copies of destroyed layers
+	for(auto t_it = m_GPULayers.begin(); t_it != m_GPULayers.end(); )
+	{
+		if(p_frame.m_Cells.count(t_it->first) == 0U)
+		{
+			release_gpu_layer(t_it->second);
+			t_it = m_GPULayers.erase(t_it);
+		}
+		else
+			++t_it;
+	}
+	
+	for(const auto& t_draw: p_frame.m_Draws)
+	{
+		auto& t_layer = m_GPULayers[t_draw.m_Id];
+		const auto& t_cells = p_frame.m_Cells.at(t_draw.m_Id);
+		
+		if(t_layer.m_Revision != t_cells.m_Revision)
+		{
+			TRACE_D("render_manager", "uploading layer {} at revision {}", t_draw.m_Id, t_cells.m_Revision);
+			upload_layer(t_layer, t_cells);
+		}
+	}
+	
+	glClear(GL_COLOR_BUFFER_BIT);
+	
+	m_Vbo.use();
+	m_Tex->use();
+	glBindSampler(0, m_Sampler);
+	
+	// All layers are stored in row-major order in threaded mode
+	for(const auto& t_draw: p_frame.m_Draws)
+	{
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_BUFFER, m_GPULayers.at(t_draw.m_Id).m_Texture);
+		
+		draw_layer(t_draw.m_Variant, t_draw.m_Offset, p_frame.m_Cells.at(t_draw.m_Id).m_Dims, t_draw.m_Transparent,
+			glm::ivec2{ }, glm::ivec2{ });
+	}
+}
+
+auto render_manager::upload_layer(gpu_layer& p_layer, const render_frame::layer_cells& p_cells)
+	-> void
+{
+	if(!p_layer.m_Buffer)
+	{
+		glGenBuffers(1, &p_layer.m_Buffer);
+		glGenTextures(1, &p_layer.m_Texture);
+		
+		// Binding creates the buffer object, storage is allocated below
+		glBindBuffer(GL_TEXTURE_BUFFER, p_layer.m_Buffer);
+		
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_BUFFER, p_layer.m_Texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, p_layer.m_Buffer);
+	}
+	
+	glBindBuffer(GL_TEXTURE_BUFFER, p_layer.m_Buffer);
+	glBufferData(GL_TEXTURE_BUFFER, p_cells.m_Cells.size() * sizeof(cell), static_cast<const GLvoid*>(p_cells.m_Cells.data()), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	
+	gpu_stats::record_upload(p_cells.m_Cells.size() * sizeof(cell));
+	
+	p_layer.m_Revision = p_cells.m_Revision;
+}
+
+auto render_manager::release_gpu_layer(gpu_layer& p_layer)
+	-> void
+{
+	if(p_layer.m_Texture)
+		glDeleteTextures(1, &p_layer.m_Texture);
+		
+	if(p_layer.m_Buffer)
+		glDeleteBuffers(1, &p_layer.m_Buffer);
+		
+	p_layer = gpu_layer{ };
 }
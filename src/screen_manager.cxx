@@ -1,9 +1,11 @@
 #include <stdexcept>
+#include <algorithm>
 #include <ut/throwf.hxx>
 #include <GLXW/glxw.h>
 #include <ut/format.hxx>
 #include <log.hxx>
 #include <screen.hxx>
+#include <gpu_stats.hxx>
 #include <uniform.hxx>
 #include <global_state.hxx>
 
@@ -38,35 +40,124 @@ void screen_manager::initialize()
 		throw ::std::runtime_error("screen dimensions not included in config file");
 	}*/
 	
-	m_ScreenDims = dimension_type{*t_w, *t_h};
-	m_Data.resize(*t_w * *t_h);
+	initialize(dimension_type{*t_w, *t_h});
+}
+
+void screen_manager::initialize(dimension_type p_dims)
+{
+	if(p_dims.x == 0U || p_dims.y == 0U)
+		ut::throwf<::std::runtime_error>("screen_manager: invalid screen dimensions (%u, %u)", p_dims.x, p_dims.y);
+
+	m_ScreenDims = p_dims;
+	m_Data.resize(p_dims.x * p_dims.y);
+	m_RowContents.assign(p_dims.y, screen_contents{ false, false, false });
 	
-	LOG_D_TAG("screen_manager") << "creating screen with dimensions (" << *t_w << ", " << *t_h << ")";
+	LOG_D_TAG("screen_manager") << "creating screen with dimensions (" << p_dims.x << ", " << p_dims.y << ")";
+	
+	// The initial contents have to be uploaded on the first sync
+	set_dirty();
+}
 
+void screen_manager::create_buffer()
+{
 	glActiveTexture(GL_TEXTURE3);
 	glGenTextures(1, &m_GPUTexture);
 	glGenBuffers(1, &m_GPUBuffer);
 	glBindBuffer(GL_TEXTURE_BUFFER, m_GPUBuffer);
 	glBufferData(GL_TEXTURE_BUFFER, m_Data.size()*sizeof(cell), static_cast<GLvoid*>(m_Data.data()), GL_DYNAMIC_DRAW);
 	glBindTexture(GL_TEXTURE_BUFFER, m_GPUTexture);
-	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, m_GPUBuffer);		
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, m_GPUBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	
+	gpu_stats::record_upload(m_Data.size()*sizeof(cell));
 }
 
 
+screen_manager::~screen_manager()
+{
+	if(m_GPUTexture)
+		glDeleteTextures(1, &m_GPUTexture);
+		
+	if(m_GPUBuffer)
+		glDeleteBuffers(1, &m_GPUBuffer);
+}
+
+void screen_manager::use() const
+{
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_BUFFER, m_GPUTexture);
+}
+
 void screen_manager::sync()
 {
 	if(m_Dirty)
 	{
-		glBindBuffer(GL_TEXTURE_BUFFER, m_GPUBuffer);
-		
-		glBufferData(GL_TEXTURE_BUFFER, m_Data.size()*sizeof(cell), static_cast<GLvoid*>(m_Data.data()), GL_DYNAMIC_DRAW);
+		if(!m_GPUBuffer)
+			create_buffer();
+		else
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, m_GPUBuffer);
+			
+			glBufferData(GL_TEXTURE_BUFFER, m_Data.size()*sizeof(cell), static_cast<GLvoid*>(m_Data.data()), GL_DYNAMIC_DRAW);
+			gpu_stats::record_upload(m_Data.size()*sizeof(cell));
+			
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		}
 		
-		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		update_contents();
 	
 		m_Dirty = false;
 	}
 }
 
+void screen_manager::update_contents()
+{
+	if(m_ContentsBegin >= m_ContentsEnd)
+		return;
+	
+	// Rows are summarized individually, so a modified cell only requires its
+	// own row to be scanned again
+	for(auto t_y = m_ContentsBegin; t_y < m_ContentsEnd; ++t_y)
+	{
+		screen_contents t_row{ false, false, false };
+		const auto* t_cells = &get_cell(t_y * m_ScreenDims.x);
+		
+		for(size_type t_x = 0; t_x < m_ScreenDims.x; ++t_x)
+			accumulate_contents(t_row, t_cells[t_x]);
+		
+		m_RowContents[t_y] = t_row;
+	}
+	
+	screen_contents t_contents{ false, false, false };
+	
+	for(const auto& t_row: m_RowContents)
+	{
+		t_contents.m_HasShadows |= t_row.m_HasShadows;
+		t_contents.m_HasFog |= t_row.m_HasFog;
+		t_contents.m_HasLitCells |= t_row.m_HasLitCells;
+	}
+	
+	m_Contents = t_contents;
+	m_ContentsBegin = m_ContentsEnd = 0U;
+}
+
+void accumulate_contents(screen_contents& p_contents, const cell& p_cell)
+{
+	const auto t_data = p_cell.m_Data;
+
+	p_contents.m_HasShadows |= ((t_data & internal::drop_shadow_mask) != 0U);
+	p_contents.m_HasFog |= ((t_data & internal::depth_mask) != 0U);
+	
+	// GUI cells and cells with light mode "none" are not affected by lighting
+	p_contents.m_HasLitCells |= ((t_data & internal::gui_mode_bit) == 0U)
+		&& ((t_data & internal::light_mode_mask) >> internal::light_mode_shift) != ut::enum_cast(light_mode::none);
+}
+
+const screen_contents& screen_manager::contents() const
+{
+	return m_Contents;
+}
+
 auto screen_manager::calc_index(position_type p_pos) const
 	-> index_type
 {
@@ -75,7 +166,37 @@ auto screen_manager::calc_index(position_type p_pos) const
 
 void screen_manager::set_dirty()
 {
+	set_dirty(0U, m_ScreenDims.y);
+}
+
+void screen_manager::set_dirty(size_type p_begin, size_type p_end)
+{
+	if(p_begin < p_end)
+	{
+		if(m_ContentsBegin >= m_ContentsEnd)
+		{
+			m_ContentsBegin = p_begin;
+			m_ContentsEnd = p_end;
+		}
+		else
+		{
+			m_ContentsBegin = ::std::min(m_ContentsBegin, p_begin);
+			m_ContentsEnd = ::std::max(m_ContentsEnd, p_end);
+		}
+	}
+	
 	m_Dirty = true;
+	++m_Revision;
+}
+
+const screen_manager::container_type& screen_manager::cells() const
+{
+	return m_Data;
+}
+
+screen_manager::revision_type screen_manager::revision() const
+{
+	return m_Revision;
 }
 
 cell& screen_manager::get_cell(index_type p_idx)
@@ -117,7 +238,7 @@ void screen_manager::clear_cell(position_type p_pos)
 		ut::throwf<::std::runtime_error>("screen_manager::clear_cell: Position out of bounds: (%u, %u)", p_pos.x, p_pos.y);
 
 	clear_cell(calc_index(p_pos));
-	set_dirty();
+	set_dirty(p_pos.y, p_pos.y + 1U);
 }
 
 cell& screen_manager::modify_cell(position_type p_pos)
@@ -125,11 +246,21 @@ cell& screen_manager::modify_cell(position_type p_pos)
 	if(!check_position(p_pos))
 		ut::throwf<::std::runtime_error>("screen_manager::modify_cell: Position out of bounds: (%u, %u)", p_pos.x, p_pos.y);
 
-	set_dirty();
+	set_dirty(p_pos.y, p_pos.y + 1U);
 	
 	return get_cell(calc_index(p_pos));
 }
 
+cell* screen_manager::modify_span(position_type p_pos, size_type p_count)
+{
+	if(!check_position(p_pos) || p_count > (m_ScreenDims.x - p_pos.x))
+		ut::throwf<::std::runtime_error>("screen_manager::modify_span: Span out of bounds: (%u, %u) + %zu", p_pos.x, p_pos.y, p_count);
+
+	set_dirty(p_pos.y, p_pos.y + 1U);
+	
+	return &get_cell(calc_index(p_pos));
+}
+
 const cell& screen_manager::read_cell(position_type p_pos) const
 {
 	if(!check_position(p_pos))
@@ -145,7 +276,7 @@ void screen_manager::set_cell(position_type p_pos, const cell& p_cell)
 	
 	m_Data[calc_index(p_pos)] = p_cell;
 	
-	set_dirty();
+	set_dirty(p_pos.y, p_pos.y + 1U);
 }
 
 
@@ -0,0 +1,487 @@
+#include <limits>
+#include <algorithm>
+#include <shapes.hxx>
+
+namespace internal
+{
+	// Helpers only used in this file
+	namespace
+	{
+		// A span on a single row with inclusive signed bounds, used while
+		// rasterizing shapes that might extend beyond the screen origin
+		struct row_span
+		{
+			int m_Y;
+			int m_Begin;
+			int m_End;
+		};
+	
+		// Convert row spans to screen spans, dropping cells with negative coordinates
+		auto to_spans(const ::std::vector<row_span>& p_rows)
+			-> ::std::vector<span>
+		{
+			::std::vector<span> t_spans{ };
+			t_spans.reserve(p_rows.size());
+		
+			for(const auto& t_row: p_rows)
+			{
+				const auto t_begin = ::std::max(t_row.m_Begin, 0);
+			
+				if(t_row.m_Y < 0 || t_row.m_End < t_begin)
+					continue;
+			
+				t_spans.push_back(span{
+					screen_manager::position_type{ static_cast<unsigned>(t_begin), static_cast<unsigned>(t_row.m_Y) },
+					static_cast<::std::size_t>(t_row.m_End - t_begin) + 1U
+				});
+			}
+		
+			return t_spans;
+		}
+	
+		// Rows of a filled ellipse. Cells are included if their center lies inside
+		// an ellipse with radii extended by half a cell, which gives round shapes
+		// for small radii.
+		auto ellipse_rows(const screen_manager::position_type& p_center, const glm::uvec2& p_radii)
+			-> ::std::vector<row_span>
+		{
+			const auto t_rx = static_cast<int>(p_radii.x);
+			const auto t_ry = static_cast<int>(p_radii.y);
+			const auto t_cx = static_cast<int>(p_center.x);
+			const auto t_cy = static_cast<int>(p_center.y);
+		
+			::std::vector<row_span> t_rows{ };
+			t_rows.reserve(static_cast<::std::size_t>(2 * t_ry + 1));
+		
+			for(int t_dy = -t_ry; t_dy <= t_ry; ++t_dy)
+			{
+				const auto t_y = static_cast<float>(t_dy) / (static_cast<float>(t_ry) + 0.5f);
+				const auto t_w = static_cast<float>(t_rx) + 0.5f;
+				const auto t_half = ::std::min(t_rx, static_cast<int>(::std::floor(t_w * ::std::sqrt(::std::max(0.f, 1.f - t_y * t_y)))));
+			
+				t_rows.push_back(row_span{ t_cy + t_dy, t_cx - t_half, t_cx + t_half });
+			}
+		
+			return t_rows;
+		}
+	
+		// Remove the interior of a shape given as one row span per consecutive row.
+		// A cell is part of the interior if all of its four neighbours are part of
+		// the shape.
+		auto outline_rows(const ::std::vector<row_span>& p_rows)
+			-> ::std::vector<row_span>
+		{
+			::std::vector<row_span> t_outline{ };
+			t_outline.reserve(p_rows.size() * 2U);
+		
+			for(::std::size_t t_ix = 0; t_ix < p_rows.size(); ++t_ix)
+			{
+				const auto& t_row = p_rows[t_ix];
+			
+				if(t_ix == 0 || t_ix + 1 == p_rows.size())
+				{
+					t_outline.push_back(t_row);
+					continue;
+				}
+			
+				const auto& t_above = p_rows[t_ix - 1];
+				const auto& t_below = p_rows[t_ix + 1];
+			
+				const auto t_begin = ::std::max({ t_row.m_Begin + 1, t_above.m_Begin, t_below.m_Begin });
+				const auto t_end = ::std::min({ t_row.m_End - 1, t_above.m_End, t_below.m_End });
+			
+				if(t_begin > t_end)
+				{
+					t_outline.push_back(t_row);
+					continue;
+				}
+			
+				t_outline.push_back(row_span{ t_row.m_Y, t_row.m_Begin, t_begin - 1 });
+				t_outline.push_back(row_span{ t_row.m_Y, t_end + 1, t_row.m_End });
+			}
+		
+			return t_outline;
+		}
+	
+		// Set of visible cells in a square around the viewer
+		class visibility_map
+		{
+			public:
+				visibility_map(const screen_manager::position_type& p_origin, int p_radius)
+					:	m_Origin{ static_cast<int>(p_origin.x), static_cast<int>(p_origin.y) },
+						m_Radius{p_radius},
+						m_Side{2 * p_radius + 1},
+						m_Cells(static_cast<::std::size_t>(m_Side * m_Side), false)
+				{
+				}
+		
+			public:
+				auto set(int p_dx, int p_dy)
+					-> void
+				{
+					m_Cells[index(p_dx, p_dy)] = true;
+				}
+			
+				auto get(int p_dx, int p_dy) const
+					-> bool
+				{
+					return m_Cells[index(p_dx, p_dy)];
+				}
+			
+				// Merge visible cells of each row into spans
+				auto rows() const
+					-> ::std::vector<row_span>
+				{
+					::std::vector<row_span> t_rows{ };
+				
+					for(int t_dy = -m_Radius; t_dy <= m_Radius; ++t_dy)
+					{
+						for(int t_dx = -m_Radius; t_dx <= m_Radius; ++t_dx)
+						{
+							if(!get(t_dx, t_dy))
+								continue;
+						
+							const auto t_begin = t_dx;
+						
+							while(t_dx < m_Radius && get(t_dx + 1, t_dy))
+								++t_dx;
+						
+							t_rows.push_back(row_span{ m_Origin.y + t_dy, m_Origin.x + t_begin, m_Origin.x + t_dx });
+						}
+					}
+				
+					return t_rows;
+				}
+		
+			private:
+				auto index(int p_dx, int p_dy) const
+					-> ::std::size_t
+				{
+					return static_cast<::std::size_t>((p_dy + m_Radius) * m_Side + (p_dx + m_Radius));
+				}
+		
+			private:
+				glm::ivec2 m_Origin;
+				int m_Radius;
+				int m_Side;
+				::std::vector<bool> m_Cells;
+		};
+	
+		// Recursive shadowcasting, as described by Björn Bergström. Each call scans
+		// one octant, transformed to the first octant by the given multipliers.
+		class shadowcaster
+		{
+			public:
+				shadowcaster(const screen_manager& p_screen, const screen_manager::position_type& p_origin, int p_radius, const cell_predicate& p_opaque)
+					:	m_Screen{p_screen},
+						m_Origin{ static_cast<int>(p_origin.x), static_cast<int>(p_origin.y) },
+						m_Radius{p_radius},
+						m_Opaque{p_opaque},
+						m_Map{p_origin, p_radius}
+				{
+				}
+		
+			public:
+				auto compute()
+					-> visibility_map&
+				{
+					// Octant transformation matrices
+					static constexpr int t_xx[] = { 1,  0,  0, -1, -1,  0,  0,  1 };
+					static constexpr int t_xy[] = { 0,  1, -1,  0,  0, -1,  1,  0 };
+					static constexpr int t_yx[] = { 0,  1,  1,  0,  0, -1, -1,  0 };
+					static constexpr int t_yy[] = { 1,  0,  0,  1, -1,  0,  0, -1 };
+				
+					m_Map.set(0, 0);
+				
+					for(int t_oct = 0; t_oct < 8; ++t_oct)
+						cast_light(1, 1.f, 0.f, t_xx[t_oct], t_xy[t_oct], t_yx[t_oct], t_yy[t_oct]);
+				
+					return m_Map;
+				}
+		
+			private:
+				auto in_bounds(int p_x, int p_y) const
+					-> bool
+				{
+					const auto t_dims = m_Screen.screen_size();
+				
+					return p_x >= 0 && p_y >= 0
+						&& static_cast<unsigned>(p_x) < t_dims.x && static_cast<unsigned>(p_y) < t_dims.y;
+				}
+			
+				// Cells outside of the screen block vision
+				auto is_opaque(int p_x, int p_y) const
+					-> bool
+				{
+					if(!in_bounds(p_x, p_y))
+						return true;
+				
+					return m_Opaque(m_Screen.read_cell({ static_cast<unsigned>(p_x), static_cast<unsigned>(p_y) }));
+				}
+			
+				auto cast_light(int p_row, float p_start, float p_end, int p_xx, int p_xy, int p_yx, int p_yy)
+					-> void
+				{
+					if(p_start < p_end)
+						return;
+				
+					const auto t_radiusSq = m_Radius * m_Radius;
+					float t_newStart{ 0.f };
+				
+					for(int t_j = p_row; t_j <= m_Radius; ++t_j)
+					{
+						const int t_dy = -t_j;
+						bool t_blocked{ false };
+					
+						for(int t_dx = -t_j; t_dx <= 0; ++t_dx)
+						{
+							const auto t_x = m_Origin.x + t_dx * p_xx + t_dy * p_xy;
+							const auto t_y = m_Origin.y + t_dx * p_yx + t_dy * p_yy;
+						
+							// Slopes of the left and right edge of the current cell
+							const auto t_left = (static_cast<float>(t_dx) - 0.5f) / (static_cast<float>(t_dy) + 0.5f);
+							const auto t_right = (static_cast<float>(t_dx) + 0.5f) / (static_cast<float>(t_dy) - 0.5f);
+						
+							if(p_start < t_right)
+								continue;
+							else if(p_end > t_left)
+								break;
+						
+							if(in_bounds(t_x, t_y) && (t_dx * t_dx + t_dy * t_dy) <= t_radiusSq)
+								m_Map.set(t_x - m_Origin.x, t_y - m_Origin.y);
+						
+							const auto t_opaque = is_opaque(t_x, t_y);
+						
+							if(t_blocked)
+							{
+								if(t_opaque)
+								{
+									t_newStart = t_right;
+									continue;
+								}
+							
+								t_blocked = false;
+								p_start = t_newStart;
+							}
+							else if(t_opaque && t_j < m_Radius)
+							{
+								// Scan the part of the next row that is not shadowed by this cell
+								t_blocked = true;
+								cast_light(t_j + 1, p_start, t_left, p_xx, p_xy, p_yx, p_yy);
+								t_newStart = t_right;
+							}
+						}
+					
+						if(t_blocked)
+							break;
+					}
+				}
+		
+			private:
+				const screen_manager& m_Screen;
+				glm::ivec2 m_Origin;
+				int m_Radius;
+				const cell_predicate& m_Opaque;
+				visibility_map m_Map;
+		};
+	}
+}
+
+
+auto filled_circle(const screen_manager::position_type& p_center, unsigned p_radius)
+	-> internal::span_impl
+{
+	return filled_ellipse(p_center, glm::uvec2{ p_radius, p_radius });
+}
+
+auto circle(const screen_manager::position_type& p_center, unsigned p_radius)
+	-> internal::span_impl
+{
+	return ellipse(p_center, glm::uvec2{ p_radius, p_radius });
+}
+
+auto filled_ellipse(const screen_manager::position_type& p_center, const glm::uvec2& p_radii)
+	-> internal::span_impl
+{
+	return internal::span_impl{ internal::to_spans(internal::ellipse_rows(p_center, p_radii)) };
+}
+
+auto ellipse(const screen_manager::position_type& p_center, const glm::uvec2& p_radii)
+	-> internal::span_impl
+{
+	return internal::span_impl{ internal::to_spans(internal::outline_rows(internal::ellipse_rows(p_center, p_radii))) };
+}
+
+auto convex_polygon(const ::std::vector<screen_manager::position_type>& p_vertices)
+	-> internal::span_impl
+{
+	if(p_vertices.empty())
+		throw ::std::runtime_error("convex_polygon: Polygon requires at least one vertex");
+	
+	const auto t_compare = [](const auto& p_a, const auto& p_b) { return p_a.y < p_b.y; };
+	const auto [t_top, t_bottom] = ::std::minmax_element(p_vertices.begin(), p_vertices.end(), t_compare);
+	
+	::std::vector<internal::row_span> t_rows{ };
+	t_rows.reserve(t_bottom->y - t_top->y + 1U);
+	
+	for(auto t_y = static_cast<int>(t_top->y); t_y <= static_cast<int>(t_bottom->y); ++t_y)
+	{
+		float t_min{ ::std::numeric_limits<float>::max() };
+		float t_max{ ::std::numeric_limits<float>::lowest() };
+		
+		// Intersect the row through the cell centers with every edge. Since
+		// the polygon is convex, the interior is the range between the
+		// leftmost and rightmost intersection.
+		for(::std::size_t t_ix = 0; t_ix < p_vertices.size(); ++t_ix)
+		{
+			const glm::vec2 t_a{ p_vertices[t_ix] };
+			const glm::vec2 t_b{ p_vertices[(t_ix + 1U) % p_vertices.size()] };
+			const auto t_row = static_cast<float>(t_y);
+			
+			if(t_row < ::std::min(t_a.y, t_b.y) || t_row > ::std::max(t_a.y, t_b.y))
+				continue;
+			
+			if(t_a.y == t_b.y)
+			{
+				t_min = ::std::min({ t_min, t_a.x, t_b.x });
+				t_max = ::std::max({ t_max, t_a.x, t_b.x });
+				continue;
+			}
+			
+			const auto t_x = t_a.x + (t_row - t_a.y) * (t_b.x - t_a.x) / (t_b.y - t_a.y);
+			
+			t_min = ::std::min(t_min, t_x);
+			t_max = ::std::max(t_max, t_x);
+		}
+		
+		if(t_min > t_max)
+			continue;
+		
+		t_rows.push_back(internal::row_span{ t_y,
+			static_cast<int>(::std::floor(t_min + 0.5f)), static_cast<int>(::std::floor(t_max + 0.5f)) });
+	}
+	
+	return internal::span_impl{ internal::to_spans(t_rows) };
+}
+
+auto flood_fill(const screen_manager& p_screen, const screen_manager::position_type& p_start, const cell_predicate& p_predicate)
+	-> internal::span_impl
+{
+	using position_type = screen_manager::position_type;
+	
+	const auto t_dims = p_screen.screen_size();
+	
+	if(p_start.x >= t_dims.x || p_start.y >= t_dims.y)
+		ut::throwf<::std::runtime_error>("flood_fill: Start position out of bounds: (%u, %u)", p_start.x, p_start.y);
+	
+	::std::vector<bool> t_visited(static_cast<::std::size_t>(t_dims.x) * t_dims.y, false);
+	::std::vector<internal::span> t_spans{ };
+	::std::vector<position_type> t_seeds{ p_start };
+	
+	const auto t_index = [&t_dims](unsigned p_x, unsigned p_y)
+	{
+		return static_cast<::std::size_t>(p_y) * t_dims.x + p_x;
+	};
+	
+	const auto t_matches = [&](unsigned p_x, unsigned p_y)
+	{
+		return !t_visited[t_index(p_x, p_y)] && p_predicate(p_screen.read_cell({ p_x, p_y }));
+	};
+	
+	// Push a seed for every run of matching cells in given range of a row
+	const auto t_scan = [&](unsigned p_begin, unsigned p_end, unsigned p_y)
+	{
+		bool t_inRun{ false };
+		
+		for(auto t_x = p_begin; t_x <= p_end; ++t_x)
+		{
+			const auto t_match = t_matches(t_x, p_y);
+			
+			if(t_match && !t_inRun)
+				t_seeds.emplace_back(t_x, p_y);
+			
+			t_inRun = t_match;
+		}
+	};
+	
+	while(!t_seeds.empty())
+	{
+		const auto t_seed = t_seeds.back();
+		t_seeds.pop_back();
+		
+		if(!t_matches(t_seed.x, t_seed.y))
+			continue;
+		
+		// Extend the seed to the whole span of matching cells
+		auto t_begin = t_seed.x;
+		auto t_end = t_seed.x;
+		
+		while(t_begin > 0 && t_matches(t_begin - 1, t_seed.y))
+			--t_begin;
+		
+		while(t_end + 1 < t_dims.x && t_matches(t_end + 1, t_seed.y))
+			++t_end;
+		
+		::std::fill(t_visited.begin() + t_index(t_begin, t_seed.y), t_visited.begin() + t_index(t_end, t_seed.y) + 1, true);
+		t_spans.push_back(internal::span{ position_type{ t_begin, t_seed.y }, static_cast<::std::size_t>(t_end - t_begin) + 1U });
+		
+		if(t_seed.y > 0)
+			t_scan(t_begin, t_end, t_seed.y - 1);
+		
+		if(t_seed.y + 1 < t_dims.y)
+			t_scan(t_begin, t_end, t_seed.y + 1);
+	}
+	
+	::std::sort(t_spans.begin(), t_spans.end(), [](const auto& p_a, const auto& p_b)
+	{
+		return (p_a.m_Start.y != p_b.m_Start.y) ? (p_a.m_Start.y < p_b.m_Start.y) : (p_a.m_Start.x < p_b.m_Start.x);
+	});
+	
+	return internal::span_impl{ ::std::move(t_spans) };
+}
+
+auto field_of_view(const screen_manager& p_screen, const screen_manager::position_type& p_origin, unsigned p_radius, const cell_predicate& p_opaque)
+	-> internal::span_impl
+{
+	internal::shadowcaster t_caster{ p_screen, p_origin, static_cast<int>(p_radius), p_opaque };
+	
+	return internal::span_impl{ internal::to_spans(t_caster.compute().rows()) };
+}
+
+auto view_cone(const screen_manager& p_screen, const screen_manager::position_type& p_origin, unsigned p_radius,
+	const glm::vec2& p_direction, float p_angle, const cell_predicate& p_opaque)
+	-> internal::span_impl
+{
+	const auto t_length = ::std::sqrt(p_direction.x * p_direction.x + p_direction.y * p_direction.y);
+	
+	if(t_length == 0.f)
+		throw ::std::runtime_error("view_cone: Direction must not be zero");
+	
+	const auto t_radius = static_cast<int>(p_radius);
+	const auto t_cos = ::std::cos(p_angle * 0.5f);
+	
+	internal::shadowcaster t_caster{ p_screen, p_origin, t_radius, p_opaque };
+	auto& t_visible = t_caster.compute();
+	
+	// Restrict visible cells to those whose direction lies within the cone
+	internal::visibility_map t_cone{ p_origin, t_radius };
+	t_cone.set(0, 0);
+	
+	for(int t_dy = -t_radius; t_dy <= t_radius; ++t_dy)
+	{
+		for(int t_dx = -t_radius; t_dx <= t_radius; ++t_dx)
+		{
+			if(!t_visible.get(t_dx, t_dy) || (t_dx == 0 && t_dy == 0))
+				continue;
+			
+			const auto t_x = static_cast<float>(t_dx);
+			const auto t_y = static_cast<float>(t_dy);
+			const auto t_dot = (t_x * p_direction.x + t_y * p_direction.y) / (::std::sqrt(t_x * t_x + t_y * t_y) * t_length);
+			
+			if(t_dot >= t_cos)
+				t_cone.set(t_dx, t_dy);
+		}
+	}
+	
+	return internal::span_impl{ internal::to_spans(t_cone.rows()) };
+}
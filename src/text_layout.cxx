@@ -0,0 +1,466 @@
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <ut/throwf.hxx>
+#include <ut/cast.hxx>
+#include <text_layout.hxx>
+
+namespace internal
+{
+	// Colors used by a sequence of glyphs
+	struct text_style
+	{
+		cell::integral_color_type m_Foreground;
+		cell::integral_color_type m_Background;
+	};
+	
+	struct styled_glyph
+	{
+		cell::glyph_type m_Glyph;
+		::std::uint32_t m_Style;	//< Index into style list
+	};
+	
+	using styled_line = ::std::vector<styled_glyph>;
+	
+	auto parse_hex_digit(char p_char)
+		-> unsigned
+	{
+		if(p_char >= '0' && p_char <= '9')
+			return static_cast<unsigned>(p_char - '0');
+		
+		const auto t_lower = static_cast<char>(::std::tolower(static_cast<unsigned char>(p_char)));
+		
+		if(t_lower >= 'a' && t_lower <= 'f')
+			return static_cast<unsigned>(t_lower - 'a') + 10U;
+		
+		ut::throwf<::std::runtime_error>("text_layout: invalid hex digit '%c'", p_char);
+		return 0U;
+	}
+	
+	// Parses markup and splits text into paragraphs
+	class text_parser
+	{
+		public:
+			text_parser(::std::string_view p_text, const text_layout_params& p_params)
+				:	m_Text{p_text},
+					m_Params{p_params},
+					m_Current{ p_params.m_Foreground, p_params.m_Background }
+			{
+				m_Styles.push_back(m_Current);
+				m_Paragraphs.emplace_back();
+			}
+		
+		public:
+			auto parse()
+				-> void
+			{
+				while(!m_Text.empty())
+				{
+					const auto t_char = next();
+					
+					if(t_char == '\n')
+						m_Paragraphs.emplace_back();
+					else if(t_char == '%' && m_Params.m_Markup)
+						parse_markup();
+					else
+						push(t_char);
+				}
+			}
+			
+			auto paragraphs()
+				-> ::std::vector<styled_line>&
+			{
+				return m_Paragraphs;
+			}
+			
+			auto styles() const
+				-> const ::std::vector<text_style>&
+			{
+				return m_Styles;
+			}
+		
+		private:
+			auto next()
+				-> char
+			{
+				if(m_Text.empty())
+					throw ::std::runtime_error("text_layout: unexpected end of markup");
+				
+				const auto t_char = m_Text.front();
+				m_Text.remove_prefix(1);
+				return t_char;
+			}
+			
+			auto push(char p_char)
+				-> void
+			{
+				// Validation only happens once per layout, not once per frame
+				if(!::std::isprint(static_cast<unsigned char>(p_char)))
+					ut::throwf<::std::runtime_error>("text_layout: encountered non-printable character 0x%02x",
+						static_cast<unsigned>(static_cast<unsigned char>(p_char)));
+				
+				m_Paragraphs.back().push_back({ static_cast<cell::glyph_type>(p_char), static_cast<::std::uint32_t>(m_Styles.size() - 1U) });
+			}
+			
+			auto parse_color()
+				-> cell::integral_color_type
+			{
+				if(next() != '#')
+					throw ::std::runtime_error("text_layout: expected '#' in color markup");
+				
+				cell::integral_color_type t_clr{ };
+				
+				for(int t_ix = 0; t_ix < 3; ++t_ix)
+				{
+					const auto t_high = parse_hex_digit(next());
+					t_clr[t_ix] = (t_high << 4U) | parse_hex_digit(next());
+				}
+				
+				return t_clr;
+			}
+			
+			auto palette_color()
+				-> cell::integral_color_type
+			{
+				if(!m_Params.m_Palette)
+					throw ::std::runtime_error("text_layout: palette color markup requires a palette");
+				
+				return m_Params.m_Palette->lookup(ut::enum_cast<color>(static_cast<::std::uint8_t>(parse_hex_digit(next()))));
+			}
+			
+			auto parse_markup()
+				-> void
+			{
+				const auto t_code = next();
+				
+				switch(t_code)
+				{
+					case '%':
+						push('%');
+						return;
+					case 'f':
+						m_Current.m_Foreground = palette_color();
+						break;
+					case 'b':
+						m_Current.m_Background = palette_color();
+						break;
+					case 'F':
+						m_Current.m_Foreground = parse_color();
+						break;
+					case 'B':
+						m_Current.m_Background = parse_color();
+						break;
+					case 'r':
+						m_Current = text_style{ m_Params.m_Foreground, m_Params.m_Background };
+						break;
+					default:
+						ut::throwf<::std::runtime_error>("text_layout: unknown markup code '%c'", t_code);
+				}
+				
+				m_Styles.push_back(m_Current);
+			}
+		
+		private:
+			::std::string_view m_Text;					//< Remaining text
+			const text_layout_params& m_Params;
+			text_style m_Current;						//< Currently active style
+			::std::vector<text_style> m_Styles;			//< All styles used so far
+			::std::vector<styled_line> m_Paragraphs;	//< Parsed paragraphs
+	};
+	
+	// Splits paragraph into lines fitting given width
+	auto wrap_paragraph(const styled_line& p_para, text_wrap p_wrap, ::std::size_t p_width, ::std::vector<styled_line>& p_lines)
+		-> void
+	{
+		const auto t_begin = p_para.begin();
+		const auto t_end = p_para.end();
+		
+		const auto is_space = [](const styled_glyph& p_glyph) { return p_glyph.m_Glyph == ' '; };
+		
+		if(p_wrap == text_wrap::none || p_para.size() <= p_width)
+		{
+			p_lines.emplace_back(t_begin, t_begin + ::std::min(p_para.size(), p_width));
+			return;
+		}
+		
+		auto t_pos = t_begin;
+		
+		while(t_pos != t_end)
+		{
+			const auto t_remaining = static_cast<::std::size_t>(t_end - t_pos);
+			
+			if(t_remaining <= p_width)
+			{
+				p_lines.emplace_back(t_pos, t_end);
+				break;
+			}
+			
+			auto t_break = t_pos + p_width;
+			
+			if(p_wrap == text_wrap::word)
+			{
+				// Break at the last space that still allows the word before it to fit.
+				// Words longer than a whole line are broken anywhere.
+				const auto t_revEnd = ::std::make_reverse_iterator(t_pos);
+				const auto t_rev = ::std::find_if(::std::make_reverse_iterator(t_break + 1), t_revEnd, is_space);
+				
+				if(t_rev != t_revEnd && t_rev.base() - 1 > t_pos)
+					t_break = t_rev.base() - 1;
+			}
+			
+			// Spaces at the line break are dropped
+			auto t_lineEnd = t_break;
+			
+			while(t_lineEnd != t_pos && is_space(*(t_lineEnd - 1)))
+				--t_lineEnd;
+			
+			p_lines.emplace_back(t_pos, t_lineEnd);
+			
+			t_pos = ::std::find_if_not(t_break, t_end, is_space);
+		}
+	}
+}
+
+text_layout::text_layout(::std::string_view p_text, const text_layout_params& p_params)
+	: m_GlyphSet{p_params.m_GlyphSet}
+{
+	if(p_params.m_Box.x == 0U || p_params.m_Box.y == 0U)
+		return;
+	
+	internal::text_parser t_parser{ p_text, p_params };
+	t_parser.parse();
+	
+	const auto& t_styles = t_parser.styles();
+	const auto t_width = static_cast<size_type>(p_params.m_Box.x);
+	const auto t_height = static_cast<size_type>(p_params.m_Box.y);
+	
+	::std::vector<internal::styled_line> t_lines{ };
+	
+	for(const auto& t_para: t_parser.paragraphs())
+	{
+		if(t_lines.size() >= t_height)
+			break;
+		
+		internal::wrap_paragraph(t_para, p_params.m_Wrap, t_width, t_lines);
+	}
+	
+	if(t_lines.size() > t_height)
+		t_lines.resize(t_height);
+	
+	// Unbounded boxes are aligned to the longest line
+	size_type t_alignWidth = t_width;
+	
+	if(p_params.m_Box.x == ::std::numeric_limits<unsigned>::max())
+	{
+		t_alignWidth = 0U;
+		
+		for(const auto& t_line: t_lines)
+			t_alignWidth = ::std::max(t_alignWidth, t_line.size());
+	}
+	
+	for(size_type t_y = 0; t_y < t_lines.size(); ++t_y)
+	{
+		const auto& t_line = t_lines[t_y];
+		
+		size_type t_x{ 0U };
+		
+		if(p_params.m_Align == text_align::center)
+			t_x = (t_alignWidth - t_line.size()) / 2U;
+		else if(p_params.m_Align == text_align::right)
+			t_x = t_alignWidth - t_line.size();
+		
+		m_Extent.x = ::std::max<unsigned>(m_Extent.x, static_cast<unsigned>(t_x + t_line.size()));
+		
+		// Merge consecutive glyphs with the same style into one run
+		for(size_type t_ix = 0; t_ix < t_line.size(); )
+		{
+			const auto t_style = t_line[t_ix].m_Style;
+			
+			glyph_run t_run{ };
+			t_run.m_Position = glm::uvec2{ t_x + t_ix, t_y };
+			t_run.m_First = static_cast<::std::uint32_t>(m_Glyphs.size());
+			t_run.m_Foreground = t_styles[t_style].m_Foreground;
+			t_run.m_Background = t_styles[t_style].m_Background;
+			
+			for(; t_ix < t_line.size() && t_line[t_ix].m_Style == t_style; ++t_ix)
+				m_Glyphs.push_back(t_line[t_ix].m_Glyph);
+			
+			t_run.m_Length = static_cast<::std::uint32_t>(m_Glyphs.size()) - t_run.m_First;
+			m_Runs.push_back(t_run);
+		}
+	}
+	
+	m_Extent.y = static_cast<unsigned>(t_lines.size());
+}
+
+auto text_layout::blit(screen_manager& p_screen, const position_type& p_pos) const
+	-> void
+{
+	const auto t_screen = p_screen.screen_size();
+	const auto t_set = ut::enum_cast(m_GlyphSet) << internal::glyph_set_shift;
+	
+	for(const auto& t_run: m_Runs)
+	{
+		const auto t_x = p_pos.x + t_run.m_Position.x;
+		const auto t_y = p_pos.y + t_run.m_Position.y;
+		
+		if(t_x >= t_screen.x || t_y >= t_screen.y)
+			continue;
+		
+		const auto t_count = ::std::min<size_type>(t_run.m_Length, t_screen.x - t_x);
+		auto* t_cells = p_screen.modify_span({ t_x, t_y }, t_count);
+		const auto* t_glyphs = &m_Glyphs[t_run.m_First];
+		
+		for(size_type t_ix = 0; t_ix < t_count; ++t_ix)
+		{
+			auto& t_cell = t_cells[t_ix];
+			
+			t_cell.m_Front = t_run.m_Foreground;
+			t_cell.m_Back = t_run.m_Background;
+			t_cell.m_GlyphData = (t_cell.m_GlyphData & ~(internal::glyph_mask | internal::glyph_set_mask))
+				| t_glyphs[t_ix] | t_set;
+		}
+	}
+}
+
+auto text_layout::runs() const
+	-> const ::std::vector<glyph_run>&
+{
+	return m_Runs;
+}
+
+auto text_layout::glyphs() const
+	-> const ::std::vector<cell::glyph_type>&
+{
+	return m_Glyphs;
+}
+
+auto text_layout::extent() const
+	-> const dimension_type&
+{
+	return m_Extent;
+}
+
+auto text_layout::line_count() const
+	-> size_type
+{
+	return m_Extent.y;
+}
+
+auto text_layout::memory_usage() const
+	-> size_type
+{
+	return sizeof(text_layout) + (m_Runs.capacity() * sizeof(glyph_run)) + m_Glyphs.capacity();
+}
+
+
+text_layout_cache::text_layout_cache(size_type p_capacity)
+	: m_Capacity{ ::std::max<size_type>(p_capacity, 1U) }
+{
+}
+
+auto text_layout_cache::make_key(::std::string_view p_text, const text_layout_params& p_params)
+	-> ::std::string
+{
+	// All parameters are plain values, their bytes are used as key prefix.
+	// Members are copied individually to avoid including padding.
+	::std::string t_key{ };
+	
+	const auto append = [&t_key](const auto& p_value)
+	{
+		t_key.append(reinterpret_cast<const char*>(&p_value), sizeof(p_value));
+	};
+	
+	append(p_params.m_Box);
+	append(p_params.m_Align);
+	append(p_params.m_Wrap);
+	append(p_params.m_Foreground);
+	append(p_params.m_Background);
+	append(p_params.m_GlyphSet);
+	append(p_params.m_Markup);
+	
+	// Palettes are keyed by their contents, not their address, since a
+	// different palette might later occupy the same memory
+	append(p_params.m_Palette != nullptr);
+	
+	if(p_params.m_Palette)
+	{
+		for(::std::size_t t_ix = 0; t_ix < palette::num_colors; ++t_ix)
+			append(p_params.m_Palette->lookup(ut::enum_cast<color>(static_cast<::std::uint8_t>(t_ix))));
+	}
+	
+	t_key.append(p_text.data(), p_text.size());
+	
+	return t_key;
+}
+
+auto text_layout_cache::shared()
+	-> text_layout_cache&
+{
+	static text_layout_cache t_cache{ };
+	return t_cache;
+}
+
+auto text_layout_cache::get(::std::string_view p_text, const text_layout_params& p_params)
+	-> layout_ptr
+{
+	auto t_key = make_key(p_text, p_params);
+	
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	if(const auto t_it = m_Index.find(t_key); t_it != m_Index.end())
+	{
+		// Mark as most recently used
+		m_Entries.splice(m_Entries.begin(), m_Entries, t_it->second);
+		++m_Hits;
+		return t_it->second->second;
+	}
+	
+	++m_Misses;
+	
+	// Layouts are created while locked, so concurrent requests for the same
+	// string do not create it twice
+	auto t_layout = ::std::make_shared<const text_layout>(p_text, p_params);
+	
+	m_Entries.emplace_front(::std::move(t_key), t_layout);
+	m_Index.emplace(m_Entries.front().first, m_Entries.begin());
+	
+	while(m_Entries.size() > m_Capacity)
+	{
+		m_Index.erase(m_Entries.back().first);
+		m_Entries.pop_back();
+	}
+	
+	return t_layout;
+}
+
+auto text_layout_cache::clear()
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	m_Index.clear();
+	m_Entries.clear();
+}
+
+auto text_layout_cache::size() const
+	-> size_type
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	return m_Entries.size();
+}
+
+auto text_layout_cache::hits() const
+	-> size_type
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	return m_Hits;
+}
+
+auto text_layout_cache::misses() const
+	-> size_type
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	return m_Misses;
+}
@@ -1,11 +1,19 @@
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <boost/filesystem.hpp>
 
 #include <log.hxx>
+#include <gpu_stats.hxx>
 #include <GLXW/glxw.h>
 #include <SDL2/SDL.h>
 #include <ut/format.hxx>
 #include <SDL2/SDL_image.h>
 #include <texture_set.hxx>
+#include <glyph_cache.hxx>
+#include <global_state.hxx>
 
 
 // TODO SDL error handling from sdl_cpu
@@ -58,97 +66,284 @@ SDL_Surface* load_texture(const ::std::string& p_path)
 	return tex;
 }
 
-GLuint make_gl_texture(const ::std::string& p_path)
+void texture_image::surface_deleter::operator()(SDL_Surface* p_srfc) const
 {
-	GLuint TextureID = 0;
-	glGenTextures(1, &TextureID);
-	glBindTexture(GL_TEXTURE_2D, TextureID);
-	
-	auto* t_srfc = load_texture(p_path);
+	SDL_FreeSurface(p_srfc);
+}
+
+texture_image::texture_image(const ::std::string& p_path)
+{
+	const glyph_cache t_cache{ global_state<path_manager>().glyph_cache_path() };
+	const file_stamp t_stamp{ p_path };
 	
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, t_srfc->w, t_srfc->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, t_srfc->pixels);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// A broken cache is never fatal, the image is simply decoded again
+	try
+	{
+		m_Cached = t_cache.load(p_path, t_stamp);
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		LOG_W_TAG("texture_set") << "ignoring glyph cache entry for \"" << p_path << "\": " << p_ex.what();
+	}
 	
-	SDL_FreeSurface(t_srfc);
+	if(m_Cached)
+		return;
+
+	m_Surface.reset(load_texture(p_path));
 	
-	return TextureID;
+	if(!m_Surface)
+		ut::throwf<::std::runtime_error>("texture_image: failed to convert texture with path \"%s\"", p_path);
+		
+	try
+	{
+		t_cache.store(p_path, t_stamp, m_Surface->w, m_Surface->h, m_Surface->pitch, m_Surface->pixels);
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		LOG_W_TAG("texture_set") << "could not cache glyph sheet \"" << p_path << "\": " << p_ex.what();
+	}
 }
 
-texture_set::texture_set(texture_set&& p_set)
+texture_image::~texture_image() = default;
+texture_image::texture_image(texture_image&&) = default;
+texture_image& texture_image::operator=(texture_image&&) = default;
+
+auto texture_image::width() const
+	-> int
 {
-	::std::swap(m_TextTex, p_set.m_TextTex);
-	::std::swap(m_GfxTex, p_set.m_GfxTex);
-	::std::swap(m_ShadowTex, p_set.m_ShadowTex);
-	::std::swap(m_GlyphDim, p_set.m_GlyphDim);
+	return m_Cached ? m_Cached->width() : m_Surface->w;
 }
 
-texture_set& texture_set::operator=(texture_set&& p_set)
+auto texture_image::height() const
+	-> int
 {
-	::std::swap(m_TextTex, p_set.m_TextTex);
-	::std::swap(m_GfxTex, p_set.m_GfxTex);
-	::std::swap(m_ShadowTex, p_set.m_ShadowTex);
-	::std::swap(m_GlyphDim, p_set.m_GlyphDim);
+	return m_Cached ? m_Cached->height() : m_Surface->h;
+}
+
+auto texture_image::pixels() const
+	-> const void*
+{
+	return m_Cached ? m_Cached->pixels() : m_Surface->pixels;
+}
+
+// Helpers only used in this file
+namespace
+{
+	auto image_memory_usage(const texture_image& p_image)
+		-> ::std::size_t
+	{
+		return static_cast<::std::size_t>(p_image.width()) * p_image.height() * 4U;
+	}
+
+	// Upload RGBA8 pixel data to given layer of the currently bound array texture
+	void upload_layer(const void* p_pixels, int p_width, int p_height, GLint p_layer)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, p_layer, p_width, p_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, p_pixels);
+		gpu_stats::record_upload(static_cast<::std::size_t>(p_width) * p_height * 4U);
+	}
+
+	void upload_layer(const texture_image& p_image, GLint p_layer)
+	{
+		upload_layer(p_image.pixels(), p_image.width(), p_image.height(), p_layer);
+	}
+
+	// Pre-composite all 256 possible drop shadow combinations into a layer-sized
+	// RGBA8 image. The combination with shadow mask m is stored at glyph position
+	// (m % 16, m / 16), which allows the fragment shader to apply any number of
+	// drop shadows with a single texture fetch.
+	//
+	// The shadow sheet contains eight glyph-sized shadows in a row. Shadows are
+	// blended in the same order the shader used to apply them one by one, and the
+	// result is stored so that mix(pixel, color, alpha) reproduces that blend.
+	auto composite_shadows(const texture_image& p_shadow, const glm::ivec2& p_glyphDim)
+		-> ::std::vector<::std::uint8_t>
+	{
+		// Shadow mask bit represented by each tile of the shadow sheet
+		constexpr ::std::uint32_t t_tileBits[] = { 1U, 2U, 0U, 3U, 7U, 6U, 4U, 5U };
+		constexpr int t_tileCount = 8;
 	
-	return *this;
+		const int t_sheetWidth = p_glyphDim.x * static_cast<int>(texture_set::sheet_width);
+		const int t_tileWidth = p_shadow.width() / t_tileCount;
+		const int t_tileHeight = p_shadow.height();
+		const auto* t_src = static_cast<const ::std::uint8_t*>(p_shadow.pixels());
+	
+		::std::vector<::std::uint8_t> t_out(
+			static_cast<::std::size_t>(t_sheetWidth) * p_glyphDim.y * texture_set::sheet_height * 4U, 0U);
+	
+		for(::std::uint32_t t_mask = 1U; t_mask < 256U; ++t_mask)
+		{
+			const int t_ox = static_cast<int>(t_mask % texture_set::sheet_width) * p_glyphDim.x;
+			const int t_oy = static_cast<int>(t_mask / texture_set::sheet_width) * p_glyphDim.y;
+	
+			for(int t_y = 0; t_y < p_glyphDim.y; ++t_y)
+			{
+				// Nearest neighbour resampling, the shadow tiles do not have to
+				// match the glyph size
+				const int t_sy = (t_y * t_tileHeight) / p_glyphDim.y;
+			
+				for(int t_x = 0; t_x < p_glyphDim.x; ++t_x)
+				{
+					const int t_sx = (t_x * t_tileWidth) / p_glyphDim.x;
+				
+					float t_color[3]{ };		// Sum of all shadow colors, weighted by alpha
+					float t_transmit{ 1.f };	// Fraction of the cell still visible
+				
+					for(int t_tile = 0; t_tile < t_tileCount; ++t_tile)
+					{
+						if(!(t_mask & (1U << t_tileBits[t_tile])))
+							continue;
+						
+						const auto* t_px = t_src + (static_cast<::std::size_t>(t_sy) * p_shadow.width()
+							+ t_tile * t_tileWidth + t_sx) * 4U;
+						
+						const float t_alpha = t_px[3] / 255.f;
+					
+						for(int t_c = 0; t_c < 3; ++t_c)
+							t_color[t_c] = t_color[t_c] * (1.f - t_alpha) + (t_px[t_c] / 255.f) * t_alpha;
+						
+						t_transmit *= 1.f - t_alpha;
+					}
+				
+					const float t_alpha = 1.f - t_transmit;
+				
+					if(t_alpha <= 0.f)
+						continue;
+						
+					auto* t_dst = t_out.data() + (static_cast<::std::size_t>(t_oy + t_y) * t_sheetWidth + t_ox + t_x) * 4U;
+					
+					for(int t_c = 0; t_c < 3; ++t_c)
+						t_dst[t_c] = static_cast<::std::uint8_t>(::std::lround(::std::min(t_color[t_c] / t_alpha, 1.f) * 255.f));
+						
+					t_dst[3] = static_cast<::std::uint8_t>(::std::lround(t_alpha * 255.f));
+				}
+			}
+		}
+	
+		return t_out;
+	}
 }
 
-texture_set::~texture_set()
+void internal::texture_set_data::dispatch(const internal::shadow_texture_t& p_tag)
+{
+	m_Shadow.emplace(p_tag.m_Path);
+}
+
+void internal::texture_set_data::dispatch(const internal::text_texture_t& p_tag)
+{
+	dispatch(glyph_sheet(0U, p_tag.m_Path));
+}
+
+void internal::texture_set_data::dispatch(const internal::graphics_texture_t& p_tag)
+{
+	dispatch(glyph_sheet(1U, p_tag.m_Path));
+}
+
+void internal::texture_set_data::dispatch(const internal::glyph_sheet_t& p_tag)
 {
-	if(m_TextTex)
-		glDeleteTextures(1, &m_TextTex);
+	if(p_tag.m_GlyphSet >= texture_set::max_glyph_sets)
+		ut::throwf<::std::runtime_error>("texture_set: glyph set index %u out of range", p_tag.m_GlyphSet);
 		
-	if(m_ShadowTex)
-		glDeleteTextures(1, &m_ShadowTex);
-	
-	if(m_GfxTex)
-		glDeleteTextures(1, &m_GfxTex);
+	if(m_Sheets.size() <= p_tag.m_GlyphSet)
+		m_Sheets.resize(p_tag.m_GlyphSet + 1U);
+		
+	if(m_Sheets[p_tag.m_GlyphSet])
+		ut::throwf<::std::runtime_error>("texture_set: glyph set %u supplied more than once", p_tag.m_GlyphSet);
+		
+	m_Sheets[p_tag.m_GlyphSet].emplace(p_tag.m_Path);
 }
 
-void texture_set::dispatch(const internal::shadow_texture_t& p_tag)
+texture_set::texture_set(internal::texture_set_data&& p_data)
 {
-	m_ShadowTex = make_gl_texture(p_tag.m_Path);
-	// TODO: size check
+	upload(::std::move(p_data));
 }
 
-void texture_set::dispatch(const internal::text_texture_t& p_tag)
+texture_set::texture_set(texture_set&& p_set)
 {
-	m_TextTex = make_gl_texture(p_tag.m_Path);
-	
-	update_dims(recv_dims(m_TextTex));
+	::std::swap(m_Atlas, p_set.m_Atlas);
+	::std::swap(m_GlyphSets, p_set.m_GlyphSets);
+	::std::swap(m_GlyphDim, p_set.m_GlyphDim);
+	::std::swap(m_MemoryUsage, p_set.m_MemoryUsage);
 }
 
-void texture_set::dispatch(const internal::graphics_texture_t& p_tag)
+texture_set& texture_set::operator=(texture_set&& p_set)
 {
-	m_GfxTex = make_gl_texture(p_tag.m_Path);
+	::std::swap(m_Atlas, p_set.m_Atlas);
+	::std::swap(m_GlyphSets, p_set.m_GlyphSets);
+	::std::swap(m_GlyphDim, p_set.m_GlyphDim);
+	::std::swap(m_MemoryUsage, p_set.m_MemoryUsage);
 	
-	update_dims(recv_dims(m_GfxTex));
+	return *this;
+}
+
+texture_set::~texture_set()
+{
+	if(m_Atlas)
+		glDeleteTextures(1, &m_Atlas);
 }
 
-void texture_set::update_dims(const dimension_type& p_dims)
+auto texture_set::upload(internal::texture_set_data&& p_data)
+	-> void
 {
-	if(m_GlyphDim != dimension_type{})
+	if(p_data.m_Sheets.empty() || !p_data.m_Sheets[0] || !p_data.m_Shadow)
+		throw ::std::runtime_error("texture_set: text and shadow textures are required");
+		
+	// All glyph sheets share the dimensions of the text sheet
+	const auto& t_text = *p_data.m_Sheets[0];
+	const dimension_type t_sheetDims{ t_text.width(), t_text.height() };
+	
+	for(const auto& t_sheet: p_data.m_Sheets)
 	{
-		if(m_GlyphDim != p_dims)
+		if(t_sheet && dimension_type{ t_sheet->width(), t_sheet->height() } != t_sheetDims)
 		{
-			ut::throwf<::std::runtime_error>("Glyph sheet tile size mismatch: %ux%u != %ux%u",
-				p_dims.x, p_dims.y, m_GlyphDim.x, m_GlyphDim.y);
+			ut::throwf<::std::runtime_error>("Glyph sheet size mismatch: %ux%u != %ux%u",
+				t_sheet->width(), t_sheet->height(), t_sheetDims.x, t_sheetDims.y);
 		}
 	}
-	else m_GlyphDim = p_dims;
+	
+	const auto& t_shadow = *p_data.m_Shadow;
+	
+	if(t_shadow.width() < 8 || t_shadow.width() % 8 != 0)
+		ut::throwf<::std::runtime_error>("texture_set: shadow sheet width %d is not a multiple of 8", t_shadow.width());
+	
+	m_GlyphDim = t_sheetDims / dimension_type{ sheet_width, sheet_height };
+	m_GlyphSets = p_data.m_Sheets.size();
+	
+	const auto t_layers = static_cast<GLsizei>(m_GlyphSets + 1U);
+	
+	glGenTextures(1, &m_Atlas);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_Atlas);
+	
+	// Mipmaps stop once a glyph is a single texel, beyond that neighbouring
+	// glyphs would bleed into each other
+	const auto t_levels = mip_levels();
+	
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, t_levels, GL_RGBA8, t_sheetDims.x, t_sheetDims.y, t_layers);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, t_levels - 1);
+	
+	for(size_type t_ix = 0; t_ix < m_GlyphSets; ++t_ix)
+	{
+		// Missing glyph sets fall back to the text sheet
+		const auto& t_sheet = p_data.m_Sheets[t_ix] ? *p_data.m_Sheets[t_ix] : t_text;
+		upload_layer(t_sheet, static_cast<GLint>(t_ix));
+	}
+	
+	const auto t_shadows = composite_shadows(t_shadow, m_GlyphDim);
+	upload_layer(t_shadows.data(), t_sheetDims.x, t_sheetDims.y, static_cast<GLint>(shadow_layer()));
+	
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	
+	// The mipmap chain adds roughly one third to the base level
+	m_MemoryUsage = (image_memory_usage(t_text) * t_layers * 4U) / 3U;
+	
+	use();
 }
 
-
 void texture_set::use() const
 {
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_TextTex);
-	
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, (m_GfxTex != 0 ? m_GfxTex : m_TextTex));
-	
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, m_ShadowTex);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_Atlas);
 }
 
 auto texture_set::glyph_size() const
@@ -157,15 +352,33 @@ auto texture_set::glyph_size() const
 	return m_GlyphDim;
 }
 
-auto texture_set::recv_dims(GLuint p_tex)
-	-> dimension_type
+auto texture_set::mip_levels() const
+	-> GLsizei
 {
-	dimension_type t_dims{};
-
-	glGetTextureLevelParameteriv(p_tex, 0, GL_TEXTURE_WIDTH, &t_dims.x);
-	glGetTextureLevelParameteriv(p_tex, 0, GL_TEXTURE_HEIGHT, &t_dims.y);	
+	GLsizei t_levels{ 1 };
 	
-	return t_dims / dimension_type{ texture_set::sheet_width, texture_set::sheet_height };
+	for(auto t_dim = ::std::min(m_GlyphDim.x, m_GlyphDim.y); t_dim > 1; t_dim /= 2)
+		++t_levels;
+		
+	return t_levels;
+}
+
+auto texture_set::glyph_set_count() const
+	-> size_type
+{
+	return m_GlyphSets;
+}
+
+auto texture_set::shadow_layer() const
+	-> size_type
+{
+	return m_GlyphSets;
+}
+
+auto texture_set::memory_usage() const
+	-> size_type
+{
+	return m_MemoryUsage;
 }
 
 internal::shadow_texture_t shadow_texture(const ::std::string& p_path)
@@ -183,3 +396,54 @@ internal::graphics_texture_t graphics_texture(const ::std::string& p_path)
 	return { p_path };
 }
 
+internal::glyph_sheet_t glyph_sheet(::std::size_t p_glyphSet, const ::std::string& p_path)
+{
+	return { p_glyphSet, p_path };
+}
+
+
+
+auto asset_loader<texture_set>::decode(const ::std::string& p_name) const
+	-> internal::texture_set_data
+{
+	const auto t_basePath = global_state<path_manager>().data_path() / "textures" / p_name;
+	
+	internal::texture_set_data t_data{
+		shadow_texture((t_basePath / "shadows.png").string()),
+		text_texture((t_basePath / "text.png").string())
+	};
+	
+	// All other glyph sheets are optional, the text sheet is used in their place
+	const auto t_gfxPath = t_basePath / "graphics.png";
+	
+	if(boost::filesystem::exists(t_gfxPath))
+		t_data.dispatch(graphics_texture(t_gfxPath.string()));
+		
+	for(::std::size_t t_ix = 2; t_ix < texture_set::max_glyph_sets; ++t_ix)
+	{
+		const auto t_path = t_basePath / ("set" + ::std::to_string(t_ix) + ".png");
+		
+		if(boost::filesystem::exists(t_path))
+			t_data.dispatch(glyph_sheet(t_ix, t_path.string()));
+	}
+		
+	return t_data;
+}
+
+auto asset_loader<texture_set>::upload(internal::texture_set_data&& p_data) const
+	-> texture_set
+{
+	return texture_set{ ::std::move(p_data) };
+}
+
+auto asset_loader<texture_set>::memory_usage(const texture_set& p_set)
+	-> ::std::size_t
+{
+	return p_set.memory_usage();
+}
+
+auto asset_loader<texture_set>::load_asset(const ::std::string& p_name) const
+	-> texture_set
+{
+	return upload(decode(p_name));
+}
@@ -0,0 +1,268 @@
+#include <chrono>
+#include <limits>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <ut/throwf.hxx>
+#include <trace_log.hxx>
+
+namespace bip = boost::interprocess;
+
+namespace internal
+{
+	::std::atomic<trace_log*> g_ActiveTrace{nullptr};
+	::std::atomic<::std::uint32_t> g_TraceGeneration{0U};	//< Generation of the last created trace log
+	
+	auto trace_level(lg::severity_level p_level)
+		-> trace_format::level
+	{
+		switch(p_level)
+		{
+			case lg::severity_level::fatal:
+				return trace_format::level::fatal;
+			case lg::severity_level::error:
+				return trace_format::level::error;
+			case lg::severity_level::warning:
+				return trace_format::level::warning;
+			case lg::severity_level::info:
+				return trace_format::level::info;
+			default:
+				return trace_format::level::debug;
+		}
+	}
+	
+	auto trace_timestamp()
+		-> ::std::uint64_t
+	{
+		const auto t_now = ::std::chrono::steady_clock::now().time_since_epoch();
+		return static_cast<::std::uint64_t>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(t_now).count());
+	}
+}
+
+trace_log::trace_log(const path_type& p_path, size_type p_fileSize, size_type p_fileCount)
+	:	m_Generation{ internal::g_TraceGeneration.fetch_add(1U) + 1U },
+		m_Path{p_path},
+		m_FileSize{ ::std::max(p_fileSize, min_file_size) },
+		m_FileCount{ ::std::max<size_type>(p_fileCount, 1U) }
+{
+	const auto t_dir = p_path.parent_path();
+	
+	if(!t_dir.empty() && !boost::filesystem::exists(t_dir))
+		boost::filesystem::create_directories(t_dir);
+	
+	open_file();
+}
+
+trace_log::~trace_log()
+{
+	if(active() == this)
+		set_active(nullptr);
+	
+	close_file();
+}
+
+auto trace_log::active()
+	-> trace_log*
+{
+	return internal::g_ActiveTrace.load(::std::memory_order_acquire);
+}
+
+auto trace_log::set_active(trace_log* p_log)
+	-> void
+{
+	internal::g_ActiveTrace.store(p_log, ::std::memory_order_release);
+}
+
+auto trace_log::generation() const
+	-> ::std::uint32_t
+{
+	return m_Generation;
+}
+
+auto trace_log::file_path(size_type p_index) const
+	-> path_type
+{
+	if(p_index == 0U)
+		return m_Path;
+	
+	// "trace.bin" becomes "trace.1.bin"
+	auto t_path = m_Path;
+	t_path.replace_extension(::std::to_string(p_index) + m_Path.extension().string());
+	return t_path;
+}
+
+auto trace_log::open_file()
+	-> void
+{
+	const auto t_path = file_path(0U);
+	
+	// Preallocate the whole file. The unused part reads as zero, which marks
+	// the end of the records.
+	::std::ofstream{ t_path.string(), ::std::ios::binary | ::std::ios::trunc };
+	boost::filesystem::resize_file(t_path, m_FileSize);
+	
+	m_File = ::std::make_unique<bip::file_mapping>(t_path.string().c_str(), bip::read_write);
+	m_Region = ::std::make_unique<bip::mapped_region>(*m_File, bip::read_write, 0, m_FileSize);
+	m_Data = static_cast<::std::uint8_t*>(m_Region->get_address());
+	
+	trace_format::file_header t_header{ };
+	t_header.m_Magic = trace_format::magic;
+	t_header.m_Version = trace_format::version;
+	t_header.m_Sequence = m_Sequence++;
+	t_header.m_StartTime = ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+		::std::chrono::system_clock::now().time_since_epoch()).count();
+	t_header.m_StartTicks = internal::trace_timestamp();
+	
+	::std::memcpy(m_Data, &t_header, sizeof(t_header));
+	m_Offset = sizeof(t_header);
+	
+	// Every file carries all definitions, so it can be decoded on its own
+	for(size_type t_ix = 0; t_ix < m_Tags.size(); ++t_ix)
+	{
+		trace_format::record_header t_def{ trace_format::record_type::tag_definition };
+		t_def.m_Tag = static_cast<id_type>(t_ix);
+		t_def.m_Size = static_cast<::std::uint16_t>(m_Tags[t_ix].size());
+		put(t_def, m_Tags[t_ix].data(), m_Tags[t_ix].size());
+	}
+	
+	for(size_type t_ix = 0; t_ix < m_Formats.size(); ++t_ix)
+	{
+		trace_format::record_header t_def{ trace_format::record_type::format_definition };
+		t_def.m_Format = static_cast<id_type>(t_ix);
+		t_def.m_Size = static_cast<::std::uint16_t>(m_Formats[t_ix].size());
+		put(t_def, m_Formats[t_ix].data(), m_Formats[t_ix].size());
+	}
+}
+
+auto trace_log::close_file()
+	-> void
+{
+	if(m_Region)
+		m_Region->flush();
+	
+	m_Region.reset();
+	m_File.reset();
+	m_Data = nullptr;
+}
+
+auto trace_log::rotate()
+	-> void
+{
+	close_file();
+	
+	// Shift old files, dropping the oldest one
+	boost::filesystem::remove(file_path(m_FileCount - 1U));
+	
+	for(auto t_ix = m_FileCount - 1U; t_ix > 0U; --t_ix)
+	{
+		if(boost::filesystem::exists(file_path(t_ix - 1U)))
+			boost::filesystem::rename(file_path(t_ix - 1U), file_path(t_ix));
+	}
+	
+	open_file();
+}
+
+auto trace_log::put(const trace_format::record_header& p_header, const void* p_data, size_type p_size)
+	-> bool
+{
+	const auto t_size = trace_format::record_size(p_size);
+	
+	// A record of type end is implied by the zeroed remainder of the file,
+	// but there needs to be room for its type byte
+	if(m_Offset + t_size >= m_FileSize)
+		return false;
+	
+	// The padding is already zero, since the file is preallocated
+	::std::memcpy(m_Data + m_Offset, &p_header, sizeof(p_header));
+	::std::memcpy(m_Data + m_Offset + sizeof(p_header), p_data, p_size);
+	m_Offset += t_size;
+	
+	return true;
+}
+
+auto trace_log::append(const trace_format::record_header& p_header, const void* p_data, size_type p_size)
+	-> bool
+{
+	if(put(p_header, p_data, p_size))
+		return true;
+	
+	rotate();
+	
+	return put(p_header, p_data, p_size);
+}
+
+auto trace_log::intern_string(::std::unordered_map<::std::string, id_type>& p_map, ::std::vector<::std::string>& p_list,
+	trace_format::record_type p_type, ::std::string_view p_str)
+	-> id_type
+{
+	const ::std::string t_str{ p_str.substr(0, ::std::numeric_limits<::std::uint16_t>::max()) };
+	
+	if(const auto t_it = p_map.find(t_str); t_it != p_map.end())
+		return t_it->second;
+	
+	if(p_list.size() > ::std::numeric_limits<id_type>::max())
+		throw ::std::runtime_error("trace_log: too many interned strings");
+	
+	const auto t_id = static_cast<id_type>(p_list.size());
+	p_list.push_back(t_str);
+	p_map.emplace(t_str, t_id);
+	
+	trace_format::record_header t_def{ p_type };
+	t_def.m_Size = static_cast<::std::uint16_t>(t_str.size());
+	
+	if(p_type == trace_format::record_type::tag_definition)
+		t_def.m_Tag = t_id;
+	else
+		t_def.m_Format = t_id;
+	
+	// If the file is full, the definition is written as part of the new file
+	if(!put(t_def, t_str.data(), t_str.size()))
+		rotate();
+	
+	return t_id;
+}
+
+auto trace_log::intern(::std::string_view p_tag, ::std::string_view p_format)
+	-> event_id
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	const auto t_tag = intern_string(m_TagIds, m_Tags, trace_format::record_type::tag_definition, p_tag);
+	const auto t_format = intern_string(m_FormatIds, m_Formats, trace_format::record_type::format_definition, p_format);
+	
+	return event_id{ t_tag, t_format };
+}
+
+auto trace_log::write_event(lg::severity_level p_level, event_id p_id, const void* p_data, size_type p_size)
+	-> void
+{
+	trace_format::record_header t_header{ trace_format::record_type::event };
+	t_header.m_Level = internal::trace_level(p_level);
+	t_header.m_Size = static_cast<::std::uint16_t>(p_size);
+	t_header.m_Tag = p_id.m_Tag;
+	t_header.m_Format = p_id.m_Format;
+	t_header.m_Timestamp = internal::trace_timestamp();
+	
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	if(!append(t_header, p_data, p_size))
+		m_Dropped.fetch_add(1U, ::std::memory_order_relaxed);
+}
+
+auto trace_log::flush()
+	-> void
+{
+	::std::lock_guard<::std::mutex> t_lock{ m_Mutex };
+	
+	// Asynchronous, only makes sure the data reaches the disk eventually
+	if(m_Region)
+		m_Region->flush(0, m_Offset, true);
+}
+
+auto trace_log::dropped() const
+	-> ::std::uint64_t
+{
+	return m_Dropped.load(::std::memory_order_relaxed);
+}
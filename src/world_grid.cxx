@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <boost/interprocess/mapped_region.hpp>
+#include <log.hxx>
+#include <world.hxx>
+#include <world_store.hxx>
+
+
+world_chunk::world_chunk()
+	:	m_Owned{ ::std::make_unique<container_type>() },
+		m_Cells{ m_Owned.get() }
+{
+}
+
+world_chunk::world_chunk(::std::unique_ptr<region_type> p_region)
+	:	m_Region{ ::std::move(p_region) },
+		m_Cells{ static_cast<container_type*>(m_Region->get_address()) }
+{
+}
+
+world_chunk::~world_chunk()
+{
+	// Start writing back modified pages, instead of waiting for the system
+	if(m_Region)
+		m_Region->flush(0, 0, true);
+}
+
+auto world_chunk::cells()
+	-> container_type&
+{
+	return *m_Cells;
+}
+
+auto world_chunk::cells() const
+	-> const container_type&
+{
+	return *m_Cells;
+}
+
+
+world_grid::world_grid() = default;
+
+world_grid::world_grid(::std::unique_ptr<world_store> p_store, size_type p_residentLimit)
+	:	m_Store{ ::std::move(p_store) },
+		m_ResidentLimit{ ::std::max<size_type>(p_residentLimit, 1U) }
+{
+	const auto& t_chunks = m_Store->chunks();
+	
+	// Stored chunks are only paged in once they are accessed
+	for(size_type t_ix = 0; t_ix < t_chunks.size(); ++t_ix)
+	{
+		auto& t_entry = m_Chunks[t_chunks[t_ix]];
+		t_entry.m_Record = t_ix;
+		t_entry.m_Revision = ++m_Revision;
+	}
+}
+
+world_grid::~world_grid()
+{
+	// All mappings have to be released before the store is closed
+	m_Chunks.clear();
+}
+
+auto world_grid::chunk_of(const world_position& p_pos)
+	-> chunk_position
+{
+	// Arithmetic shift rounds towards negative infinity, which is required
+	// for negative positions
+	return chunk_position{ p_pos.x >> world_chunk::chunk_shift, p_pos.y >> world_chunk::chunk_shift };
+}
+
+auto world_grid::chunk_origin(const chunk_position& p_chunk)
+	-> world_position
+{
+	return p_chunk * world_chunk::chunk_size;
+}
+
+auto world_grid::cell_index(const world_position& p_pos)
+	-> size_type
+{
+	constexpr auto t_mask = world_chunk::chunk_size - 1;
+	
+	return static_cast<size_type>((p_pos.y & t_mask) * world_chunk::chunk_size + (p_pos.x & t_mask));
+}
+
+auto world_grid::read_cell(const world_position& p_pos) const
+	-> const cell&
+{
+	static const cell t_empty{ };
+	
+	const auto* t_chunk = chunk(chunk_of(p_pos));
+	
+	return t_chunk ? t_chunk->cells()[cell_index(p_pos)] : t_empty;
+}
+
+auto world_grid::modify_cell(const world_position& p_pos)
+	-> cell&
+{
+	return modify_chunk(chunk_of(p_pos)).cells()[cell_index(p_pos)];
+}
+
+auto world_grid::set_cell(const world_position& p_pos, const cell& p_cell)
+	-> void
+{
+	modify_cell(p_pos) = p_cell;
+}
+
+auto world_grid::clear_cell(const world_position& p_pos)
+	-> void
+{
+	// Clearing a cell of a chunk that does not exist does not allocate it
+	if(m_Chunks.count(chunk_of(p_pos)))
+		modify_cell(p_pos) = cell{ };
+}
+
+auto world_grid::clear()
+	-> void
+{
+	m_Chunks.clear();
+	m_LRU.clear();
+	
+	if(m_Store)
+		m_Store->reset();
+}
+
+auto world_grid::page_in(const chunk_position& p_pos, const chunk_entry& p_entry) const
+	-> world_chunk&
+{
+	// Chunks of worlds without store are always resident
+	if(!m_Store)
+		return *p_entry.m_Chunk;
+	
+	if(p_entry.m_Chunk)
+	{
+		// Mark as most recently used
+		m_LRU.splice(m_LRU.begin(), m_LRU, p_entry.m_Use);
+		return *p_entry.m_Chunk;
+	}
+	
+	p_entry.m_Chunk = ::std::make_unique<world_chunk>(m_Store->map(*p_entry.m_Record));
+	m_LRU.push_front(p_pos);
+	p_entry.m_Use = m_LRU.begin();
+	
+	evict();
+	
+	return *p_entry.m_Chunk;
+}
+
+auto world_grid::evict() const
+	-> void
+{
+	while(m_LRU.size() > m_ResidentLimit)
+	{
+		auto& t_entry = m_Chunks.at(m_LRU.back());
+		
+		// Unmapping releases the memory, the cells stay in the store
+		t_entry.m_Chunk.reset();
+		m_LRU.pop_back();
+	}
+}
+
+auto world_grid::chunk(const chunk_position& p_chunk) const
+	-> const world_chunk*
+{
+	const auto t_it = m_Chunks.find(p_chunk);
+	
+	return (t_it != m_Chunks.end()) ? &page_in(p_chunk, t_it->second) : nullptr;
+}
+
+auto world_grid::modify_chunk(const chunk_position& p_chunk)
+	-> world_chunk&
+{
+	auto [t_it, t_created] = m_Chunks.try_emplace(p_chunk);
+	auto& t_entry = t_it->second;
+	
+	if(t_created)
+	{
+		if(m_Store)
+			t_entry.m_Record = m_Store->allocate(p_chunk);
+		else
+			t_entry.m_Chunk = ::std::make_unique<world_chunk>();
+	}
+	
+	// Revisions are unique across all chunks, so a chunk that was removed
+	// and allocated again is never mistaken for its old contents
+	t_entry.m_Revision = ++m_Revision;
+	
+	return page_in(p_chunk, t_entry);
+}
+
+auto world_grid::revision(const chunk_position& p_chunk) const
+	-> revision_type
+{
+	const auto t_it = m_Chunks.find(p_chunk);
+	
+	return (t_it != m_Chunks.end()) ? t_it->second.m_Revision : 0U;
+}
+
+auto world_grid::chunk_count() const
+	-> size_type
+{
+	return m_Chunks.size();
+}
+
+auto world_grid::resident_count() const
+	-> size_type
+{
+	return m_Store ? m_LRU.size() : m_Chunks.size();
+}
+
+auto world_grid::is_persistent() const
+	-> bool
+{
+	return static_cast<bool>(m_Store);
+}
+
+auto world_grid::flush()
+	-> void
+{
+	if(m_Store)
+		m_Store->flush();
+}
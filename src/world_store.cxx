@@ -0,0 +1,187 @@
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <ut/throwf.hxx>
+#include <log.hxx>
+#include <world_store.hxx>
+
+namespace bip = boost::interprocess;
+
+static_assert(::std::is_trivially_copyable_v<cell>, "cell needs to be trivially copyable");
+static_assert(::std::is_trivially_copyable_v<internal::world_index_header>,
+	"world_index_header needs to be trivially copyable");
+
+world_store::world_store(const path_type& p_path)
+	:	m_DataPath{ p_path },
+		m_IndexPath{ p_path }
+{
+	m_DataPath += ".chunks";
+	m_IndexPath += ".index";
+	
+	const auto t_dir = p_path.parent_path();
+	
+	if(!t_dir.empty() && !boost::filesystem::exists(t_dir))
+		boost::filesystem::create_directories(t_dir);
+	
+	// Create empty data file if needed, file mappings require an existing file
+	if(!boost::filesystem::exists(m_DataPath))
+		::std::ofstream{ m_DataPath.string(), ::std::ios::binary };
+	
+	read_index();
+	
+	// Records beyond the index are left over from a session that did not flush.
+	// They are simply reused.
+	m_Capacity = static_cast<size_type>(boost::filesystem::file_size(m_DataPath)) / record_size;
+	
+	if(m_Capacity < m_Chunks.size())
+	{
+		LOG_W_TAG("world_store") << "data file \"" << m_DataPath.string() << "\" is truncated, discarding index";
+		m_Chunks.clear();
+	}
+	
+	m_File = ::std::make_unique<bip::file_mapping>(m_DataPath.string().c_str(), bip::read_write);
+	
+	LOG_D_TAG("world_store") << "opened world \"" << p_path.string() << "\" with " << m_Chunks.size() << " chunks";
+}
+
+world_store::~world_store()
+{
+	try
+	{
+		flush();
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		LOG_E_TAG("world_store") << "failed to write index: " << p_ex.what();
+	}
+}
+
+auto world_store::read_index()
+	-> void
+{
+	::std::ifstream t_file{ m_IndexPath.string(), ::std::ios::binary };
+	
+	if(!t_file)
+		return;
+	
+	internal::world_index_header t_header{ };
+	t_file.read(reinterpret_cast<char*>(&t_header), sizeof(t_header));
+	
+	if(!t_file || t_header.m_Magic != magic || t_header.m_Version != version
+		|| t_header.m_ChunkSize != static_cast<::std::uint32_t>(world_chunk::chunk_size))
+	{
+		LOG_W_TAG("world_store") << "ignoring invalid index \"" << m_IndexPath.string() << "\"";
+		return;
+	}
+	
+	::std::vector<internal::world_index_entry> t_entries(static_cast<size_type>(t_header.m_ChunkCount));
+	t_file.read(reinterpret_cast<char*>(t_entries.data()),
+		static_cast<::std::streamsize>(t_entries.size() * sizeof(internal::world_index_entry)));
+	
+	if(!t_file)
+	{
+		LOG_W_TAG("world_store") << "ignoring truncated index \"" << m_IndexPath.string() << "\"";
+		return;
+	}
+	
+	m_Chunks.reserve(t_entries.size());
+	
+	for(const auto& t_entry: t_entries)
+		m_Chunks.emplace_back(t_entry.m_X, t_entry.m_Y);
+}
+
+auto world_store::chunks() const
+	-> const ::std::vector<chunk_position>&
+{
+	return m_Chunks;
+}
+
+auto world_store::reserve(size_type p_count)
+	-> void
+{
+	if(p_count <= m_Capacity)
+		return;
+	
+	// Grow geometrically to avoid resizing the file for every new chunk
+	const auto t_capacity = ::std::max<size_type>(p_count, ::std::max<size_type>(m_Capacity * 2U, 64U));
+	
+	boost::filesystem::resize_file(m_DataPath, t_capacity * record_size);
+	m_Capacity = t_capacity;
+}
+
+auto world_store::allocate(const chunk_position& p_chunk)
+	-> size_type
+{
+	const auto t_record = m_Chunks.size();
+	
+	reserve(t_record + 1U);
+	
+	m_Chunks.push_back(p_chunk);
+	m_Dirty = true;
+	
+	// Records might contain data of chunks that were never added to the index
+	auto t_region = map(t_record);
+	::std::memset(t_region->get_address(), 0, record_size);
+	
+	return t_record;
+}
+
+auto world_store::map(size_type p_record)
+	-> ::std::unique_ptr<region_type>
+{
+	if(p_record >= m_Chunks.size())
+		ut::throwf<::std::runtime_error>("world_store: record %zu out of range", p_record);
+	
+	return ::std::make_unique<bip::mapped_region>(*m_File, bip::read_write,
+		static_cast<bip::offset_t>(p_record * record_size), record_size);
+}
+
+auto world_store::reset()
+	-> void
+{
+	m_Chunks.clear();
+	m_Dirty = true;
+}
+
+auto world_store::flush()
+	-> void
+{
+	if(!m_Dirty)
+		return;
+	
+	auto t_tmpPath = m_IndexPath;
+	t_tmpPath += ".tmp";
+	
+	{
+		::std::ofstream t_file{ t_tmpPath.string(), ::std::ios::binary | ::std::ios::trunc };
+		
+		if(!t_file)
+			ut::throwf<::std::runtime_error>("world_store: could not open \"%s\" for writing", t_tmpPath.string());
+		
+		internal::world_index_header t_header{ };
+		t_header.m_Magic = magic;
+		t_header.m_Version = version;
+		t_header.m_ChunkSize = static_cast<::std::uint32_t>(world_chunk::chunk_size);
+		t_header.m_ChunkCount = m_Chunks.size();
+		
+		t_file.write(reinterpret_cast<const char*>(&t_header), sizeof(t_header));
+		
+		for(const auto& t_chunk: m_Chunks)
+		{
+			const internal::world_index_entry t_entry{ t_chunk.x, t_chunk.y };
+			t_file.write(reinterpret_cast<const char*>(&t_entry), sizeof(t_entry));
+		}
+		
+		if(!t_file)
+			ut::throwf<::std::runtime_error>("world_store: failed to write \"%s\"", t_tmpPath.string());
+	}
+	
+	// Replace old index atomically, so a crash never leaves a partial index
+	boost::filesystem::rename(t_tmpPath, m_IndexPath);
+	
+	m_Dirty = false;
+}
@@ -0,0 +1,275 @@
+#include <stdexcept>
+#include <ut/throwf.hxx>
+#include <log.hxx>
+#include <world_viewport.hxx>
+#include <gpu_stats.hxx>
+
+// Helpers only used in this file
+namespace
+{
+	// Floor modulo, since chunk positions may be negative
+	auto wrap_chunk(int p_value, int p_modulus)
+		-> int
+	{
+		const auto t_rem = p_value % p_modulus;
+	
+		return (t_rem < 0) ? (t_rem + p_modulus) : t_rem;
+	}
+}
+
+world_viewport::world_viewport(::std::shared_ptr<world_grid> p_world, const dimension_type& p_dims)
+	:	m_World{ ::std::move(p_world) },
+		m_Dims{ p_dims }
+{
+	if(!m_World)
+		throw ::std::runtime_error("world_viewport: no world supplied");
+	
+	if(p_dims.x == 0U || p_dims.y == 0U)
+		ut::throwf<::std::runtime_error>("world_viewport: invalid viewport dimensions (%u, %u)", p_dims.x, p_dims.y);
+	
+	// A viewport that is not aligned to chunk borders touches one more chunk
+	// in each direction than it would need if it were aligned
+	const auto t_chunks = (glm::ivec2{ p_dims } + (world_chunk::chunk_size - 1)) / world_chunk::chunk_size;
+	m_Ring = t_chunks + 1;
+	
+	m_Slots.resize(static_cast<size_type>(m_Ring.x) * m_Ring.y);
+	
+	const auto t_bytes = m_Slots.size() * world_chunk::cell_count * sizeof(cell);
+	
+	LOG_D_TAG("world_viewport") << "creating viewport with dimensions (" << p_dims.x << ", " << p_dims.y
+		<< ") and chunk ring (" << m_Ring.x << ", " << m_Ring.y << "), " << t_bytes << " bytes";
+}
+
+auto world_viewport::create_buffer()
+	-> void
+{
+	const auto t_bytes = m_Slots.size() * world_chunk::cell_count * sizeof(cell);
+	
+	glActiveTexture(GL_TEXTURE3);
+	glGenTextures(1, &m_GPUTexture);
+	glGenBuffers(1, &m_GPUBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_GPUBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, t_bytes, nullptr, GL_DYNAMIC_DRAW);
+	glBindTexture(GL_TEXTURE_BUFFER, m_GPUTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, m_GPUBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+world_viewport::~world_viewport()
+{
+	if(m_GPUTexture)
+		glDeleteTextures(1, &m_GPUTexture);
+	
+	if(m_GPUBuffer)
+		glDeleteBuffers(1, &m_GPUBuffer);
+}
+
+auto world_viewport::slot_index(const chunk_position& p_chunk) const
+	-> size_type
+{
+	return static_cast<size_type>(wrap_chunk(p_chunk.y, m_Ring.y) * m_Ring.x + wrap_chunk(p_chunk.x, m_Ring.x));
+}
+
+auto world_viewport::upload(size_type p_slot, const chunk_position& p_chunk)
+	-> void
+{
+	// Chunks that do not exist are uploaded as empty cells
+	static const world_chunk::container_type t_empty{ };
+	
+	const auto* t_chunk = m_World->chunk(p_chunk);
+	const auto& t_cells = t_chunk ? t_chunk->cells() : t_empty;
+	
+	constexpr auto t_chunkBytes = world_chunk::cell_count * sizeof(cell);
+	
+	glBufferSubData(GL_TEXTURE_BUFFER, p_slot * t_chunkBytes, t_chunkBytes, static_cast<const GLvoid*>(t_cells.data()));
+	gpu_stats::record_upload(t_chunkBytes);
+	
+	auto& t_slot = m_Slots[p_slot];
+	t_slot.m_Chunk = p_chunk;
+	t_slot.m_Revision = m_World->revision(p_chunk);
+	t_slot.m_Contents = screen_contents{ false, false, false };
+	
+	for(const auto& t_cell: t_cells)
+		accumulate_contents(t_slot.m_Contents, t_cell);
+	
+	++m_Uploads;
+}
+
+auto world_viewport::sync()
+	-> void
+{
+	const auto t_first = world_grid::chunk_of(m_Position);
+	const auto t_last = world_grid::chunk_of(m_Position + world_position{ m_Dims } - 1);
+	
+	if(!m_GPUBuffer)
+		create_buffer();
+	
+	screen_contents t_contents{ false, false, false };
+	bool t_bound{ false };
+	
+	for(auto t_y = t_first.y; t_y <= t_last.y; ++t_y)
+	{
+		for(auto t_x = t_first.x; t_x <= t_last.x; ++t_x)
+		{
+			const chunk_position t_chunk{ t_x, t_y };
+			const auto t_ix = slot_index(t_chunk);
+			const auto& t_slot = m_Slots[t_ix];
+			
+			// Only upload chunks that were not visible before or were modified
+			if(t_slot.m_Chunk != t_chunk || t_slot.m_Revision != m_World->revision(t_chunk))
+			{
+				if(!t_bound)
+				{
+					glBindBuffer(GL_TEXTURE_BUFFER, m_GPUBuffer);
+					t_bound = true;
+				}
+				
+				upload(t_ix, t_chunk);
+			}
+			
+			t_contents.m_HasShadows |= t_slot.m_Contents.m_HasShadows;
+			t_contents.m_HasFog |= t_slot.m_Contents.m_HasFog;
+			t_contents.m_HasLitCells |= t_slot.m_Contents.m_HasLitCells;
+		}
+	}
+	
+	if(t_bound)
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	
+	m_Contents = t_contents;
+}
+
+auto world_viewport::use() const
+	-> void
+{
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_BUFFER, m_GPUTexture);
+}
+
+auto world_viewport::scroll_to(const world_position& p_pos)
+	-> void
+{
+	m_Position = p_pos;
+}
+
+auto world_viewport::scroll(const world_position& p_delta)
+	-> void
+{
+	m_Position += p_delta;
+}
+
+auto world_viewport::position() const
+	-> const world_position&
+{
+	return m_Position;
+}
+
+auto world_viewport::size() const
+	-> const dimension_type&
+{
+	return m_Dims;
+}
+
+auto world_viewport::ring_size() const
+	-> const ring_type&
+{
+	return m_Ring;
+}
+
+auto world_viewport::world()
+	-> world_grid&
+{
+	return *m_World;
+}
+
+auto world_viewport::world() const
+	-> const world_grid&
+{
+	return *m_World;
+}
+
+auto world_viewport::contents() const
+	-> const screen_contents&
+{
+	return m_Contents;
+}
+
+auto world_viewport::uploaded_chunks() const
+	-> size_type
+{
+	return m_Uploads;
+}
+
+auto world_viewport::copy_cells(cell* p_dest, screen_contents& p_contents)
+	-> void
+{
+	static const world_chunk::container_type t_empty{ };
+	
+	const auto t_first = world_grid::chunk_of(m_Position);
+	const auto t_last = world_grid::chunk_of(m_Position + world_position{ m_Dims } - 1);
+	const auto t_end = m_Position + world_position{ m_Dims };
+	
+	// Copy the visible part of every chunk one row segment at a time
+	for(auto t_y = t_first.y; t_y <= t_last.y; ++t_y)
+	{
+		for(auto t_x = t_first.x; t_x <= t_last.x; ++t_x)
+		{
+			const chunk_position t_chunk{ t_x, t_y };
+			const auto* t_data = m_World->chunk(t_chunk);
+			const auto& t_cells = t_data ? t_data->cells() : t_empty;
+			
+			const auto t_origin = world_grid::chunk_origin(t_chunk);
+			const auto t_min = glm::max(t_origin, m_Position);
+			const auto t_max = glm::min(t_origin + world_chunk::chunk_size, t_end);
+			
+			for(auto t_row = t_min.y; t_row < t_max.y; ++t_row)
+			{
+				const auto* t_src = &t_cells[(t_row - t_origin.y) * world_chunk::chunk_size + (t_min.x - t_origin.x)];
+				auto* t_dst = p_dest + (static_cast<size_type>(t_row - m_Position.y) * m_Dims.x + (t_min.x - m_Position.x));
+				
+				for(auto t_ix = 0; t_ix < (t_max.x - t_min.x); ++t_ix)
+				{
+					t_dst[t_ix] = t_src[t_ix];
+					accumulate_contents(p_contents, t_src[t_ix]);
+				}
+			}
+		}
+	}
+}
+
+auto world_viewport::content_revision()
+	-> revision_type
+{
+	const auto t_first = world_grid::chunk_of(m_Position);
+	const auto t_last = world_grid::chunk_of(m_Position + world_position{ m_Dims } - 1);
+	
+	bool t_changed{ m_Position != m_RevisionPosition };
+	size_type t_ix{ };
+	
+	for(auto t_y = t_first.y; t_y <= t_last.y; ++t_y)
+	{
+		for(auto t_x = t_first.x; t_x <= t_last.x; ++t_x, ++t_ix)
+		{
+			const auto t_revision = m_World->revision(chunk_position{ t_x, t_y });
+			
+			if(t_ix >= m_ChunkRevisions.size())
+			{
+				m_ChunkRevisions.push_back(t_revision);
+				t_changed = true;
+			}
+			else if(m_ChunkRevisions[t_ix] != t_revision)
+			{
+				m_ChunkRevisions[t_ix] = t_revision;
+				t_changed = true;
+			}
+		}
+	}
+	
+	m_ChunkRevisions.resize(t_ix);
+	m_RevisionPosition = m_Position;
+	
+	if(t_changed)
+		++m_Revision;
+	
+	return m_Revision;
+}
@@ -0,0 +1,335 @@
+// End-to-end rendering benchmark. Generates a scene using the debug scene
+// generator, renders a number of frames and reports frame time percentiles
+// and the amount of data uploaded to the GPU.
+//
+// Usage: render_bench [options]
+//
+//	--frames <n>		Number of measured frames (default 500)
+//	--warmup <n>		Number of frames rendered before measuring (default 50)
+//	--size <w>x<h>		Size of the scene layer in glyphs. Default is the screen size.
+//	--fill <ratio>		Fraction of non-empty cells (default 0.8)
+//	--lights <n>		Number of dynamic lights (default 8)
+//	--shadows <ratio>	Fraction of non-empty cells with drop shadows (default 0.25)
+//	--gui <ratio>		Fraction of the scene covered by a GUI panel (default 0.2)
+//	--dirty <ratio>		Fraction of scene cells modified every frame (default 0)
+//	--seed <n>			Seed of the scene generator (default 1)
+//	--hardware			Use the default GL driver instead of forcing software rendering
+//	--csv				Print results as CSV
+//
+// Software rendering is requested from Mesa using LIBGL_ALWAYS_SOFTWARE, so
+// results do not depend on the GPU of the machine. The window is hidden, but
+// GLFW still needs a display; on machines without one, run the benchmark
+// using a virtual framebuffer like `xvfb-run`.
+//
+// CPU times are measured around render_manager::render, and around the whole
+// frame including clearing and presenting it. GPU times are measured using
+// timer queries around clearing and rendering.
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <engine.hxx>
+#include <global_state.hxx>
+#include <gpu_stats.hxx>
+#include <capi/debug.h>
+#include <capi/engine.h>
+
+namespace
+{
+	using clock_type = ::std::chrono::steady_clock;
+	
+	struct options
+	{
+		unsigned m_Frames{ 500U };
+		unsigned m_Warmup{ 50U };
+		scene_params_t m_Scene{ { 0U, 0U }, 0.8f, 8, 0.25f, 0.2f, 1U };
+		float m_Dirty{ 0.f };
+		bool m_Hardware{ false };
+		bool m_Csv{ false };
+	};
+	
+	// Measurements of a single frame
+	struct frame_sample
+	{
+		double m_Render;			//< CPU time spent in render(), in ms
+		double m_Frame;				//< CPU time of the whole frame, in ms
+		double m_GPU;				//< GPU time, in ms
+		::std::uint64_t m_Uploaded;	//< Bytes uploaded during the frame
+	};
+	
+	auto parse(int p_argc, char** p_argv)
+		-> options
+	{
+		options t_options{ };
+		
+		for(int t_ix = 1; t_ix < p_argc; ++t_ix)
+		{
+			const ::std::string t_arg{ p_argv[t_ix] };
+			
+			const auto t_value = [&]() -> const char*
+			{
+				if(t_ix + 1 >= p_argc)
+					throw ::std::runtime_error("missing value for \"" + t_arg + "\"");
+				
+				return p_argv[++t_ix];
+			};
+			
+			if(t_arg == "--frames")
+				t_options.m_Frames = ::std::max(1UL, ::std::strtoul(t_value(), nullptr, 10));
+			else if(t_arg == "--warmup")
+				t_options.m_Warmup = ::std::strtoul(t_value(), nullptr, 10);
+			else if(t_arg == "--size")
+			{
+				const ::std::string t_size{ t_value() };
+				const auto t_sep = t_size.find('x');
+				
+				if(t_sep == ::std::string::npos)
+					throw ::std::runtime_error("invalid scene size \"" + t_size + "\", expected <w>x<h>");
+				
+				t_options.m_Scene.size.x = ::std::strtoul(t_size.substr(0, t_sep).c_str(), nullptr, 10);
+				t_options.m_Scene.size.y = ::std::strtoul(t_size.substr(t_sep + 1).c_str(), nullptr, 10);
+			}
+			else if(t_arg == "--fill")
+				t_options.m_Scene.fillRatio = ::std::strtof(t_value(), nullptr);
+			else if(t_arg == "--lights")
+				t_options.m_Scene.lightCount = ::std::atoi(t_value());
+			else if(t_arg == "--shadows")
+				t_options.m_Scene.shadowDensity = ::std::strtof(t_value(), nullptr);
+			else if(t_arg == "--gui")
+				t_options.m_Scene.guiCoverage = ::std::strtof(t_value(), nullptr);
+			else if(t_arg == "--dirty")
+				t_options.m_Dirty = ::std::clamp(::std::strtof(t_value(), nullptr), 0.f, 1.f);
+			else if(t_arg == "--seed")
+				t_options.m_Scene.seed = ::std::strtoul(t_value(), nullptr, 10);
+			else if(t_arg == "--hardware")
+				t_options.m_Hardware = true;
+			else if(t_arg == "--csv")
+				t_options.m_Csv = true;
+			else
+				throw ::std::runtime_error("unknown argument \"" + t_arg + "\"");
+		}
+		
+		return t_options;
+	}
+	
+	auto milliseconds(clock_type::duration p_duration)
+		-> double
+	{
+		return ::std::chrono::duration<double, ::std::milli>{ p_duration }.count();
+	}
+	
+	// Nearest-rank percentile of given sorted values
+	auto percentile(const ::std::vector<double>& p_sorted, double p_percent)
+		-> double
+	{
+		const auto t_rank = static_cast<::std::size_t>(::std::ceil(p_percent / 100.0 * p_sorted.size()));
+		return p_sorted[::std::clamp<::std::size_t>(t_rank, 1U, p_sorted.size()) - 1U];
+	}
+	
+	auto report(const char* p_name, ::std::vector<double> p_values, bool p_csv)
+		-> void
+	{
+		::std::sort(p_values.begin(), p_values.end());
+		
+		const auto t_mean = ::std::accumulate(p_values.begin(), p_values.end(), 0.0) / p_values.size();
+		
+		if(p_csv)
+		{
+			::std::printf("%s,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", p_name, t_mean, percentile(p_values, 50.0),
+				percentile(p_values, 90.0), percentile(p_values, 99.0), p_values.front(), p_values.back());
+		}
+		else
+		{
+			::std::printf("%-12s %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f\n", p_name, t_mean, percentile(p_values, 50.0),
+				percentile(p_values, 90.0), percentile(p_values, 99.0), p_values.front(), p_values.back());
+		}
+	}
+	
+	// Modify given fraction of the cells of the scene layer, to measure the
+	// cost of uploading changed layers
+	class scene_mutator
+	{
+		public:
+			scene_mutator(screen_manager& p_screen, float p_ratio)
+				:	m_Screen{p_screen},
+					m_Count{ static_cast<::std::size_t>(p_ratio * p_screen.screen_size().x * p_screen.screen_size().y) }
+			{
+			}
+		
+		public:
+			auto apply()
+				-> void
+			{
+				if(m_Count == 0U)
+					return;
+				
+				const auto t_dims = m_Screen.screen_size();
+				::std::uniform_int_distribution<unsigned> t_x{ 0U, t_dims.x - 1U };
+				::std::uniform_int_distribution<unsigned> t_y{ 0U, t_dims.y - 1U };
+				::std::uniform_int_distribution<unsigned> t_glyph{ 33U, 126U };
+				
+				for(::std::size_t t_ix = 0; t_ix < m_Count; ++t_ix)
+					m_Screen.modify_cell({ t_x(m_Gen), t_y(m_Gen) }).set_glyph(static_cast<cell::glyph_type>(t_glyph(m_Gen)));
+			}
+		
+		private:
+			screen_manager& m_Screen;
+			::std::size_t m_Count;
+			::std::mt19937 m_Gen{ 42U };
+	};
+	
+	auto run(const options& p_options)
+		-> void
+	{
+		auto& t_context = global_state<render_context>();
+		auto& t_renderer = global_state<render_manager>();
+		
+		// Presenting must not wait for the display
+		glfwHideWindow(t_context.handle());
+		glfwSwapInterval(0);
+		
+		// Timer queries have to be issued on the thread owning the context. The
+		// render thread is only started by the first frame, so it has to be
+		// stopped again after it.
+		if(t_renderer.is_threaded())
+		{
+			t_renderer.render();
+			t_renderer.stop_render_thread();
+		}
+		
+		auto t_params = p_options.m_Scene;
+		const auto t_layer = debug_create_scene(&t_params);
+		scene_mutator t_mutator{ t_renderer.layer(t_layer), p_options.m_Dirty };
+		
+		::std::vector<GLuint> t_queries(p_options.m_Frames);
+		glGenQueries(static_cast<GLsizei>(t_queries.size()), t_queries.data());
+		
+		::std::vector<frame_sample> t_samples{ };
+		t_samples.reserve(p_options.m_Frames);
+		
+		for(unsigned t_frame = 0; t_frame < p_options.m_Warmup + p_options.m_Frames; ++t_frame)
+		{
+			const bool t_measured = (t_frame >= p_options.m_Warmup);
+			
+			t_mutator.apply();
+			
+			const auto t_uploaded = gpu_stats::uploaded_bytes();
+			const auto t_begin = clock_type::now();
+			
+			if(t_measured)
+				glBeginQuery(GL_TIME_ELAPSED, t_queries[t_frame - p_options.m_Warmup]);
+			
+			t_context.begin_frame();
+			
+			const auto t_renderBegin = clock_type::now();
+			t_renderer.render();
+			const auto t_renderEnd = clock_type::now();
+			
+			if(t_measured)
+				glEndQuery(GL_TIME_ELAPSED);
+			
+			t_context.end_frame();
+			glfwPollEvents();
+			
+			const auto t_end = clock_type::now();
+			
+			if(t_measured)
+			{
+				t_samples.push_back(frame_sample{
+					milliseconds(t_renderEnd - t_renderBegin),
+					milliseconds(t_end - t_begin),
+					0.0,
+					gpu_stats::uploaded_bytes() - t_uploaded
+				});
+			}
+		}
+		
+		// Results are only read at the end to not stall the pipeline
+		for(::std::size_t t_ix = 0; t_ix < t_queries.size(); ++t_ix)
+		{
+			GLuint64 t_elapsed{ };
+			glGetQueryObjectui64v(t_queries[t_ix], GL_QUERY_RESULT, &t_elapsed);
+			
+			t_samples[t_ix].m_GPU = t_elapsed / 1e6;
+		}
+		
+		glDeleteQueries(static_cast<GLsizei>(t_queries.size()), t_queries.data());
+		
+		// Report
+		const auto t_dims = t_renderer.layer(t_layer).screen_size();
+		const auto t_extract = [&t_samples](double frame_sample::* p_member)
+		{
+			::std::vector<double> t_values{ };
+			
+			for(const auto& t_sample: t_samples)
+				t_values.push_back(t_sample.*p_member);
+			
+			return t_values;
+		};
+		
+		::std::uint64_t t_total{ 0U };
+		
+		for(const auto& t_sample: t_samples)
+			t_total += t_sample.m_Uploaded;
+		
+		if(!p_options.m_Csv)
+		{
+			::std::printf("renderer:  %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+			::std::printf("scene:     %ux%u, fill %.2f, %d lights, shadows %.2f, gui %.2f, dirty %.2f, seed %u\n",
+				t_dims.x, t_dims.y, t_params.fillRatio, t_params.lightCount, t_params.shadowDensity,
+				t_params.guiCoverage, p_options.m_Dirty, t_params.seed);
+			::std::printf("frames:    %u measured, %u warmup\n", p_options.m_Frames, p_options.m_Warmup);
+			::std::printf("uploaded:  %.1f bytes/frame, %llu bytes total\n\n",
+				static_cast<double>(t_total) / t_samples.size(), static_cast<unsigned long long>(t_total));
+			::std::printf("%-12s %10s %10s %10s %10s %10s %10s\n", "time [ms]", "mean", "p50", "p90", "p99", "min", "max");
+		}
+		else
+			::std::printf("metric,mean,p50,p90,p99,min,max\n");
+		
+		report("cpu_render", t_extract(&frame_sample::m_Render), p_options.m_Csv);
+		report("cpu_frame", t_extract(&frame_sample::m_Frame), p_options.m_Csv);
+		report("gpu", t_extract(&frame_sample::m_GPU), p_options.m_Csv);
+		
+		if(p_options.m_Csv)
+			::std::printf("uploaded_bytes,%.1f,,,,,\n", static_cast<double>(t_total) / t_samples.size());
+		
+		debug_destroy_scene();
+	}
+}
+
+int main(int p_argc, char** p_argv)
+{
+	try
+	{
+		const auto t_options = parse(p_argc, p_argv);
+		
+		// Has to be set before the GL driver is loaded
+		if(!t_options.m_Hardware)
+			setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+		
+		// The benchmark options are not meant for the engine command line handler.
+		// Using a separate game name keeps the benchmark configuration apart from
+		// the configuration of actual games.
+		const char* t_argv[] = { p_argv[0] };
+		
+		engine::initialize(game_info{ "render-bench", "1.0", "Rendering benchmark", "render_bench" }, 1, t_argv);
+		
+		run(t_options);
+		
+		engine_deinitialize();
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		::std::fprintf(stderr, "render_bench: %s\n", p_ex.what());
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}
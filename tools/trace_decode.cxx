@@ -0,0 +1,289 @@
+// Offline decoder for binary trace files written by trace_log.
+//
+// Usage: trace_decode <file>...
+//
+// Files of a rotated set may be given in any order, they are decoded in the
+// order they were written in.
+
+#include <ctime>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <trace_format.hxx>
+
+namespace
+{
+	struct trace_file
+	{
+		::std::string m_Path;
+		trace_format::file_header m_Header;
+		::std::vector<::std::uint8_t> m_Data;
+	};
+	
+	auto level_name(trace_format::level p_level)
+		-> const char*
+	{
+		switch(p_level)
+		{
+			case trace_format::level::fatal:
+				return "fatal";
+			case trace_format::level::error:
+				return "error";
+			case trace_format::level::warning:
+				return "warning";
+			case trace_format::level::info:
+				return "info";
+			case trace_format::level::debug:
+				return "debug";
+			default:
+				return "unknown";
+		}
+	}
+	
+	auto load(const ::std::string& p_path)
+		-> trace_file
+	{
+		::std::ifstream t_in{ p_path, ::std::ios::binary };
+		
+		if(!t_in)
+			throw ::std::runtime_error("could not open \"" + p_path + "\"");
+		
+		trace_file t_file{ p_path, { }, { ::std::istreambuf_iterator<char>{ t_in }, ::std::istreambuf_iterator<char>{ } } };
+		
+		if(t_file.m_Data.size() < sizeof(trace_format::file_header))
+			throw ::std::runtime_error("\"" + p_path + "\" is too small to be a trace file");
+		
+		::std::memcpy(&t_file.m_Header, t_file.m_Data.data(), sizeof(trace_format::file_header));
+		
+		if(t_file.m_Header.m_Magic != trace_format::magic)
+			throw ::std::runtime_error("\"" + p_path + "\" is not a trace file");
+		
+		if(t_file.m_Header.m_Version != trace_format::version)
+			throw ::std::runtime_error("\"" + p_path + "\" has unsupported version " + ::std::to_string(t_file.m_Header.m_Version));
+		
+		return t_file;
+	}
+	
+	// Reads arguments from an event payload
+	class argument_reader
+	{
+		public:
+			argument_reader(const ::std::uint8_t* p_data, ::std::size_t p_size)
+				: m_Data{p_data}, m_Size{p_size}
+			{
+			}
+		
+		public:
+			auto empty() const
+				-> bool
+			{
+				return m_Offset >= m_Size;
+			}
+			
+			auto next()
+				-> ::std::string
+			{
+				const auto t_type = static_cast<trace_format::argument_type>(m_Data[m_Offset++]);
+				
+				switch(t_type)
+				{
+					case trace_format::argument_type::signed_integer:
+						return ::std::to_string(read<::std::int64_t>());
+					case trace_format::argument_type::unsigned_integer:
+						return ::std::to_string(read<::std::uint64_t>());
+					case trace_format::argument_type::floating_point:
+					{
+						char t_buf[64];
+						::std::snprintf(t_buf, sizeof(t_buf), "%g", read<double>());
+						return t_buf;
+					}
+					case trace_format::argument_type::boolean:
+						return read<::std::uint8_t>() ? "true" : "false";
+					case trace_format::argument_type::string:
+					{
+						const auto t_length = read<::std::uint16_t>();
+						check(t_length);
+						
+						::std::string t_str{ reinterpret_cast<const char*>(m_Data + m_Offset), t_length };
+						m_Offset += t_length;
+						return t_str;
+					}
+					default:
+						throw ::std::runtime_error("invalid argument type " + ::std::to_string(static_cast<unsigned>(t_type)));
+				}
+			}
+		
+		private:
+			auto check(::std::size_t p_size) const
+				-> void
+			{
+				if(m_Offset + p_size > m_Size)
+					throw ::std::runtime_error("truncated event arguments");
+			}
+			
+			template< typename T >
+			auto read()
+				-> T
+			{
+				check(sizeof(T));
+				
+				T t_value{ };
+				::std::memcpy(&t_value, m_Data + m_Offset, sizeof(T));
+				m_Offset += sizeof(T);
+				return t_value;
+			}
+		
+		private:
+			const ::std::uint8_t* m_Data;
+			::std::size_t m_Size;
+			::std::size_t m_Offset{0U};
+	};
+	
+	// Replace placeholders in format string with the event arguments. Surplus
+	// arguments are appended.
+	auto format_event(const ::std::string& p_format, argument_reader& p_args)
+		-> ::std::string
+	{
+		::std::string t_out{ };
+		::std::size_t t_pos{ 0U };
+		
+		while(true)
+		{
+			const auto t_next = p_format.find("{}", t_pos);
+			
+			if(t_next == ::std::string::npos)
+				break;
+			
+			t_out.append(p_format, t_pos, t_next - t_pos);
+			t_out += p_args.empty() ? ::std::string{"{?}"} : p_args.next();
+			t_pos = t_next + 2U;
+		}
+		
+		t_out.append(p_format, t_pos, ::std::string::npos);
+		
+		while(!p_args.empty())
+			t_out += " " + p_args.next();
+		
+		return t_out;
+	}
+	
+	auto print_time(const trace_file& p_file, ::std::uint64_t p_timestamp)
+		-> void
+	{
+		const auto t_ns = p_file.m_Header.m_StartTime
+			+ static_cast<::std::int64_t>(p_timestamp - p_file.m_Header.m_StartTicks);
+		
+		const auto t_seconds = static_cast<::std::time_t>(t_ns / 1000000000LL);
+		const auto t_micros = static_cast<long>((t_ns % 1000000000LL) / 1000LL);
+		
+		char t_buf[32];
+		::std::strftime(t_buf, sizeof(t_buf), "%Y-%m-%d %H:%M:%S", ::std::localtime(&t_seconds));
+		::std::printf("%s.%06ld ", t_buf, t_micros);
+	}
+	
+	auto decode(const trace_file& p_file)
+		-> void
+	{
+		::std::unordered_map<::std::uint16_t, ::std::string> t_tags{ };
+		::std::unordered_map<::std::uint16_t, ::std::string> t_formats{ };
+		
+		const auto* t_data = p_file.m_Data.data();
+		auto t_offset = sizeof(trace_format::file_header);
+		
+		while(t_offset + sizeof(trace_format::record_header) <= p_file.m_Data.size())
+		{
+			trace_format::record_header t_header{ };
+			::std::memcpy(&t_header, t_data + t_offset, sizeof(t_header));
+			
+			if(t_header.m_Type == trace_format::record_type::end)
+				break;
+			
+			const auto* t_payload = t_data + t_offset + sizeof(t_header);
+			t_offset += trace_format::record_size(t_header.m_Size);
+			
+			if(t_offset > p_file.m_Data.size())
+			{
+				::std::fprintf(stderr, "trace_decode: \"%s\" ends with a truncated record\n", p_file.m_Path.c_str());
+				break;
+			}
+			
+			const ::std::string t_str{ reinterpret_cast<const char*>(t_payload), t_header.m_Size };
+			
+			switch(t_header.m_Type)
+			{
+				case trace_format::record_type::tag_definition:
+					t_tags[t_header.m_Tag] = t_str;
+					break;
+				case trace_format::record_type::format_definition:
+					t_formats[t_header.m_Format] = t_str;
+					break;
+				case trace_format::record_type::event:
+				{
+					argument_reader t_args{ t_payload, t_header.m_Size };
+					
+					print_time(p_file, t_header.m_Timestamp);
+					::std::printf("[%s] ", level_name(t_header.m_Level));
+					
+					if(const auto& t_tag = t_tags[t_header.m_Tag]; !t_tag.empty())
+						::std::printf("[%s] ", t_tag.c_str());
+					
+					try
+					{
+						::std::printf("%s\n", format_event(t_formats[t_header.m_Format], t_args).c_str());
+					}
+					catch(const ::std::exception& p_ex)
+					{
+						::std::printf("<%s>\n", p_ex.what());
+					}
+					
+					break;
+				}
+				default:
+					::std::fprintf(stderr, "trace_decode: skipping record of unknown type %u\n", static_cast<unsigned>(t_header.m_Type));
+					break;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		::std::fprintf(stderr, "usage: %s <file>...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	try
+	{
+		::std::vector<trace_file> t_files{ };
+		
+		for(int t_ix = 1; t_ix < argc; ++t_ix)
+			t_files.push_back(load(argv[t_ix]));
+		
+		::std::sort(t_files.begin(), t_files.end(), [](const auto& p_a, const auto& p_b)
+		{
+			const auto& t_a = p_a.m_Header;
+			const auto& t_b = p_b.m_Header;
+			
+			return (t_a.m_StartTime != t_b.m_StartTime) ? (t_a.m_StartTime < t_b.m_StartTime) : (t_a.m_Sequence < t_b.m_Sequence);
+		});
+		
+		for(const auto& t_file: t_files)
+			decode(t_file);
+	}
+	catch(const ::std::exception& p_ex)
+	{
+		::std::fprintf(stderr, "trace_decode: %s\n", p_ex.what());
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}